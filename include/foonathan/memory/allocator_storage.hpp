@@ -108,7 +108,8 @@ namespace foonathan { namespace memory
 
         /// @{
         /// \effects Calls the function on the stored allocator.
-        /// The \c Mutex will be locked during the operation.
+        /// The \c Mutex will be locked during the operation,
+        /// for the bulk functions only once for the entire batch.
         void* allocate_node(std::size_t size, std::size_t alignment)
         {
             std::lock_guard<actual_mutex> lock(*this);
@@ -138,6 +139,21 @@ namespace foonathan { namespace memory
             traits::deallocate_array(alloc, ptr, count, size, alignment);
         }
 
+        void allocate_node_bulk(std::size_t count, std::size_t size, std::size_t alignment, void **out)
+        {
+            std::lock_guard<actual_mutex> lock(*this);
+            auto&& alloc = get_allocator();
+            traits::allocate_node_bulk(alloc, count, size, alignment, out);
+        }
+
+        void deallocate_node_bulk(std::size_t count, std::size_t size, std::size_t alignment,
+                                  void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            std::lock_guard<actual_mutex> lock(*this);
+            auto&& alloc = get_allocator();
+            traits::deallocate_node_bulk(alloc, count, size, alignment, nodes);
+        }
+
         std::size_t max_node_size() const
         {
             std::lock_guard<actual_mutex> lock(*this);
@@ -158,6 +174,13 @@ namespace foonathan { namespace memory
             auto&& alloc = get_allocator();
             return traits::max_alignment(alloc);
         }
+
+        bool owns(const void *ptr) const
+        {
+            std::lock_guard<actual_mutex> lock(*this);
+            auto&& alloc = get_allocator();
+            return traits::owns(alloc, ptr);
+        }
         /// @}
 
         /// @{
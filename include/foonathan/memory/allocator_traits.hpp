@@ -170,6 +170,58 @@ namespace foonathan { namespace memory
             deallocate_node(full_concept{}, alloc, ptr, count * size, alignment);
         }
 
+        //=== allocate_node_bulk() ===//
+        // first try Allocator::allocate_node_bulk
+        // then call allocate_node() for each node
+        template <class Allocator>
+        auto allocate_node_bulk(full_concept, Allocator &alloc, std::size_t count,
+                                std::size_t size, std::size_t alignment, void **out)
+        -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_node_bulk(count, size, alignment, out), void)
+
+        // deallocates the already allocated nodes if an allocation throws
+        template <class Allocator>
+        struct bulk_allocation_guard
+        {
+            Allocator &alloc;
+            void **nodes;
+            std::size_t no_allocated, size, alignment;
+            bool done;
+
+            ~bulk_allocation_guard() FOONATHAN_NOEXCEPT
+            {
+                if (done)
+                    return;
+                while (no_allocated-- != 0u)
+                    deallocate_node(full_concept{}, alloc, nodes[no_allocated], size, alignment);
+            }
+        };
+
+        template <class Allocator>
+        void allocate_node_bulk(min_concept, Allocator &alloc, std::size_t count,
+                                std::size_t size, std::size_t alignment, void **out)
+        {
+            bulk_allocation_guard<Allocator> guard{alloc, out, 0u, size, alignment, false};
+            for (; guard.no_allocated != count; ++guard.no_allocated)
+                out[guard.no_allocated] = allocate_node(full_concept{}, alloc, size, alignment);
+            guard.done = true;
+        }
+
+        //=== deallocate_node_bulk() ===//
+        // first try Allocator::deallocate_node_bulk
+        // then call deallocate_node() for each node
+        template <class Allocator>
+        auto deallocate_node_bulk(full_concept, Allocator &alloc, std::size_t count,
+                                  std::size_t size, std::size_t alignment, void *const *nodes) FOONATHAN_NOEXCEPT
+        -> FOONATHAN_AUTO_RETURN_TYPE(alloc.deallocate_node_bulk(count, size, alignment, nodes), void)
+
+        template <class Allocator>
+        void deallocate_node_bulk(min_concept, Allocator &alloc, std::size_t count,
+                                  std::size_t size, std::size_t alignment, void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            for (std::size_t i = 0u; i != count; ++i)
+                deallocate_node(full_concept{}, alloc, nodes[i], size, alignment);
+        }
+
         //=== max_node_size() ===//
         // first try Allocator::max_node_size()
         // then return maximum value
@@ -208,6 +260,21 @@ namespace foonathan { namespace memory
         {
             return detail::max_alignment;
         }
+
+        //=== owns() ===//
+        // try Allocator::owns()
+        // there is no fallback, an allocator cannot tell in general
+        template <class Allocator>
+        auto owns(full_concept, const Allocator &alloc, const void *ptr)
+        -> FOONATHAN_AUTO_RETURN_TYPE(alloc.owns(ptr), bool)
+
+        template <class Allocator>
+        bool owns(error, const Allocator &, const void *)
+        {
+            static_assert(invalid_allocator_concept<Allocator>::error,
+                          "type does not provide: bool owns(const void*) const");
+            return false;
+        }
     } // namespace traits_detail
 
     /// The default specialization of the allocator_traits for a \concept{concept_rawallocator,RawAllocator}.
@@ -249,6 +316,20 @@ namespace foonathan { namespace memory
                                             state, array, count, size, alignment);
         }
 
+        static void allocate_node_bulk(allocator_type& state, std::size_t count,
+                                       std::size_t size, std::size_t alignment, void **out)
+        {
+            traits_detail::allocate_node_bulk(traits_detail::full_concept{},
+                                              state, count, size, alignment, out);
+        }
+
+        static void deallocate_node_bulk(allocator_type& state, std::size_t count,
+                                         std::size_t size, std::size_t alignment, void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            traits_detail::deallocate_node_bulk(traits_detail::full_concept{},
+                                                state, count, size, alignment, nodes);
+        }
+
         static std::size_t max_node_size(const allocator_type &state)
         {
             return traits_detail::max_node_size(traits_detail::full_concept{}, state);
@@ -263,6 +344,11 @@ namespace foonathan { namespace memory
         {
             return traits_detail::max_alignment(traits_detail::full_concept{}, state);
         }
+
+        static bool owns(const allocator_type &state, const void *ptr)
+        {
+            return traits_detail::owns(traits_detail::full_concept{}, state, ptr);
+        }
     };
 }} // namespace foonathan::memory
 
@@ -0,0 +1,223 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_BUDDY_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_BUDDY_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::buddy_allocator.
+
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/block_list.hpp"
+#include "detail/buddy_list.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that implements a binary buddy system.
+    /// It allocates huge memory blocks serving as arena from a given \c RawAllocator defaulting to \ref default_allocator
+    /// and divides them into trees whose size is twice the maximum block size.
+    /// Each allocation is rounded up to the next power of two and served from the smallest free block big enough,
+    /// splitting it in halves, the buddies, as needed.
+    /// Deallocation merges a block with its buddy as long as that one is free as well.<br>
+    /// Both are logarithmic in the ratio between maximum and minimum block size
+    /// and the fragmentation is bounded: a block never wastes more than half its size
+    /// and free memory always coalesces back into big blocks.
+    /// This makes it ideal for medium-sized buffers of varying size that live for a long time.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator>
+    class buddy_allocator
+    : FOONATHAN_EBO(detail::leak_checker<buddy_allocator<default_allocator>>)
+    {
+        using leak_checker = detail::leak_checker<buddy_allocator<default_allocator>>;
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using is_stateful = std::true_type;
+
+        /// \effects Creates it by giving it the minimum and maximum size of the blocks,
+        /// the initial block size for the arena and the implementation allocator.
+        /// Both block sizes are rounded up to a power of two, the minimum block size to at least two pointers.
+        /// It will allocate an initial memory block with given size from the implementation allocator
+        /// and divides it into trees.
+        /// \requires \c min_block_size and \c max_block_size must not be zero
+        /// and \c min_block_size must not be bigger than \c max_block_size.
+        /// \c block_size should be at least four times \c max_block_size,
+        /// since each tree needs to be aligned at its size.
+        buddy_allocator(std::size_t min_block_size, std::size_t max_block_size,
+                        std::size_t block_size, allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          block_list_(block_size, detail::move(allocator)),
+          list_(min_block_size, max_block_size)
+        {
+            allocate_block();
+        }
+
+        /// \effects Destroys the \ref buddy_allocator by returning all memory blocks,
+        /// regardless of properly deallocated back to the implementation allocator.
+        ~buddy_allocator() FOONATHAN_NOEXCEPT = default;
+
+        /// @{
+        /// \effects Moving a \ref buddy_allocator object transfers ownership over the free lists,
+        /// i.e. the moved from allocator is completely empty and the new one has all its memory.
+        /// That means that it is not allowed to call \ref deallocate_node() on a moved-from allocator
+        /// even when passing it memory that was previously allocated by this object.
+        buddy_allocator(buddy_allocator &&other) FOONATHAN_NOEXCEPT
+        : leak_checker(detail::move(other)),
+          block_list_(detail::move(other.block_list_)),
+          list_(detail::move(other.list_)) {}
+
+        buddy_allocator& operator=(buddy_allocator &&other) FOONATHAN_NOEXCEPT
+        {
+            leak_checker::operator=(detail::move(other));
+            block_list_ = detail::move(other.block_list_);
+            list_ = detail::move(other.list_);
+            return *this;
+        }
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} by taking the smallest free block
+        /// that is big enough for \c size and \c alignment and splitting it as needed.
+        /// If there is none, a new memory block will be allocated and divided into trees.
+        /// \returns A block of at least \c size bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if \c size or \c alignment exceeds \ref max_block_size().
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_block_size(), info());
+            detail::check_allocation_size(alignment, max_block_size(), info());
+            auto mem = list_.allocate(size, alignment);
+            while (!mem)
+            {
+                allocate_block();
+                mem = list_.allocate(size, alignment);
+            }
+            this->on_allocate(size);
+            return mem;
+        }
+
+        /// \effects Allocates an \concept{concept_array,array} of nodes as a single block,
+        /// like \ref allocate_node().
+        /// \returns A block of at least <tt>count * size</tt> bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if <tt>count * size</tt> or \c alignment exceeds \ref max_block_size().
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            return allocate_node(count * size, alignment);
+        }
+
+        /// \effects Deallocates a \concept{concept_node,node} by putting its block back
+        /// and merging it with its buddies.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() with the same size and alignment
+        /// on the same allocator, i.e. either this allocator object or a new object created by moving this to it.
+        void deallocate_node(void *ptr, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            list_.deallocate(ptr, size, alignment);
+            this->on_deallocate(size);
+        }
+
+        /// \effects Deallocates an \concept{concept_array,array} like \ref deallocate_node().
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same sizes
+        /// on the same allocator.
+        void deallocate_array(void *ptr, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(ptr, count * size, alignment);
+        }
+
+        /// @{
+        /// \returns The maximum size and alignment, which is \ref max_block_size().
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            return max_block_size();
+        }
+
+        std::size_t max_array_size() const FOONATHAN_NOEXCEPT
+        {
+            return max_block_size();
+        }
+
+        std::size_t max_alignment() const FOONATHAN_NOEXCEPT
+        {
+            return max_block_size();
+        }
+        /// @}
+
+        /// \returns The size of the smallest block, every allocation is at least this big.
+        std::size_t min_block_size() const FOONATHAN_NOEXCEPT
+        {
+            return list_.min_block_size();
+        }
+
+        /// \returns The size of the biggest block that can be allocated.
+        std::size_t max_block_size() const FOONATHAN_NOEXCEPT
+        {
+            return list_.max_block_size();
+        }
+
+        /// \returns The total amount of bytes remaining in free blocks.
+        /// \note An allocation may lead to a growth even if the capacity is big enough,
+        /// since there might not be a single block big enough.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return list_.capacity();
+        }
+
+        /// \returns The size of the next memory block after the arena grows.
+        /// \note Due to the alignment of the trees only a part of it can actually be used.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.next_block_size();
+        }
+
+        /// \returns Whether or not the memory pointed to by \c ptr was allocated from the arena of this allocator,
+        /// i.e. lies in one of the memory blocks currently used.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.owns(ptr);
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return block_list_.get_allocator();
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::buddy_allocator", this};
+        }
+
+        // inserts as many trees as fit into a new memory block
+        // the blocks grow, so eventually one will fit
+        void allocate_block()
+        {
+            auto mem = block_list_.allocate();
+            auto tree_size = list_.tree_size();
+            auto offset = detail::align_offset(mem.memory, tree_size);
+            if (offset >= mem.size)
+                return;
+            detail::debug_fill(mem.memory, offset, debug_magic::alignment_memory);
+
+            auto cur = static_cast<char*>(mem.memory) + offset;
+            for (auto remaining = mem.size - offset; remaining >= tree_size; remaining -= tree_size)
+            {
+                list_.insert_tree(cur);
+                cur += tree_size;
+            }
+        }
+
+        detail::block_list<allocator_type> block_list_;
+        detail::buddy_free_memory_list list_;
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_BUDDY_ALLOCATOR_HPP_INCLUDED
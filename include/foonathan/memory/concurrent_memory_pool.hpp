@@ -0,0 +1,241 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_CONCURRENT_MEMORY_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_CONCURRENT_MEMORY_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::concurrent_memory_pool and its \ref foonathan::memory::allocator_traits specialization.
+
+#include "config.hpp"
+#if !FOONATHAN_HAS_THREADING_SUPPORT
+    #error "This header is only available if there is threading support."
+#endif
+
+#include <mutex>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/block_list.hpp"
+#include "detail/concurrent_free_list.hpp"
+#include "allocator_traits.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+#include "default_allocator.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that manages \concept{concept_node,nodes} of fixed size
+    /// and can be shared between multiple threads without external synchronization.
+    /// Like \ref memory_pool it subdivides huge memory blocks into nodes,
+    /// but the nodes are stored on a lock-free free list.
+    /// Allocation and deallocation thus only need a single atomic compare-exchange operation in the common case.
+    /// Only if the free list is empty, the \c Mutex is locked to allocate a new memory block
+    /// from the implementation allocator.<br>
+    /// This is better than a \ref thread_safe_allocator using a \ref memory_pool if many threads allocate nodes concurrently,
+    /// since they do not serialize on one lock.
+    /// It does not support \concept{concept_array,arrays} bigger than a single node.
+    /// \note Since the allocator synchronizes itself, use \ref no_mutex when storing it in an \ref allocator_reference
+    /// or similar classes.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator, class Mutex = std::mutex>
+    class concurrent_memory_pool
+    : FOONATHAN_EBO(detail::concurrent_leak_checker<concurrent_memory_pool<default_allocator, std::mutex>>)
+    {
+        using leak_checker = detail::concurrent_leak_checker<concurrent_memory_pool<default_allocator, std::mutex>>;
+
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using mutex = Mutex;
+
+        static FOONATHAN_CONSTEXPR std::size_t min_node_size
+            = FOONATHAN_IMPL_DEFINED(detail::concurrent_free_memory_list::min_element_size);
+
+        /// \effects Creates it by specifying the size each \concept{concept_node,node} will have,
+        /// the initial block size for the arena and the implementation allocator.
+        /// If the \c node_size is less than the \c min_node_size, the \c min_node_size will be the actual node size.
+        /// It will allocate an initial memory block with given size from the implementation allocator
+        /// and puts it onto the free list.
+        /// \requires \c node_size must be a valid \concept{concept_node,node size}
+        /// and \c block_size must be a non-zero value.
+        concurrent_memory_pool(std::size_t node_size, std::size_t block_size,
+                               allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          block_list_(block_size, detail::move(allocator)),
+          free_list_(node_size)
+        {
+            allocate_block();
+        }
+
+        /// \effects Destroys the \ref concurrent_memory_pool by returning all memory blocks,
+        /// regardless of properly deallocated back to the implementation allocator.
+        /// \requires No other thread may use the pool anymore.
+        ~concurrent_memory_pool() FOONATHAN_NOEXCEPT = default;
+
+        /// @{
+        /// \effects A \ref concurrent_memory_pool can neither be copied nor moved,
+        /// since other threads might be using it.
+        concurrent_memory_pool(const concurrent_memory_pool &) = delete;
+        concurrent_memory_pool& operator=(const concurrent_memory_pool &) = delete;
+        /// @}
+
+        /// \effects Allocates a single \concept{concept_node,node} by removing it from the free list.
+        /// If the free list is empty, the \c Mutex will be locked and a new memory block allocated and put onto it.
+        /// The new block size will be \ref next_capacity() big.
+        /// \returns A node of size \ref node_size() suitable aligned,
+        /// i.e. suitable for any type where <tt>sizeof(T) < node_size()</tt>.
+        /// \throws Anything thrown by the used implementation allocator's allocation function if a growth is needed.
+        /// \note This function is thread-safe.
+        void* allocate_node()
+        {
+            auto mem = free_list_.allocate();
+            return mem ? mem : allocate_node_slow();
+        }
+
+        /// \effects Deallocates a single \concept{concept_node,node} by putting it back onto the free list.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() on the same pool.
+        /// \note This function is thread-safe.
+        void deallocate_node(void *ptr) FOONATHAN_NOEXCEPT
+        {
+            free_list_.deallocate(ptr);
+        }
+
+        /// \returns The size of each \concept{concept_node,node} in the pool,
+        /// this is either the same value as in the constructor or \c min_node_size if the value was too small.
+        std::size_t node_size() const FOONATHAN_NOEXCEPT
+        {
+            return free_list_.node_size();
+        }
+
+        /// \returns The size of the next memory block after the free list gets empty and the arena grows.
+        /// \note Due to fence memory, alignment buffers and the like this is only an upper bound on the memory available for nodes.
+        /// This function is thread-safe.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            std::lock_guard<mutex> lock(mutex_);
+            return block_list_.next_block_size();
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        /// Accessing it is not synchronized.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return block_list_.get_allocator();
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::concurrent_memory_pool", this};
+        }
+
+        void* allocate_node_slow()
+        {
+            std::lock_guard<mutex> lock(mutex_);
+            // another thread might have refilled the list while waiting for the lock,
+            // or might steal all nodes of the block just inserted,
+            // so retry until a node could be obtained
+            auto mem = free_list_.allocate();
+            while (!mem)
+            {
+                allocate_block();
+                mem = free_list_.allocate();
+            }
+            return mem;
+        }
+
+        // must be called with the mutex locked (or in the constructor)
+        void allocate_block()
+        {
+            auto mem = block_list_.allocate();
+            auto offset = detail::align_offset(mem.memory, detail::max_alignment);
+            detail::debug_fill(mem.memory, offset, debug_magic::alignment_memory);
+            free_list_.insert(static_cast<char*>(mem.memory) + offset, mem.size - offset);
+        }
+
+        detail::block_list<allocator_type> block_list_;
+        detail::concurrent_free_memory_list free_list_;
+        mutable mutex mutex_;
+
+        friend allocator_traits<concurrent_memory_pool<RawAllocator, Mutex>>;
+    };
+
+    template <class RawAllocator, class Mutex>
+    FOONATHAN_CONSTEXPR std::size_t concurrent_memory_pool<RawAllocator, Mutex>::min_node_size;
+
+    /// Specialization of the \ref allocator_traits for \ref concurrent_memory_pool classes.
+    /// All functions are thread-safe.
+    /// \note It is not allowed to mix calls through the specialization and through the member functions,
+    /// i.e. \ref concurrent_memory_pool::allocate_node() and this \c allocate_node().
+    /// \ingroup memory
+    template <class ImplRawAllocator, class Mutex>
+    class allocator_traits<concurrent_memory_pool<ImplRawAllocator, Mutex>>
+    {
+    public:
+        using allocator_type = concurrent_memory_pool<ImplRawAllocator, Mutex>;
+        using is_stateful = std::true_type;
+
+        /// \returns The result of \ref concurrent_memory_pool::allocate_node().
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if \c size / \c alignment exceeds \ref max_node_size() / \ref max_alignment().
+        static void* allocate_node(allocator_type &state,
+                                   std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_node_size(state), state.info());
+            detail::check_allocation_size(alignment, max_alignment(state), state.info());
+            auto mem = state.allocate_node();
+            state.on_allocate(size);
+            return mem;
+        }
+
+        /// \effects Forwards to \ref allocate_node() with a size of <tt>count * size</tt>,
+        /// since the pool does not support arrays bigger than a single node.
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if the array does not fit into a node.
+        static void* allocate_array(allocator_type &state, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(count * size, max_array_size(state), state.info());
+            return allocate_node(state, count * size, alignment);
+        }
+
+        /// \effects Just forwards to \ref concurrent_memory_pool::deallocate_node().
+        static void deallocate_node(allocator_type &state,
+                    void *node, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_node(node);
+            state.on_deallocate(size);
+        }
+
+        /// \effects Forwards to \ref deallocate_node() with the same size adjustment.
+        static void deallocate_array(allocator_type &state,
+                    void *array, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(state, array, count * size, alignment);
+        }
+
+        /// \returns The maximum size of each node which is \ref concurrent_memory_pool::node_size().
+        static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.node_size();
+        }
+
+        /// \returns The maximum size of an array which is \ref concurrent_memory_pool::node_size() as well.
+        static std::size_t max_array_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.node_size();
+        }
+
+        /// \returns The maximum alignment which is the next bigger power of two if less than \c alignof(std::max_align_t)
+        /// or the maximum alignment itself otherwise.
+        static std::size_t max_alignment(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.free_list_.alignment();
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_CONCURRENT_MEMORY_POOL_HPP_INCLUDED
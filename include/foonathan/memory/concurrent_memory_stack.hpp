@@ -0,0 +1,356 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_CONCURRENT_MEMORY_STACK_HPP_INCLUDED
+#define FOONATHAN_MEMORY_CONCURRENT_MEMORY_STACK_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::concurrent_memory_stack and its \ref foonathan::memory::allocator_traits specialization.
+
+#include "config.hpp"
+#if !FOONATHAN_HAS_THREADING_SUPPORT
+    #error "This header is only available if there is threading support."
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/block_list.hpp"
+#include "allocator_traits.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    template <class RawAllocator, class Mutex>
+    class concurrent_memory_stack;
+
+    namespace detail
+    {
+        // header at the beginning of each block of a concurrent_memory_stack
+        // the offset of the top is bumped atomically
+        struct concurrent_stack_block
+        {
+            std::atomic<std::size_t> top;
+            char *begin;
+            std::size_t size;
+
+            concurrent_stack_block(char *b, std::size_t s) FOONATHAN_NOEXCEPT
+            : top(0u), begin(b), size(s) {}
+        };
+
+        class concurrent_stack_marker
+        {
+            std::size_t index;
+            concurrent_stack_block *block;
+            std::size_t top;
+
+            concurrent_stack_marker(std::size_t i, concurrent_stack_block *b, std::size_t t) FOONATHAN_NOEXCEPT
+            : index(i), block(b), top(t) {}
+
+            template <class RawAllocator, class Mutex>
+            friend class memory::concurrent_memory_stack;
+        };
+    } // namespace detail
+
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that provides stack-like (LIFO) allocations
+    /// and can be shared between multiple threads without external synchronization.
+    /// Like \ref memory_stack it allocates huge memory blocks and moves a top marker for each allocation,
+    /// but the marker is an atomic integer that is advanced with a single atomic fetch-and-add.
+    /// Only if the current block is exhausted, the \c Mutex is locked and a new block taken from the implementation allocator.<br>
+    /// All allocations are rounded up to a multiple of \c alignof(std::max_align_t),
+    /// over-aligned allocations need additional padding.
+    /// It is ideal for short parallel phases where many threads allocate and everything is freed at once afterwards.
+    /// \note Querying the top and unwinding are not thread-safe, they can only be done while no other thread uses the stack.
+    /// Since the allocator synchronizes itself, use \ref no_mutex when storing it in an \ref allocator_reference
+    /// or similar classes.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator, class Mutex = std::mutex>
+    class concurrent_memory_stack
+    : FOONATHAN_EBO(detail::concurrent_leak_checker<concurrent_memory_stack<default_allocator, std::mutex>>)
+    {
+        using leak_checker = detail::concurrent_leak_checker<concurrent_memory_stack<default_allocator, std::mutex>>;
+        using block = detail::concurrent_stack_block;
+
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using mutex = Mutex;
+
+        /// \effects Creates it with a given initial block size and implementation allocator.
+        /// It will allocate the first block and sets the top to its beginning.
+        explicit concurrent_memory_stack(std::size_t block_size,
+                                         allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          list_(block_size, detail::move(allocator)),
+          cur_(nullptr), next_capacity_(0u)
+        {
+            allocate_block();
+        }
+
+        /// \effects Destroys the \ref concurrent_memory_stack by returning all memory blocks,
+        /// regardless of properly deallocated back to the implementation allocator.
+        /// \requires No other thread may use the stack anymore.
+        ~concurrent_memory_stack() FOONATHAN_NOEXCEPT = default;
+
+        /// @{
+        /// \effects A \ref concurrent_memory_stack can neither be copied nor moved,
+        /// since other threads might be using it.
+        concurrent_memory_stack(const concurrent_memory_stack &) = delete;
+        concurrent_memory_stack& operator=(const concurrent_memory_stack &) = delete;
+        /// @}
+
+        /// \effects Allocates a memory block of given size and alignment.
+        /// It atomically advances the top of the current block.
+        /// If there is not enough space on the current memory block,
+        /// the \c Mutex is locked and a new one will be allocated by the implementation allocator or taken from a cache
+        /// and used for the allocation.
+        /// \returns A \concept{concept_node,node} with given size and alignment.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if \c size is too big.
+        /// \requires \c size and \c alignment must be valid.
+        /// \note This function is thread-safe.
+        void* allocate(std::size_t size, std::size_t alignment)
+        {
+            auto needed = fence_size() + round_up(size) + fence_size()
+                        + (alignment > detail::max_alignment ? alignment - detail::max_alignment : 0u);
+            detail::check_allocation_size(needed, next_capacity(), info());
+
+            while (true)
+            {
+                auto cur = cur_.load(std::memory_order_acquire);
+                auto offset = cur->top.fetch_add(needed, std::memory_order_relaxed);
+                if (offset <= cur->size && needed <= cur->size - offset)
+                    return fill(cur->begin + offset, needed, size, alignment);
+
+                std::lock_guard<mutex> lock(mutex_);
+                // only switch if no other thread has done so already
+                if (cur_.load(std::memory_order_relaxed) == cur)
+                    allocate_block(needed);
+            }
+        }
+
+        /// The marker type that is used for unwinding.
+        /// The exact type is implementation defined,
+        /// it is only required that it is copyable.
+        using marker = FOONATHAN_IMPL_DEFINED(detail::concurrent_stack_marker);
+
+        /// \returns A marker to the current top of the stack.
+        /// \requires No other thread may allocate concurrently.
+        marker top() const FOONATHAN_NOEXCEPT
+        {
+            auto cur = cur_.load(std::memory_order_relaxed);
+            return {list_.size() - 1, cur, used(*cur)};
+        }
+
+        /// \effects Unwinds the stack to a certain marker position.
+        /// This sets the top pointer of the stack to the position described by the marker
+        /// and has the effect of deallocating all memory allocated since the marker was obtained.
+        /// If any memory blocks are unused after the operation,
+        /// they are not deallocated but put in a cache for later use,
+        /// call \ref shrink_to_fit() to actually deallocate them.
+        /// \requires The marker must point to memory that is still in use and was the whole time,
+        /// i.e. it must have been pointed below the top at all time.
+        /// No other thread may use the stack concurrently.
+        void unwind(marker m) FOONATHAN_NOEXCEPT
+        {
+            detail::check_pointer(m.index <= list_.size() - 1, info(), m.block->begin + m.top);
+
+            auto cur = cur_.load(std::memory_order_relaxed);
+            if (std::size_t to_deallocate = (list_.size() - 1) - m.index) // different index
+            {
+                list_.deallocate(cur->begin + used(*cur)); // top block only used up to the top of the stack
+                for (std::size_t i = 1; i != to_deallocate; ++i)
+                    list_.deallocate(); // other blocks fully used
+
+                cur = m.block;
+                detail::check_pointer(cur == block_from(list_.top()), info(), m.block->begin + m.top);
+                cur_.store(cur, std::memory_order_relaxed);
+            }
+            else
+                detail::check_pointer(m.block == cur && used(*cur) >= m.top, info(), m.block->begin + m.top);
+
+            // mark memory from new top to end of the block as freed
+            detail::debug_fill(cur->begin + m.top, used(*cur) - m.top, debug_magic::freed_memory);
+            cur->top.store(m.top, std::memory_order_relaxed);
+        }
+
+        /// \effects \ref unwind() does not actually do any deallocation of blocks on the implementation allocator,
+        /// unused memory is stored in a cache for later reuse.
+        /// This function clears that cache.
+        /// \requires No other thread may use the stack concurrently.
+        void shrink_to_fit() FOONATHAN_NOEXCEPT
+        {
+            list_.shrink_to_fit();
+        }
+
+        /// \returns The amount of memory remaining in the current block.
+        /// This is the number of bytes that are available for allocation
+        /// before the cache or implementation allocator needs to be used.
+        /// \note This is only a snapshot if other threads allocate concurrently.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            auto cur = cur_.load(std::memory_order_relaxed);
+            return cur->size - used(*cur);
+        }
+
+        /// \returns The size of the next memory block after the current one is exhausted and the arena grows.
+        /// \note Due to fence memory, alignment buffers and the like this may not be the exact result \ref capacity() will return,
+        /// but it is an upper bound to it.
+        /// This function is thread-safe.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return next_capacity_.load(std::memory_order_relaxed);
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        /// Accessing it is not synchronized.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return list_.get_allocator();
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::concurrent_memory_stack", this};
+        }
+
+        static std::size_t round_up(std::size_t size) FOONATHAN_NOEXCEPT
+        {
+            return (size + detail::max_alignment - 1u) / detail::max_alignment * detail::max_alignment;
+        }
+
+        // offsets must stay a multiple of the maximum alignment
+        static std::size_t fence_size() FOONATHAN_NOEXCEPT
+        {
+            return round_up(detail::debug_fence_size);
+        }
+
+        static std::size_t header_size() FOONATHAN_NOEXCEPT
+        {
+            return round_up(sizeof(block));
+        }
+
+        // the top might be bigger than the size after failed allocations
+        static std::size_t used(const block &b) FOONATHAN_NOEXCEPT
+        {
+            auto top = b.top.load(std::memory_order_relaxed);
+            return top < b.size ? top : b.size;
+        }
+
+        // fills the region reserved for an allocation and returns the memory
+        static void* fill(char *region, std::size_t needed, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            auto offset = detail::align_offset(region + fence_size(), alignment);
+            auto memory = region + fence_size() + offset;
+            detail::debug_fill(region, fence_size() + offset, debug_magic::fence_memory);
+            detail::debug_fill(memory, size, debug_magic::new_memory);
+            detail::debug_fill(memory + size, needed - fence_size() - offset - size, debug_magic::fence_memory);
+            return memory;
+        }
+
+        // the header is placed at the first properly aligned address
+        static block* block_from(detail::block_info info) FOONATHAN_NOEXCEPT
+        {
+            auto offset = detail::align_offset(info.memory, detail::max_alignment);
+            return static_cast<block*>(static_cast<void*>(static_cast<char*>(info.memory) + offset));
+        }
+
+        // must be called with the mutex locked (or in the constructor)
+        // cached blocks too small for an allocation of needed bytes are skipped,
+        // they are smaller than a new one after an unwind()
+        void allocate_block(std::size_t needed = 0u)
+        {
+            auto info = list_.allocate(detail::max_alignment + header_size() + needed);
+            auto memory = static_cast<char*>(static_cast<void*>(block_from(info)));
+            auto offset = std::size_t(memory - static_cast<char*>(info.memory));
+            detail::debug_fill(info.memory, offset, debug_magic::alignment_memory);
+            FOONATHAN_MEMORY_ASSERT(offset + header_size() <= info.size);
+
+            auto b = ::new(static_cast<void*>(memory)) block(memory + header_size(),
+                                                              info.size - offset - header_size());
+            cur_.store(b, std::memory_order_release);
+            // the block list itself must not be read without the lock
+            next_capacity_.store(list_.next_block_size() - header_size(), std::memory_order_relaxed);
+        }
+
+        detail::block_list<allocator_type> list_;
+        std::atomic<block*> cur_;
+        std::atomic<std::size_t> next_capacity_;
+        mutex mutex_;
+
+        friend allocator_traits<concurrent_memory_stack<RawAllocator, Mutex>>;
+    };
+
+    /// Specialization of the \ref allocator_traits for \ref concurrent_memory_stack classes.
+    /// \note It is not allowed to mix calls through the specialization and through the member functions,
+    /// i.e. \ref concurrent_memory_stack::allocate() and this \c allocate_node().
+    /// \ingroup memory
+    template <class ImplRawAllocator, class Mutex>
+    class allocator_traits<concurrent_memory_stack<ImplRawAllocator, Mutex>>
+    {
+    public:
+        using allocator_type = concurrent_memory_stack<ImplRawAllocator, Mutex>;
+        using is_stateful = std::true_type;
+
+        /// \returns The result of \ref concurrent_memory_stack::allocate().
+        static void* allocate_node(allocator_type &state, std::size_t size, std::size_t alignment)
+        {
+            auto mem = state.allocate(size, alignment);
+            state.on_allocate(size);
+            return mem;
+        }
+
+        /// \returns The result of \ref concurrent_memory_stack::allocate().
+        static void* allocate_array(allocator_type &state, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+        {
+            return allocate_node(state, count * size, alignment);
+        }
+
+        /// @{
+        /// \effects Does nothing besides bookmarking for leak checking, if that is enabled.
+        /// Actual deallocation can only be done via \ref concurrent_memory_stack::unwind().
+        static void deallocate_node(allocator_type &state,
+                    void *, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.on_deallocate(size);
+        }
+
+        static void deallocate_array(allocator_type &state,
+                    void *ptr, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(state, ptr, count * size, alignment);
+        }
+        /// @}
+
+        /// @{
+        /// \returns The maximum size which is \ref concurrent_memory_stack::next_capacity().
+        static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.next_capacity();
+        }
+
+        static std::size_t max_array_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.next_capacity();
+        }
+        /// @}
+
+        /// \returns The maximum possible value since there is no alignment restriction
+        /// (except indirectly through \ref concurrent_memory_stack::next_capacity()).
+        static std::size_t max_alignment(const allocator_type &) FOONATHAN_NOEXCEPT
+        {
+            return std::size_t(-1);
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_CONCURRENT_MEMORY_STACK_HPP_INCLUDED
@@ -8,6 +8,7 @@
 /// \file
 /// Debugging facilities.
 
+#include <atomic>
 #include <type_traits>
 
 #include "config.hpp"
@@ -226,6 +227,12 @@ namespace foonathan { namespace memory
                 allocated_ -= size;
             }
 
+            // all memory has been deallocated at once
+            void on_clear() FOONATHAN_NOEXCEPT
+            {
+                allocated_ = 0u;
+            }
+
         private:
             static const char* name_;
             std::size_t allocated_;
@@ -244,6 +251,57 @@ namespace foonathan { namespace memory
 
             leak_checker& operator=(leak_checker &&) FOONATHAN_NOEXCEPT {return *this;}
 
+            void on_allocate(std::size_t) FOONATHAN_NOEXCEPT {}
+            void on_deallocate(std::size_t) FOONATHAN_NOEXCEPT {}
+            void on_clear() FOONATHAN_NOEXCEPT {}
+        };
+    #endif
+
+    // same as leak_checker but the counter can be updated from multiple threads
+    // it is not movable since the allocators using it are not either
+    #if FOONATHAN_MEMORY_DEBUG_LEAK_CHECK
+        template <class RawAllocator>
+        class concurrent_leak_checker
+        {
+        protected:
+            concurrent_leak_checker(const char *name) FOONATHAN_NOEXCEPT
+            : allocated_(0u)
+            {
+                name_ = name;
+            }
+
+            ~concurrent_leak_checker() FOONATHAN_NOEXCEPT
+            {
+                auto allocated = allocated_.load(std::memory_order_relaxed);
+                if (allocated != 0u)
+                    get_leak_handler()({name_, this}, allocated);
+            }
+
+            void on_allocate(std::size_t size) FOONATHAN_NOEXCEPT
+            {
+                allocated_.fetch_add(size, std::memory_order_relaxed);
+            }
+
+            void on_deallocate(std::size_t size) FOONATHAN_NOEXCEPT
+            {
+                allocated_.fetch_sub(size, std::memory_order_relaxed);
+            }
+
+        private:
+            static const char* name_;
+            std::atomic<std::size_t> allocated_;
+        };
+
+        template <class RawAllocator>
+        const char* detail::concurrent_leak_checker<RawAllocator>::name_ = "";
+    #else
+        template <class RawAllocator>
+        class concurrent_leak_checker
+        {
+        protected:
+            concurrent_leak_checker(const char *) FOONATHAN_NOEXCEPT {}
+            ~concurrent_leak_checker() FOONATHAN_NOEXCEPT {}
+
             void on_allocate(std::size_t) FOONATHAN_NOEXCEPT {}
             void on_deallocate(std::size_t) FOONATHAN_NOEXCEPT {}
         };
@@ -0,0 +1,229 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DESTRUCTOR_STACK_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DESTRUCTOR_STACK_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::destructor_stack.
+
+#include <new>
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "memory_stack.hpp"
+
+namespace foonathan { namespace memory
+{
+    template <class RawAllocator>
+    class destructor_stack;
+
+    namespace detail
+    {
+        // record of an object with a non-trivial destructor
+        // it is allocated on the stack directly in front of the object
+        // the records form a list from the top of the stack to the bottom
+        struct destructor_record
+        {
+            void (*destroy)(destructor_record *record);
+            destructor_record *prev;
+        };
+
+        template <typename T>
+        struct destructor_record_for
+        {
+            static FOONATHAN_CONSTEXPR std::size_t alignment
+                = FOONATHAN_ALIGNOF(T) > FOONATHAN_ALIGNOF(destructor_record) ?
+                        FOONATHAN_ALIGNOF(T) : FOONATHAN_ALIGNOF(destructor_record);
+            // offset from the record to the object
+            static FOONATHAN_CONSTEXPR std::size_t offset
+                = (sizeof(destructor_record) + FOONATHAN_ALIGNOF(T) - 1u)
+                  / FOONATHAN_ALIGNOF(T) * FOONATHAN_ALIGNOF(T);
+
+            static void* object(destructor_record *record) FOONATHAN_NOEXCEPT
+            {
+                return reinterpret_cast<char*>(record) + offset;
+            }
+
+            static void destroy(destructor_record *record)
+            {
+                static_cast<T*>(object(record))->~T();
+            }
+        };
+
+        template <typename T>
+        FOONATHAN_CONSTEXPR std::size_t destructor_record_for<T>::alignment;
+
+        template <typename T>
+        FOONATHAN_CONSTEXPR std::size_t destructor_record_for<T>::offset;
+
+        class destructor_stack_marker
+        {
+            stack_marker stack;
+            destructor_record *last;
+
+            destructor_stack_marker(stack_marker s, destructor_record *l) FOONATHAN_NOEXCEPT
+            : stack(s), last(l) {}
+
+            template <class RawAllocator>
+            friend class memory::destructor_stack;
+        };
+    } // namespace detail
+
+    /// An arena on top of a \ref memory_stack that can also hold objects with non-trivial destructors.
+    /// Objects are created on the stack using the given \c RawAllocator defaulting to \ref default_allocator.
+    /// For each object with a non-trivial destructor it puts a small record in front of it on the stack,
+    /// storing the function to destroy it and linking it to the previous record.
+    /// Unwinding runs the destructors of all objects created since the marker in reverse order
+    /// and then releases the memory in one step.<br>
+    /// This allows putting entire object graphs like per-request data including strings or containers onto a stack
+    /// and freeing them at once without deallocating each object individually.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator>
+    class destructor_stack
+    {
+        using stack = memory_stack<RawAllocator>;
+
+    public:
+        using allocator_type = typename stack::allocator_type;
+
+        /// The marker type that is used for unwinding.
+        /// The exact type is implementation defined,
+        /// it is only required that it is copyable.
+        using marker = FOONATHAN_IMPL_DEFINED(detail::destructor_stack_marker);
+
+        /// \effects Creates it with a given initial block size and implementation allocator of the \ref memory_stack.
+        explicit destructor_stack(std::size_t block_size,
+                                  allocator_type allocator = allocator_type())
+        : stack_(block_size, detail::move(allocator)), last_(nullptr) {}
+
+        /// \effects Destroys the \ref destructor_stack by running the destructors of all objects still on it
+        /// in reverse order and then returning all memory blocks back to the implementation allocator.
+        ~destructor_stack() FOONATHAN_NOEXCEPT
+        {
+            destroy_until(nullptr);
+        }
+
+        /// @{
+        /// \effects Moving a \ref destructor_stack object transfers ownership over the memory and the objects,
+        /// i.e. the moved from stack is completely empty and the new one will destroy the objects.
+        destructor_stack(destructor_stack &&other) FOONATHAN_NOEXCEPT
+        : stack_(detail::move(other.stack_)), last_(other.last_)
+        {
+            other.last_ = nullptr;
+        }
+
+        destructor_stack& operator=(destructor_stack &&other) FOONATHAN_NOEXCEPT
+        {
+            destroy_until(nullptr);
+            stack_ = detail::move(other.stack_);
+            last_ = other.last_;
+            other.last_ = nullptr;
+            return *this;
+        }
+        /// @}
+
+        /// \effects Allocates memory for an object of type \c T on the stack and constructs it by passing it the arguments.
+        /// If \c T has a non-trivial destructor, it also registers it, so it is called on \ref unwind().
+        /// \returns A pointer to the new object.
+        /// \throws Anything thrown by the \ref memory_stack or the constructor.
+        /// If the constructor throws, the memory is not reclaimed until the next \ref unwind().
+        template <typename T, typename ... Args>
+        T* create(Args&&... args)
+        {
+            return create_impl<T>(std::is_trivially_destructible<T>{}, detail::forward<Args>(args)...);
+        }
+
+        /// \effects Allocates raw memory on the stack, like \ref memory_stack::allocate().
+        /// \returns A \concept{concept_node,node} with given size and alignment.
+        /// \throws Anything thrown by \ref memory_stack::allocate().
+        void* allocate(std::size_t size, std::size_t alignment)
+        {
+            return stack_.allocate(size, alignment);
+        }
+
+        /// \returns A marker to the current top of the stack.
+        marker top() const FOONATHAN_NOEXCEPT
+        {
+            return {stack_.top(), last_};
+        }
+
+        /// \effects Runs the destructors of all objects created since the marker was obtained in reverse order
+        /// and then unwinds the \ref memory_stack to the marker.
+        /// \requires The marker must have been obtained from this object and still be valid,
+        /// see \ref memory_stack::unwind().
+        void unwind(marker m) FOONATHAN_NOEXCEPT
+        {
+            destroy_until(m.last);
+            stack_.unwind(m.stack);
+        }
+
+        /// \effects Forwards to \ref memory_stack::shrink_to_fit().
+        void shrink_to_fit() FOONATHAN_NOEXCEPT
+        {
+            stack_.shrink_to_fit();
+        }
+
+        /// \returns The amount of memory remaining in the current block.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return stack_.capacity();
+        }
+
+        /// \returns The size of the next memory block after the current one is full.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return stack_.next_capacity();
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return stack_.get_allocator();
+        }
+
+    private:
+        template <typename T, typename ... Args>
+        T* create_impl(std::true_type, Args&&... args)
+        {
+            auto memory = stack_.allocate(sizeof(T), FOONATHAN_ALIGNOF(T));
+            return ::new(memory) T(detail::forward<Args>(args)...);
+        }
+
+        template <typename T, typename ... Args>
+        T* create_impl(std::false_type, Args&&... args)
+        {
+            using record_for = detail::destructor_record_for<T>;
+
+            auto memory = stack_.allocate(record_for::offset + sizeof(T), record_for::alignment);
+            auto record = ::new(memory) detail::destructor_record;
+            auto object = ::new(record_for::object(record)) T(detail::forward<Args>(args)...);
+
+            // only register it after the constructor succeeded
+            record->destroy = &record_for::destroy;
+            record->prev = last_;
+            last_ = record;
+            return object;
+        }
+
+        void destroy_until(detail::destructor_record *last) FOONATHAN_NOEXCEPT
+        {
+            while (last_ != last)
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(last_, "marker does not belong to the stack");
+                auto record = last_;
+                last_ = record->prev;
+                record->destroy(record);
+            }
+        }
+
+        stack stack_;
+        detail::destructor_record *last_;
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DESTRUCTOR_STACK_HPP_INCLUDED
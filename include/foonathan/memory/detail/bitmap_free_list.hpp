@@ -0,0 +1,112 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_BITMAP_FREE_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_BITMAP_FREE_LIST_HPP_INCLUDED
+
+#include <cstddef>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // a memory block inserted into the bitmap free list
+        struct bitmap_block;
+
+        // the same as free_memory_list but it stores the free nodes in a bitmap
+        // each inserted memory block starts with a header and one bit for each node, set means free
+        // free nodes are found by counting trailing zeros, arrays by searching for a run of set bits
+        // the nodes itself are never written to, so there is no minimum size
+        // debug: allocate() and deallocate() mark memory as new and freed, respectively
+        // node_size is increased via two times fence size and fence is put in front and after
+        class bitmap_free_memory_list
+        {
+        public:
+            // minimum element size
+            static FOONATHAN_CONSTEXPR std::size_t min_element_size = 1;
+            // alignment
+            static FOONATHAN_CONSTEXPR std::size_t min_element_alignment = 1;
+
+            //=== constructor ===//
+            bitmap_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT;
+
+            // does not own memory!
+            bitmap_free_memory_list(std::size_t node_size,
+                                    void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            bitmap_free_memory_list(bitmap_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+
+            ~bitmap_free_memory_list() FOONATHAN_NOEXCEPT = default;
+
+            bitmap_free_memory_list& operator=(bitmap_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+
+            friend void swap(bitmap_free_memory_list &a, bitmap_free_memory_list &b) FOONATHAN_NOEXCEPT;
+
+            //=== insert/alloc/dealloc ===//
+            // inserts new memory of given size into the free list
+            // only the header and the bitmap are written to
+            // mem must be aligned for maximum alignment
+            void insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            // allocates a node big enough for the node size
+            // pre: !empty()
+            void* allocate() FOONATHAN_NOEXCEPT;
+
+            // returns a memory block big enough for n bytes (!, not nodes)
+            // returns nullptr if there are not enough consecutive free nodes
+            void* allocate(std::size_t n) FOONATHAN_NOEXCEPT;
+
+            // deallocates the node previously allocated via allocate()
+            void deallocate(void *node) FOONATHAN_NOEXCEPT;
+
+            // deallocates the memory previously allocated via allocate(n)
+            void deallocate(void *ptr, std::size_t n) FOONATHAN_NOEXCEPT;
+
+            //=== getter ===//
+            std::size_t node_size() const FOONATHAN_NOEXCEPT;
+
+            // number of nodes remaining
+            std::size_t capacity() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_;
+            }
+
+            bool empty() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_ == 0u;
+            }
+
+            // the alignment of all nodes
+            std::size_t alignment() const FOONATHAN_NOEXCEPT;
+
+        private:
+            // size of each node including fences and padding for alignment
+            std::size_t slot_size() const FOONATHAN_NOEXCEPT;
+
+            // number of nodes needed for an array of n bytes
+            std::size_t no_slots(std::size_t n) const FOONATHAN_NOEXCEPT;
+
+            // finds the block from which memory is and returns it
+            // starts at dealloc_block_ and alloc_block_, then searches the entire list
+            // returns nullptr if no block
+            bitmap_block* block_for(void *memory) FOONATHAN_NOEXCEPT;
+
+            // returns a block with at least one free node
+            bitmap_block* find_block() FOONATHAN_NOEXCEPT;
+
+            // marks a range of nodes as used and returns the memory after the fence
+            void* take(bitmap_block *block, std::size_t index, std::size_t count, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            // marks a range of nodes as free
+            void give_back(void *memory, std::size_t count, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            bitmap_block *first_block_, *alloc_block_, *dealloc_block_;
+            std::size_t node_size_, capacity_;
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_BITMAP_FREE_LIST_HPP_INCLUDED
@@ -86,6 +86,10 @@ namespace foonathan { namespace memory
                 return head_ == nullptr;
             }
 
+            // returns whether or not the pointer points into the usable memory of any block
+            // walks the entire list
+            bool owns(const void *ptr) const FOONATHAN_NOEXCEPT;
+
         private:
             struct node;
             node *head_ = nullptr;
@@ -146,20 +150,42 @@ namespace foonathan { namespace memory
             // name is used for the growth tracker
             // debug: mark returned block as internal_memory
             block_info allocate()
+            {
+                auto block = allocate(used_);
+                ++size_;
+                return block;
+            }
+
+            // allocates a new block like allocate() but skips cached blocks with less usable memory than min_size,
+            // they stay cached for later
+            block_info allocate(std::size_t min_size)
+            {
+                block_list_impl skipped;
+                while (!free_.empty() && free_.top().size < min_size)
+                    skipped.push(free_);
+                auto block = allocate();
+                // restore the order
+                while (!skipped.empty())
+                    free_.push(skipped);
+                return block;
+            }
+
+            // allocates a new block like allocate() but puts it onto an external list
+            // the block is not counted by size() and owns() does not know about it,
+            // it must be given back via deallocate_all(list) before the block_list is destroyed
+            block_info allocate(block_list_impl &list)
             {
                 if (free_.empty())
                 {
                     auto memory = traits::allocate_array(get_allocator(),
                                                 cur_block_size_, 1, detail::max_alignment);
-                    ++size_;
-                    auto size = cur_block_size_ - used_.push(memory, cur_block_size_);
+                    auto size = cur_block_size_ - list.push(memory, cur_block_size_);
                     cur_block_size_ *= growth_factor;
                     detail::debug_fill(memory, size, debug_magic::internal_memory);
                     return {memory, size};
                 }
-                ++size_;
                 // already block cached in free list
-                auto block = used_.push(free_);
+                auto block = list.push(free_);
                 detail::debug_fill(block.memory, block.size, debug_magic::internal_memory);
                 return block;
             }
@@ -183,6 +209,46 @@ namespace foonathan { namespace memory
                            debug_magic::freed_memory);
             }
 
+            // deallocates all blocks for which the predicate returns true, they are cached for future use
+            // the predicate is called with each block from the last allocated one on
+            template <typename Predicate>
+            void deallocate_if(Predicate pred) FOONATHAN_NOEXCEPT
+            {
+                block_list_impl kept;
+                while (!used_.empty())
+                {
+                    if (pred(used_.top()))
+                    {
+                        --size_;
+                        auto block = free_.push(used_);
+                        debug_fill(block.memory, block.size, debug_magic::freed_memory);
+                    }
+                    else
+                        kept.push(used_);
+                }
+                // restore the order
+                while (!kept.empty())
+                    used_.push(kept);
+            }
+
+            // deallocates all blocks, they are all cached for future use
+            // afterwards they will be reused in the order they were allocated
+            void deallocate_all() FOONATHAN_NOEXCEPT
+            {
+                while (size_ != 0u)
+                    deallocate();
+            }
+
+            // deallocates all blocks of an external list, they are cached for future use
+            void deallocate_all(block_list_impl &list) FOONATHAN_NOEXCEPT
+            {
+                while (!list.empty())
+                {
+                    auto block = free_.push(list);
+                    debug_fill(block.memory, block.size, debug_magic::freed_memory);
+                }
+            }
+
             // the top block, this is the block that was allocated last
             block_info top() const FOONATHAN_NOEXCEPT
             {
@@ -211,6 +277,12 @@ namespace foonathan { namespace memory
                 return size_;
             }
 
+            // whether or not the pointer is inside a block currently in use
+            bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+            {
+                return used_.owns(ptr);
+            }
+
         private:
             block_list_impl used_, free_;
             std::size_t size_, cur_block_size_;
@@ -0,0 +1,72 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_BLOCK_MAP_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_BLOCK_MAP_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // maps memory blocks to the index of their owner
+        // the blocks are sorted by address, so the owner of a pointer is found with a binary search
+        // lookups never lock, they are retried if a block was inserted or erased at the same time (seqlock),
+        // insertions and erasures are serialized via the version
+        // it does not own the entries, they are given in the constructor
+        class block_map
+        {
+        public:
+            struct entry
+            {
+                std::atomic<std::uintptr_t> begin, end;
+                std::atomic<std::size_t> owner;
+            };
+
+            // returned by find() if no block contains the pointer
+            static FOONATHAN_CONSTEXPR std::size_t no_owner = std::size_t(-1);
+
+            // uses the array [entries, entries + capacity) for the blocks
+            block_map(entry *entries, std::size_t capacity) FOONATHAN_NOEXCEPT
+            : entries_(entries), capacity_(capacity), size_(0u), version_(0u) {}
+
+            block_map(const block_map &) = delete;
+            block_map& operator=(const block_map &) = delete;
+
+            // inserts the block [memory, memory + size) owned by owner
+            // pre: there are less than capacity blocks
+            void insert(const void *memory, std::size_t size, std::size_t owner) FOONATHAN_NOEXCEPT;
+
+            // erases the block starting at memory
+            // pre: it was inserted
+            void erase(const void *memory) FOONATHAN_NOEXCEPT;
+
+            // returns the owner of the block containing ptr or no_owner
+            std::size_t find(const void *ptr) const FOONATHAN_NOEXCEPT;
+
+        private:
+            // returns the version to pass to end_write()
+            std::size_t begin_write() FOONATHAN_NOEXCEPT;
+            void end_write(std::size_t version) FOONATHAN_NOEXCEPT;
+
+            // returns the index of the first block starting after address
+            std::size_t upper_bound(std::uintptr_t address, std::size_t size) const FOONATHAN_NOEXCEPT;
+
+            void copy(std::size_t to, std::size_t from) FOONATHAN_NOEXCEPT;
+
+            entry *entries_;
+            std::size_t capacity_;
+            std::atomic<std::size_t> size_;
+            // odd while a block is inserted or erased
+            std::atomic<std::size_t> version_;
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_BLOCK_MAP_HPP_INCLUDED
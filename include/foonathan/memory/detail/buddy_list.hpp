@@ -0,0 +1,110 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_BUDDY_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_BUDDY_LIST_HPP_INCLUDED
+
+#include <climits>
+#include <cstddef>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // a free block in the buddy list
+        struct buddy_node;
+
+        // free lists of a binary buddy system
+        // memory is inserted as trees, a tree has a power of two size and is aligned at it,
+        // so the tree of a block can be calculated from its address
+        // a tree starts with a table storing the order of each free block, indexed by its offset in minimum blocks,
+        // a block of order n has the size min_block_size() * 2^n
+        // each order has its own doubly linked free list
+        // allocation splits the smallest block that is big enough, deallocation merges a block with its free buddy
+        // debug: allocate() and deallocate() mark memory as new and freed, respectively
+        class buddy_free_memory_list
+        {
+        public:
+            // minimum block size, the links of the free list must fit into it
+            static FOONATHAN_CONSTEXPR std::size_t min_element_size = 2 * sizeof(void*);
+
+            //=== constructor ===//
+            // both sizes are rounded up to a power of two
+            buddy_free_memory_list(std::size_t min_block_size, std::size_t max_block_size) FOONATHAN_NOEXCEPT;
+
+            buddy_free_memory_list(buddy_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+            ~buddy_free_memory_list() FOONATHAN_NOEXCEPT = default;
+
+            buddy_free_memory_list& operator=(buddy_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+
+            friend void swap(buddy_free_memory_list &a, buddy_free_memory_list &b) FOONATHAN_NOEXCEPT;
+
+            //=== insert/alloc/dealloc ===//
+            // inserts a new tree
+            // does not own memory!
+            // mem must be aligned for tree_size() and have at least that size
+            void insert_tree(void *mem) FOONATHAN_NOEXCEPT;
+
+            // returns a block big enough for size bytes and aligned for alignment
+            // returns nullptr if there is no such block
+            void* allocate(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT;
+
+            // deallocates a block previously allocated via allocate() with the same size and alignment
+            void deallocate(void *ptr, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT;
+
+            //=== getter ===//
+            std::size_t min_block_size() const FOONATHAN_NOEXCEPT
+            {
+                return std::size_t(1) << min_block_log2_;
+            }
+
+            // biggest block that can be allocated
+            // the table takes some memory at the beginning, so it is half a tree
+            std::size_t max_block_size() const FOONATHAN_NOEXCEPT
+            {
+                return tree_size() / 2u;
+            }
+
+            std::size_t tree_size() const FOONATHAN_NOEXCEPT
+            {
+                return min_block_size() << max_order_;
+            }
+
+            // number of bytes remaining in free blocks
+            std::size_t capacity() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_;
+            }
+
+            bool empty() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_ == 0u;
+            }
+
+        private:
+            static FOONATHAN_CONSTEXPR std::size_t max_orders = sizeof(std::size_t) * CHAR_BIT;
+
+            // smallest order with a block big enough for size and alignment
+            std::size_t order_for(std::size_t size, std::size_t alignment) const FOONATHAN_NOEXCEPT;
+
+            // returns the order table of the tree containing memory
+            unsigned char* table_for(void *memory) const FOONATHAN_NOEXCEPT;
+
+            // index of a block in the table of its tree
+            std::size_t table_index(void *memory) const FOONATHAN_NOEXCEPT;
+
+            // adds/removes a free block to/from the list of its order and updates the table
+            void push(void *memory, std::size_t order) FOONATHAN_NOEXCEPT;
+            void erase(buddy_node *node, std::size_t order) FOONATHAN_NOEXCEPT;
+
+            buddy_node *free_[max_orders];
+            std::size_t min_block_log2_, max_order_;
+            std::size_t capacity_;
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_BUDDY_LIST_HPP_INCLUDED
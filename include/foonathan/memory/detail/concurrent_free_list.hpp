@@ -0,0 +1,98 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_CONCURRENT_FREE_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_CONCURRENT_FREE_LIST_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // stores free blocks for a memory pool that is shared between threads
+        // it is a lock-free intrusive stack (Treiber stack) of nodes,
+        // the head pointer is tagged with a counter to prevent the ABA problem
+        // all operations except construction and destruction are thread-safe
+        // the nodes must stay valid memory while the list exists,
+        // because a concurrent pop may read the link of a node that was just allocated
+        // debug: fills memory and uses a bigger node_size for fence memory
+        class concurrent_free_memory_list
+        {
+        public:
+            // minimum element size
+            static FOONATHAN_CONSTEXPR auto min_element_size = sizeof(char*);
+            // alignment
+            static FOONATHAN_CONSTEXPR auto min_element_alignment = FOONATHAN_ALIGNOF(char*);
+
+            //=== constructor ===//
+            concurrent_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT;
+
+            concurrent_free_memory_list(const concurrent_free_memory_list &) = delete;
+            ~concurrent_free_memory_list() FOONATHAN_NOEXCEPT = default;
+
+            concurrent_free_memory_list& operator=(const concurrent_free_memory_list &) = delete;
+
+            //=== insert/allocation/deallocation ===//
+            // inserts a new memory block, by splitting it up and setting the links
+            // the whole chain is published with a single atomic operation
+            // does not own memory!
+            // mem must be aligned for alignment()
+            // returns the number of nodes inserted
+            std::size_t insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            // returns a single block from the list
+            // returns nullptr if the list is empty
+            void* allocate() FOONATHAN_NOEXCEPT;
+
+            // deallocates a single block
+            void deallocate(void *ptr) FOONATHAN_NOEXCEPT;
+
+            //=== getter ===//
+            std::size_t node_size() const FOONATHAN_NOEXCEPT
+            {
+                return node_size_;
+            }
+
+            // only a snapshot, other threads may change it immediately
+            bool empty() const FOONATHAN_NOEXCEPT
+            {
+                return head_.load(std::memory_order_relaxed).ptr == nullptr;
+            }
+
+            // alignment of all nodes
+            std::size_t alignment() const FOONATHAN_NOEXCEPT;
+
+            // whether or not the operations are actually lock-free on this platform
+            // if not, std::atomic falls back to an internal lock
+            bool is_lock_free() const FOONATHAN_NOEXCEPT
+            {
+                return head_.is_lock_free();
+            }
+
+        private:
+            // node size with fence
+            std::size_t node_fence_size() const FOONATHAN_NOEXCEPT;
+
+            // pushes a chain of already linked nodes onto the list
+            void push(char *first, char *last) FOONATHAN_NOEXCEPT;
+
+            // the tag is incremented on every change of the head
+            struct tagged_ptr
+            {
+                char *ptr;
+                std::uintptr_t tag;
+            };
+
+            std::atomic<tagged_ptr> head_;
+            std::size_t node_size_;
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_CONCURRENT_FREE_LIST_HPP_INCLUDED
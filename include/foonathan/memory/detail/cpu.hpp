@@ -0,0 +1,63 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_CPU_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_CPU_HPP_INCLUDED
+
+#include <cstddef>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // to avoid false sharing
+        FOONATHAN_CONSTEXPR std::size_t cache_line_size = 64u;
+
+        // returns a small integer identifying the calling thread
+        // it is assigned on first use in a round-robin fashion and then cached
+        std::size_t thread_index() FOONATHAN_NOEXCEPT;
+
+        // returns the number of configured processors, at least 1
+        std::size_t cpu_count() FOONATHAN_NOEXCEPT;
+
+        // returns the index of the processor the calling thread is currently running on
+        // the thread might be migrated immediately afterwards, so it is only a hint
+        // falls back to thread_index() if the platform does not support it
+        // the result might be greater than or equal to cpu_count()
+        std::size_t current_cpu() FOONATHAN_NOEXCEPT;
+
+        // stack of pointers owned by one processor
+        // it is only modified by threads running on that processor in restartable sequences,
+        // so no synchronization is needed
+        // it fills whole cache lines, so an array of them aligned on a cache line does not have false sharing
+        struct percpu_stack
+        {
+            static FOONATHAN_CONSTEXPR std::size_t capacity = 31u;
+
+            std::size_t size;
+            void *slots[capacity];
+        };
+
+        static_assert(sizeof(percpu_stack) % cache_line_size == 0u,
+                      "percpu_stack must fill whole cache lines");
+
+        // whether or not the calling thread has a registered restartable sequence area
+        // only supported on x86_64 Linux with glibc 2.35 or newer
+        bool has_rseq() FOONATHAN_NOEXCEPT;
+
+        // pops a pointer from the stack of the processor the calling thread is running on,
+        // which is stacks[cpu * stride]
+        // returns nullptr if it is empty or there are no restartable sequences
+        void* percpu_pop(percpu_stack *stacks, std::size_t no_cpus, std::size_t stride) FOONATHAN_NOEXCEPT;
+
+        // pushes a pointer onto the stack of the processor the calling thread is running on
+        // returns false if it is full or there are no restartable sequences
+        bool percpu_push(percpu_stack *stacks, std::size_t no_cpus, std::size_t stride,
+                         void *ptr) FOONATHAN_NOEXCEPT;
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_CPU_HPP_INCLUDED
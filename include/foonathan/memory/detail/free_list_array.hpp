@@ -5,6 +5,7 @@
 #ifndef FOONATHAN_MEMORY_DETAIL_FREE_LIST_ARRAY_HPP
 #define FOONATHAN_MEMORY_DETAIL_FREE_LIST_ARRAY_HPP
 
+#include <climits>
 #include <type_traits>
 
 #include "align.hpp"
@@ -64,6 +65,7 @@ namespace foonathan { namespace memory
 
                 other.array_ = nullptr;
                 other.no_elements_ = 0u;
+                return *this;
             }
 
             // access free list for given size
@@ -113,13 +115,235 @@ namespace foonathan { namespace memory
             }
         };
 
+        template <typename Integral>
+        bool is_power_of_two(Integral no) FOONATHAN_NOEXCEPT
+        {
+            return (no & (no - 1)) == 0;
+        }
+
+        // ilog2 is a ceiling implementation of log2 for integers
+        // that is: ilog2(4) == 2, ilog2(5) == 3
+    #if defined __GNUC__
+        // we have a builtin to count leading zeros, use it
+        // subtract one if power of two, otherwise 0
+        // multiple overloads to support each size of std::size_t
+        inline std::size_t ilog2(unsigned int no) FOONATHAN_NOEXCEPT
+        {
+            return sizeof(no) * CHAR_BIT
+                    - unsigned(__builtin_clz(no)) - unsigned(is_power_of_two(no));
+        }
+
+        inline std::size_t ilog2(unsigned long no) FOONATHAN_NOEXCEPT
+        {
+            return sizeof(no) * CHAR_BIT
+                    - unsigned(__builtin_clzl(no)) - unsigned(is_power_of_two(no));
+        }
+
+        inline std::size_t ilog2(unsigned long long no) FOONATHAN_NOEXCEPT
+        {
+            return sizeof(no) * CHAR_BIT
+                    - unsigned(__builtin_clzll(no)) - unsigned(is_power_of_two(no));
+        }
+    #else
+        // naive loop, starting with 1 for non power of two to be ceiling
+        inline std::size_t ilog2(std::size_t no) FOONATHAN_NOEXCEPT
+        {
+            std::size_t result = is_power_of_two(no) ? 0u : 1u;
+            while (no >>= 1)
+                ++result;
+            return result;
+        }
+    #endif
+
         // AccessPolicy that maps sizes to the integral log2
         // this creates more nodes and never wastes more than half the size
         struct log2_access_policy
         {
-            static std::size_t index_from_size(std::size_t size) FOONATHAN_NOEXCEPT;
-            static std::size_t size_from_index(std::size_t index) FOONATHAN_NOEXCEPT;
+            static std::size_t index_from_size(std::size_t size) FOONATHAN_NOEXCEPT
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(size, "size must not be zero");
+                return ilog2(size);
+            }
+
+            static std::size_t size_from_index(std::size_t index) FOONATHAN_NOEXCEPT
+            {
+                return std::size_t(1) << index;
+            }
+        };
+
+        // AccessPolicy that splits each power of two into size_class_steps size classes
+        // sizes up to 2 * size_class_steps are mapped 1:1
+        // it creates more lists than log2 but never wastes more than a quarter of the size
+        struct size_class_access_policy
+        {
+            static FOONATHAN_CONSTEXPR std::size_t size_class_steps = 4u;
+            // log2 of the steps
+            static FOONATHAN_CONSTEXPR std::size_t size_class_steps_log2 = 2u;
+            // sizes up to it have their own index
+            static FOONATHAN_CONSTEXPR std::size_t linear_max = 2u * size_class_steps;
+            // ilog2(linear_max)
+            static FOONATHAN_CONSTEXPR std::size_t linear_max_log2 = size_class_steps_log2 + 1u;
+
+            static std::size_t index_from_size(std::size_t size) FOONATHAN_NOEXCEPT
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(size, "size must not be zero");
+                if (size <= linear_max)
+                    return size;
+                // size is in (2^group, 2^(group + 1)]
+                auto group = ilog2(size) - 1u;
+                auto spacing_log2 = group - size_class_steps_log2;
+                auto step = (size - (std::size_t(1) << group) - 1u) >> spacing_log2; // 0 to steps - 1
+                return linear_max + 1u + (group - linear_max_log2) * size_class_steps + step;
+            }
+
+            static std::size_t size_from_index(std::size_t index) FOONATHAN_NOEXCEPT
+            {
+                if (index <= linear_max)
+                    return index;
+                index -= linear_max + 1u;
+                auto group = linear_max_log2 + index / size_class_steps;
+                auto step = index % size_class_steps + 1u; // 1 to steps
+                return (std::size_t(1) << group) + (step << (group - size_class_steps_log2));
+            }
         };
+
+        //=== static_access_policy ===//
+        template <std::size_t ... Values>
+        struct size_sequence {};
+
+        // appends B to A, the values of B shifted by the size of A
+        template <class A, class B>
+        struct concat_sequence;
+
+        template <std::size_t ... A, std::size_t ... B>
+        struct concat_sequence<size_sequence<A...>, size_sequence<B...>>
+        {
+            using type = size_sequence<A..., (sizeof...(A) + B)...>;
+        };
+
+        // size_sequence<0, ..., N - 1>, logarithmic recursion depth
+        template <std::size_t N>
+        struct make_size_sequence
+        : concat_sequence<typename make_size_sequence<N / 2>::type,
+                          typename make_size_sequence<N - N / 2>::type> {};
+
+        template <>
+        struct make_size_sequence<0u>
+        {
+            using type = size_sequence<>;
+        };
+
+        template <>
+        struct make_size_sequence<1u>
+        {
+            using type = size_sequence<0u>;
+        };
+
+        // number of Sizes less than Size
+        template <std::size_t Size, std::size_t ... Sizes>
+        struct count_less;
+
+        template <std::size_t Size>
+        struct count_less<Size> : std::integral_constant<std::size_t, 0u> {};
+
+        template <std::size_t Size, std::size_t Head, std::size_t ... Tail>
+        struct count_less<Size, Head, Tail...>
+        : std::integral_constant<std::size_t, (Head < Size ? 1u : 0u) + count_less<Size, Tail...>::value> {};
+
+        // whether or not the Sizes are strictly ascending and not zero
+        template <std::size_t Prev, std::size_t ... Sizes>
+        struct is_ascending;
+
+        template <std::size_t Prev>
+        struct is_ascending<Prev> : std::true_type {};
+
+        template <std::size_t Prev, std::size_t Head, std::size_t ... Tail>
+        struct is_ascending<Prev, Head, Tail...>
+        : std::integral_constant<bool, (Prev < Head) && is_ascending<Head, Tail...>::value> {};
+
+        // bitwise or of all Sizes
+        template <std::size_t ... Sizes>
+        struct or_sizes;
+
+        template <>
+        struct or_sizes<> : std::integral_constant<std::size_t, 0u> {};
+
+        template <std::size_t Head, std::size_t ... Tail>
+        struct or_sizes<Head, Tail...>
+        : std::integral_constant<std::size_t, Head | or_sizes<Tail...>::value> {};
+
+        // the last of the Sizes
+        template <std::size_t Head, std::size_t ... Tail>
+        struct last_size : last_size<Tail...> {};
+
+        template <std::size_t Last>
+        struct last_size<Last> : std::integral_constant<std::size_t, Last> {};
+
+        // log2 of the lowest set bit of Value
+        template <std::size_t Value>
+        struct lowest_bit_log2
+        : std::integral_constant<std::size_t, (Value & 1u) ? 0u : 1u + lowest_bit_log2<(Value >> 1)>::value> {};
+
+        template <>
+        struct lowest_bit_log2<0u> : std::integral_constant<std::size_t, 0u> {};
+
+        // lookup table from size to bucket index
+        // entry I is the index of the bucket for all sizes in ((I - 1) << Shift, I << Shift]
+        template <class Indices, std::size_t Shift, class Sizes>
+        struct bucket_table;
+
+        template <std::size_t ... I, std::size_t Shift, std::size_t ... Sizes>
+        struct bucket_table<size_sequence<I...>, Shift, size_sequence<Sizes...>>
+        {
+            static const unsigned char values[sizeof...(I)];
+        };
+
+        template <std::size_t ... I, std::size_t Shift, std::size_t ... Sizes>
+        const unsigned char bucket_table<size_sequence<I...>, Shift, size_sequence<Sizes...>>::values[sizeof...(I)]
+            = {static_cast<unsigned char>(count_less<(I << Shift), Sizes...>::value)...};
+
+        // AccessPolicy for a fixed list of bucket sizes
+        // maps a size to the smallest bucket big enough through a table generated at compile-time
+        // all sizes are multiples of the largest power of two dividing each of them,
+        // so the table only needs an entry for every multiple of it
+        template <std::size_t ... Sizes>
+        struct static_access_policy
+        {
+            static_assert(sizeof...(Sizes) > 0u && sizeof...(Sizes) <= 255u,
+                          "invalid number of bucket sizes");
+            static_assert(is_ascending<0u, Sizes...>::value,
+                          "bucket sizes must be strictly ascending and not zero");
+
+            static FOONATHAN_CONSTEXPR std::size_t granularity_log2 = lowest_bit_log2<or_sizes<Sizes...>::value>::value;
+            static FOONATHAN_CONSTEXPR std::size_t max_size = last_size<Sizes...>::value;
+
+            static std::size_t index_from_size(std::size_t size) FOONATHAN_NOEXCEPT
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(size <= max_size, "size bigger than the biggest bucket");
+                return table::values[(size + (std::size_t(1) << granularity_log2) - 1u) >> granularity_log2];
+            }
+
+            static std::size_t size_from_index(std::size_t index) FOONATHAN_NOEXCEPT
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(index < sizeof...(Sizes), "invalid bucket index");
+                return sizes[index];
+            }
+
+        private:
+            static const std::size_t sizes[sizeof...(Sizes)];
+
+            using table = bucket_table<typename make_size_sequence<(max_size >> granularity_log2) + 1u>::type,
+                                       granularity_log2, size_sequence<Sizes...>>;
+        };
+
+        template <std::size_t ... Sizes>
+        const std::size_t static_access_policy<Sizes...>::sizes[sizeof...(Sizes)] = {Sizes...};
+
+        template <std::size_t ... Sizes>
+        FOONATHAN_CONSTEXPR std::size_t static_access_policy<Sizes...>::granularity_log2;
+
+        template <std::size_t ... Sizes>
+        FOONATHAN_CONSTEXPR std::size_t static_access_policy<Sizes...>::max_size;
     } // namespace detail
 }} // namespace foonathan::memory
 
@@ -0,0 +1,102 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_INDEXED_FREE_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_INDEXED_FREE_LIST_HPP_INCLUDED
+
+#include <cstddef>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // header of a run of consecutive free nodes, stored in its first node
+        struct free_run;
+
+        // same as ordered_free_memory_list but does not need to walk the list
+        // consecutive free nodes are merged into runs that are stored in a treap ordered by address
+        // each run also stores the length of the longest run in its subtree,
+        // so finding the first run big enough for an array is a single descent
+        // deallocation splits the treap at the address and merges it with the neighbouring runs
+        // debug: fills memory and uses a bigger node_size for fence memory
+        class indexed_free_memory_list
+        {
+        public:
+            // minimum element size, the header of a run must fit into a single node
+            static FOONATHAN_CONSTEXPR auto min_element_size = 4 * sizeof(char*);
+            // alignment
+            static FOONATHAN_CONSTEXPR auto min_element_alignment = FOONATHAN_ALIGNOF(char*);
+
+            //=== constructor ===//
+            indexed_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT;
+
+            // calls other constructor plus insert
+            indexed_free_memory_list(std::size_t node_size,
+                                     void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            indexed_free_memory_list(indexed_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+            ~indexed_free_memory_list() FOONATHAN_NOEXCEPT = default;
+
+            indexed_free_memory_list& operator=(indexed_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+
+            friend void swap(indexed_free_memory_list &a, indexed_free_memory_list &b) FOONATHAN_NOEXCEPT;
+
+            //=== insert/allocation/deallocation ===//
+            // inserts a new memory block as a single run
+            // does not own memory!
+            // mem must be aligned for alignment()
+            // pre: size != 0
+            void insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            // returns a single block from the list
+            // pre: !empty()
+            void* allocate() FOONATHAN_NOEXCEPT;
+
+            // returns a memory block big enough for n bytes (!, not nodes)
+            // from the run with the lowest address that is big enough
+            // returns nullptr if there is no such run
+            void* allocate(std::size_t n) FOONATHAN_NOEXCEPT;
+
+            // deallocates a single block
+            void deallocate(void *ptr) FOONATHAN_NOEXCEPT;
+
+            // deallocates multiple blocks with n bytes total
+            void deallocate(void *ptr, std::size_t n) FOONATHAN_NOEXCEPT;
+
+            //=== getter ===//
+            std::size_t node_size() const FOONATHAN_NOEXCEPT;
+
+            // number of nodes remaining
+            std::size_t capacity() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_;
+            }
+
+            bool empty() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_ == 0u;
+            }
+
+            // alignment of all nodes
+            std::size_t alignment() const FOONATHAN_NOEXCEPT;
+
+        private:
+            // node size with fence and padding for alignment
+            std::size_t slot_size() const FOONATHAN_NOEXCEPT;
+
+            // number of nodes needed for n bytes
+            std::size_t no_slots(std::size_t n) const FOONATHAN_NOEXCEPT;
+
+            // inserts the nodes into the treap and merges them with adjacent runs
+            void insert_run(char *memory, std::size_t no_nodes) FOONATHAN_NOEXCEPT;
+
+            free_run *root_;
+            std::size_t node_size_, capacity_;
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_INDEXED_FREE_LIST_HPP_INCLUDED
@@ -62,6 +62,12 @@ namespace foonathan { namespace memory
             char *cur_;
             const char *end_;
         };
+
+        // allocates memory by moving top downwards, but not below begin, returns nullptr if insufficient
+        // this is the counterpart to fixed_memory_stack::allocate() for a stack growing down
+        // debug: mark memory as new_memory, put fence in front and back
+        void* allocate_reverse(char *&top, const char *begin,
+                               std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT;
     } // namespace detail
 }} // namespace foonathan::memory
 
@@ -0,0 +1,73 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_RING_BUFFER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_RING_BUFFER_HPP_INCLUDED
+
+#include <cstddef>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // ring buffer of variable sized allocations that does not support growing
+        // allocations are taken at the head, the oldest allocation is at the tail
+        // each allocation is a record starting with a header storing its length and whether it is free,
+        // deallocation marks the record as free and moves the tail over all free records
+        // if there is not enough space before the end, the rest is filled with a free padding record and it wraps around
+        // debug: allocate() and deallocate() mark memory as new and freed, respectively
+        class fixed_ring_buffer
+        {
+        public:
+            //=== constructor ===//
+            fixed_ring_buffer() FOONATHAN_NOEXCEPT
+            : begin_(nullptr), end_(nullptr), head_(nullptr), tail_(nullptr),
+              live_(0u), wrapped_(false) {}
+
+            // gives it a memory block
+            fixed_ring_buffer(void *memory, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            fixed_ring_buffer(fixed_ring_buffer &&other) FOONATHAN_NOEXCEPT;
+            ~fixed_ring_buffer() FOONATHAN_NOEXCEPT = default;
+
+            fixed_ring_buffer& operator=(fixed_ring_buffer &&other) FOONATHAN_NOEXCEPT;
+
+            //=== alloc/dealloc ===//
+            // returns memory for size bytes aligned for alignment at the head
+            // returns nullptr if there is not enough space
+            void* allocate(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT;
+
+            // deallocates memory previously returned by allocate() in any order
+            void deallocate(void *ptr) FOONATHAN_NOEXCEPT;
+
+            //=== getter ===//
+            // whether or not there are no live allocations
+            bool empty() const FOONATHAN_NOEXCEPT
+            {
+                return live_ == 0u;
+            }
+
+            // number of bytes that can be reclaimed by allocations
+            // not all of it is contiguous
+            std::size_t capacity() const FOONATHAN_NOEXCEPT;
+
+            bool owns(const void *ptr) const FOONATHAN_NOEXCEPT;
+
+        private:
+            // puts a record of size bytes aligned for alignment at pos
+            // returns nullptr if it would go beyond limit
+            void* allocate_at(char *pos, const char *limit,
+                              std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT;
+
+            char *begin_, *end_;
+            char *head_, *tail_;
+            std::size_t live_;
+            bool wrapped_; // head is behind the tail
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_RING_BUFFER_HPP_INCLUDED
@@ -6,6 +6,7 @@
 #define FOONATHAN_MEMORY_DETAIL_SMALL_FREE_LIST_HPP_INCLUDED
 
 #include <cstddef>
+#include <cstdint>
 
 #include "../config.hpp"
 
@@ -34,6 +35,10 @@ namespace foonathan { namespace memory
             // inserts the next chunk from another list
             chunk* insert(chunk_list &other) FOONATHAN_NOEXCEPT;
 
+            // removes a chunk from the list
+            // pre: chunk is in the list
+            void erase(chunk *c) FOONATHAN_NOEXCEPT;
+
             // returns the next chunk
             chunk* top() const FOONATHAN_NOEXCEPT
             {
@@ -52,6 +57,15 @@ namespace foonathan { namespace memory
         // the same as free_memory_list but optimized for small node sizes
         // it is slower and does not support arrays
         // but has very small overhead
+        // inserted memory is only carved into chunks when they are needed,
+        // so inserting a big memory block does not touch it
+        // chunks have a power of two size and are aligned at it, so the chunk of a node can be calculated from its address,
+        // only the chunk at the beginning of inserted memory is not on that grid,
+        // those are found through a small hash map indexed by the grid position
+        // memory inserted directly after the previously inserted memory continues it, so it does not create such a chunk
+        // chunk headers store a tag of the list, so the ownership of a chunk can be checked in constant time
+        // the free nodes of a chunk are linked via 8 bit indices stored in the nodes,
+        // tiny nodes that can store 16 bit indices use them for bigger chunks instead
         // debug: allocate() and deallocate() mark memory as new and freed, respectively
         // node_size is increased via two times fence size and fence is put in front and after
         class small_free_memory_list
@@ -82,6 +96,12 @@ namespace foonathan { namespace memory
             // mem must be aligned for maximum alignment
             void insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
 
+            // removes memory previously inserted if none of its nodes is allocated
+            // returns whether or not it was removed
+            // pre: mem and size are the same as passed to insert(),
+            // no other memory was inserted directly before or after it
+            bool remove(void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
             // allocates a node big enough for the node size
             // pre: !empty()
             void* allocate() FOONATHAN_NOEXCEPT;
@@ -90,7 +110,8 @@ namespace foonathan { namespace memory
             void deallocate(void *node) FOONATHAN_NOEXCEPT;
 
             // hint for allocate() to be prepared to allocate n nodes
-            // it searches for a chunk that has n nodes free
+            // it takes a partially used chunk, an unused one or carves a new one,
+            // only for n > 1 it has to search for a chunk that has n nodes free
             // returns false, if there is none like that
             // never fails for n == 1 if not empty()
             // pre: capacity() >= n * node_size()
@@ -115,17 +136,41 @@ namespace foonathan { namespace memory
 
         private:
             // finds the chunk from which memory is and returns it
-            // starts at dealloc_chunk_ and goes in both directions
+            // checks dealloc_chunk_ and the chunks off the grid in the same grid cell and then calculates it
             // returns nullptr if no chunk
             chunk* chunk_for(void *memory) FOONATHAN_NOEXCEPT;
 
+            // returns the first chunk off the grid in the grid cell of memory
+            chunk*& odd_bucket(const void *memory) FOONATHAN_NOEXCEPT;
+
+            // adds nodes to the last carved chunk from the memory [begin, end) directly after it
+            // returns the end of the memory used
+            char* extend_last_chunk(char *begin, char *end) FOONATHAN_NOEXCEPT;
+
             // node size with fence
             std::size_t node_fence_size() const FOONATHAN_NOEXCEPT;
 
-            chunk_list unused_chunks_, used_chunks_;
-            chunk *alloc_chunk_, *dealloc_chunk_;
+            // number of nodes that will be carved out of the memory [begin, end)
+            std::size_t no_nodes(char *begin, char *end) const FOONATHAN_NOEXCEPT;
+
+            // creates a new chunk at the beginning of the uncarved memory
+            // returns nullptr if there is not enough memory left
+            chunk* carve_chunk() FOONATHAN_NOEXCEPT;
+
+            // returns the next chunk carved from the memory [cur, end) and advances cur after it
+            // returns nullptr if there is none
+            chunk* next_carved_chunk(char *&cur, char *end) const FOONATHAN_NOEXCEPT;
+
+            // unused: all nodes are free, full: no node is free, partial: all others and alloc_chunk_
+            chunk_list unused_chunks_, partial_chunks_, full_chunks_;
+            chunk *alloc_chunk_, *dealloc_chunk_, *last_chunk_;
+            // chunks off the grid hashed by their grid position, singly linked via next_odd
+            static FOONATHAN_CONSTEXPR std::size_t no_odd_buckets = 4u;
+            chunk *odd_chunks_[no_odd_buckets];
+            char *uncarved_begin_, *uncarved_end_;
 
             std::size_t node_size_, capacity_;
+            std::uint16_t tag_;
         };
     } // namespace detail
 }} // namespace foonathan::memory
@@ -0,0 +1,94 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DETAIL_TLSF_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_TLSF_LIST_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../config.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // header of a physical block in the tlsf list
+        struct tlsf_block;
+
+        // free lists of a two-level segregated fit allocator
+        // memory is inserted as regions, each region is a sequence of physical blocks
+        // terminated by an empty sentinel block that is never free
+        // every block has a header storing its size and whether it and the previous block are free,
+        // free blocks are coalesced immediately with their free neighbours
+        // the free blocks are segregated by their size into classes:
+        // the first level is the power of two, the second level divides that linearly into sl_count lists,
+        // a bitmap for each level allows finding a non-empty list in constant time
+        // debug: allocate() and deallocate() mark memory as new and freed, respectively
+        class tlsf_free_memory_list
+        {
+        public:
+            //=== constructor ===//
+            tlsf_free_memory_list() FOONATHAN_NOEXCEPT;
+
+            tlsf_free_memory_list(tlsf_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+            ~tlsf_free_memory_list() FOONATHAN_NOEXCEPT = default;
+
+            tlsf_free_memory_list& operator=(tlsf_free_memory_list &&other) FOONATHAN_NOEXCEPT;
+
+            friend void swap(tlsf_free_memory_list &a, tlsf_free_memory_list &b) FOONATHAN_NOEXCEPT;
+
+            //=== insert/alloc/dealloc ===//
+            // inserts a new memory region
+            // does not own memory!
+            // some bytes are used for the block headers and the sentinel
+            void insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            // returns a block big enough for size bytes and aligned for alignment
+            // returns nullptr if there is no such block
+            void* allocate(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT;
+
+            // deallocates a block previously allocated via allocate()
+            // the size is stored in the header, so it is not needed
+            void deallocate(void *ptr) FOONATHAN_NOEXCEPT;
+
+            //=== getter ===//
+            // biggest size that can be allocated
+            std::size_t max_block_size() const FOONATHAN_NOEXCEPT;
+
+            // number of usable bytes remaining in free blocks
+            std::size_t capacity() const FOONATHAN_NOEXCEPT
+            {
+                return capacity_;
+            }
+
+            bool empty() const FOONATHAN_NOEXCEPT
+            {
+                return fl_bitmap_ == 0u;
+            }
+
+        private:
+            static FOONATHAN_CONSTEXPR std::size_t sl_count_log2 = 4u;
+            static FOONATHAN_CONSTEXPR std::size_t sl_count = std::size_t(1) << sl_count_log2;
+            static FOONATHAN_CONSTEXPR std::size_t fl_count = sizeof(std::size_t) == 8u ? 32u : 24u;
+
+            // adds/removes a free block to/from the list of its size class and updates the bitmaps
+            void insert_free(tlsf_block *block) FOONATHAN_NOEXCEPT;
+            void erase_free(tlsf_block *block) FOONATHAN_NOEXCEPT;
+
+            // removes a free block of at least size bytes from its list
+            // returns nullptr if there is none
+            tlsf_block* find_free(std::size_t size) FOONATHAN_NOEXCEPT;
+
+            // splits a free block into one of size bytes and a free rest, if the rest is big enough
+            void trim(tlsf_block *block, std::size_t size) FOONATHAN_NOEXCEPT;
+
+            tlsf_block *free_[fl_count][sl_count];
+            std::uint32_t fl_bitmap_, sl_bitmap_[fl_count];
+            std::size_t capacity_;
+        };
+    } // namespace detail
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DETAIL_TLSF_LIST_HPP_INCLUDED
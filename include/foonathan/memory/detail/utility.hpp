@@ -68,6 +68,28 @@ namespace foonathan { namespace memory
             swap(a, b);
         }
 
+        // stores an object as base class to allow the empty base optimization
+        // the tag allows deriving from multiple storages of the same type
+        template <int Tag, typename T>
+        class ebo_storage : T
+        {
+        protected:
+            ebo_storage() = default;
+
+            explicit ebo_storage(T &&t)
+            : T(detail::move(t)) {}
+
+            T& get() FOONATHAN_NOEXCEPT
+            {
+                return *this;
+            }
+
+            const T& get() const FOONATHAN_NOEXCEPT
+            {
+                return *this;
+            }
+        };
+
         // fancier syntax for enable_if
         // used as (template) parameter
         // also useful for doxygen
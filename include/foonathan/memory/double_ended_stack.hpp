@@ -0,0 +1,273 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_DOUBLE_ENDED_STACK_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DOUBLE_ENDED_STACK_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::double_ended_stack and its \ref foonathan::memory::allocator_traits specialization.
+
+#include <type_traits>
+
+#include "detail/block_list.hpp"
+#include "detail/memory_stack.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    template <class RawAllocator>
+    class double_ended_stack;
+
+    namespace detail
+    {
+        // marker of one end of a double_ended_stack
+        // the parameter makes the markers of the two ends different types
+        template <bool Front>
+        class double_ended_marker
+        {
+            char *top;
+
+            explicit double_ended_marker(char *t) FOONATHAN_NOEXCEPT
+            : top(t) {}
+
+            template <class RawAllocator>
+            friend class memory::double_ended_stack;
+        };
+    } // namespace detail
+
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that provides stack-like (LIFO) allocations from both ends of a single memory block.
+    /// It allocates the block from a given \c RawAllocator defaulting to \ref default_allocator.
+    /// The front stack grows upwards from the beginning of the block and the back stack downwards from its end,
+    /// each has its own markers and can be unwound independently.
+    /// A common use is storing long-lived results on one end and temporaries on the other,
+    /// so the temporaries can be released without disturbing the results.<br>
+    /// Unlike \ref memory_stack it does not grow, an allocation fails if the two stacks would overlap.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator>
+    class double_ended_stack
+    : FOONATHAN_EBO(detail::leak_checker<double_ended_stack<default_allocator>>)
+    {
+        using leak_checker = detail::leak_checker<double_ended_stack<default_allocator>>;
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using is_stateful = std::true_type;
+
+        /// The marker types that are used for unwinding the front and back stack.
+        /// The exact types are implementation defined,
+        /// it is only required that they are copyable.
+        using front_marker = FOONATHAN_IMPL_DEFINED(detail::double_ended_marker<true>);
+        using back_marker = FOONATHAN_IMPL_DEFINED(detail::double_ended_marker<false>);
+
+        /// \effects Creates it by allocating a single memory block of given size from the implementation allocator.
+        /// Both stacks are initially empty.
+        explicit double_ended_stack(std::size_t block_size,
+                                    allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          list_(block_size, detail::move(allocator))
+        {
+            auto block = list_.allocate();
+            front_ = detail::fixed_memory_stack(block);
+            back_ = static_cast<char*>(block.memory) + block.size;
+        }
+
+        /// @{
+        /// \effects Moving a \ref double_ended_stack object transfers ownership over the memory block,
+        /// i.e. the moved from stack is completely empty.
+        double_ended_stack(double_ended_stack &&other) FOONATHAN_NOEXCEPT
+        : leak_checker(detail::move(other)),
+          list_(detail::move(other.list_)),
+          front_(detail::move(other.front_)),
+          back_(other.back_)
+        {
+            other.back_ = nullptr;
+        }
+
+        double_ended_stack& operator=(double_ended_stack &&other) FOONATHAN_NOEXCEPT
+        {
+            leak_checker::operator=(detail::move(other));
+            list_ = detail::move(other.list_);
+            front_ = detail::move(other.front_);
+            back_ = other.back_;
+            other.back_ = nullptr;
+            return *this;
+        }
+        /// @}
+
+        /// @{
+        /// \effects Allocates a memory block of given size and alignment on the front or back stack.
+        /// It simply moves the top marker of that end.
+        /// \returns A \concept{concept_node,node} with given size and alignment.
+        /// \throws \ref out_of_memory if there is not enough space left between the two stacks.
+        /// \requires \c size and \c alignment must be valid.
+        void* allocate_front(std::size_t size, std::size_t alignment)
+        {
+            auto mem = front_.allocate(size, alignment);
+            if (!mem)
+                FOONATHAN_THROW(out_of_memory(info(), size));
+            return mem;
+        }
+
+        void* allocate_back(std::size_t size, std::size_t alignment)
+        {
+            auto mem = detail::allocate_reverse(back_, front_.top(), size, alignment);
+            if (!mem)
+                FOONATHAN_THROW(out_of_memory(info(), size));
+            update_front_end();
+            return mem;
+        }
+        /// @}
+
+        /// @{
+        /// \returns A marker to the current top of the front or back stack.
+        front_marker top_front() const FOONATHAN_NOEXCEPT
+        {
+            return front_marker(front_.top());
+        }
+
+        back_marker top_back() const FOONATHAN_NOEXCEPT
+        {
+            return back_marker(back_);
+        }
+        /// @}
+
+        /// @{
+        /// \effects Unwinds the front or back stack to a certain marker position,
+        /// deallocating all memory allocated on that end since the marker was obtained.
+        /// The other end is not affected.
+        /// \requires The marker must point to memory of that end that is still in use and was the whole time.
+        void unwind(front_marker m) FOONATHAN_NOEXCEPT
+        {
+            detail::check_pointer(m.top <= front_.top(), info(), m.top);
+            front_.unwind(m.top);
+        }
+
+        void unwind(back_marker m) FOONATHAN_NOEXCEPT
+        {
+            detail::check_pointer(back_ <= m.top && m.top <= block_end(), info(), m.top);
+            detail::debug_fill(back_, std::size_t(m.top - back_), debug_magic::freed_memory);
+            back_ = m.top;
+            update_front_end();
+        }
+        /// @}
+
+        /// \returns The amount of memory remaining between the two stacks.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return std::size_t(back_ - front_.top());
+        }
+
+        /// \returns Whether or not the memory pointed to by \c ptr lies in the memory block of this stack.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            return list_.owns(ptr);
+        }
+
+        /// \returns A reference to the implementation allocator used for the memory block.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return list_.get_allocator();
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::double_ended_stack", this};
+        }
+
+        // the front stack must not grow into the back stack
+        void update_front_end() FOONATHAN_NOEXCEPT
+        {
+            front_ = detail::fixed_memory_stack(front_.top(), back_);
+        }
+
+        const char* block_end() const FOONATHAN_NOEXCEPT
+        {
+            auto block = list_.top();
+            return static_cast<const char*>(block.memory) + block.size;
+        }
+
+        detail::block_list<allocator_type> list_;
+        detail::fixed_memory_stack front_;
+        char *back_;
+
+        friend allocator_traits<double_ended_stack<allocator_type>>;
+    };
+
+    /// Specialization of the \ref allocator_traits for \ref double_ended_stack classes.
+    /// It allocates on the front stack.
+    /// \note It is not allowed to mix calls through the specialization and through the member functions,
+    /// i.e. \ref double_ended_stack::allocate_front() and this \c allocate_node().
+    /// \ingroup memory
+    template <class ImplRawAllocator>
+    class allocator_traits<double_ended_stack<ImplRawAllocator>>
+    {
+    public:
+        using allocator_type = double_ended_stack<ImplRawAllocator>;
+        using is_stateful = std::true_type;
+
+        /// \returns The result of \ref double_ended_stack::allocate_front().
+        static void* allocate_node(allocator_type &state, std::size_t size, std::size_t alignment)
+        {
+            auto mem = state.allocate_front(size, alignment);
+            state.on_allocate(size);
+            return mem;
+        }
+
+        /// \returns The result of \ref double_ended_stack::allocate_front().
+        static void* allocate_array(allocator_type &state, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+        {
+            return allocate_node(state, count * size, alignment);
+        }
+
+        /// @{
+        /// \effects Does nothing besides bookmarking for leak checking, if that is enabled.
+        /// Actual deallocation can only be done via \ref double_ended_stack::unwind().
+        static void deallocate_node(allocator_type &state,
+                                    void *, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.on_deallocate(size);
+        }
+
+        static void deallocate_array(allocator_type &state,
+                                     void *ptr, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(state, ptr, count * size, alignment);
+        }
+        /// @}
+
+        /// @{
+        /// \returns The maximum size which is \ref double_ended_stack::capacity().
+        static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.capacity();
+        }
+
+        static std::size_t max_array_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.capacity();
+        }
+        /// @}
+
+        /// \returns The maximum possible value since there is no alignment restriction
+        /// (except indirectly through \ref double_ended_stack::capacity()).
+        static std::size_t max_alignment(const allocator_type &) FOONATHAN_NOEXCEPT
+        {
+            return std::size_t(-1);
+        }
+
+        /// \returns The result of \ref double_ended_stack::owns().
+        static bool owns(const allocator_type &state, const void *ptr) FOONATHAN_NOEXCEPT
+        {
+            return state.owns(ptr);
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_DOUBLE_ENDED_STACK_HPP_INCLUDED
@@ -0,0 +1,176 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_FALLBACK_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_FALLBACK_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::fallback_allocator.
+
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A \concept{concept_rawallocator,RawAllocator} that allocates from a primary allocator
+    /// and uses a fallback allocator if that fails.
+    /// The fallback is used if the size or alignment exceeds the maximum of the \c PrimaryRawAllocator
+    /// or if it throws \ref out_of_memory.
+    /// Deallocation asks the primary allocator whether it owns the memory,
+    /// so it must support \ref allocator_traits::owns().
+    /// A typical use is a fixed-size stack or pool that falls back to the heap when it is exhausted.
+    /// \ingroup memory
+    template <class PrimaryRawAllocator, class FallbackRawAllocator>
+    class fallback_allocator
+    : FOONATHAN_EBO(detail::ebo_storage<0, typename allocator_traits<PrimaryRawAllocator>::allocator_type>,
+                    detail::ebo_storage<1, typename allocator_traits<FallbackRawAllocator>::allocator_type>)
+    {
+        using primary_traits = allocator_traits<PrimaryRawAllocator>;
+        using fallback_traits = allocator_traits<FallbackRawAllocator>;
+        using primary_storage = detail::ebo_storage<0, typename primary_traits::allocator_type>;
+        using fallback_storage = detail::ebo_storage<1, typename fallback_traits::allocator_type>;
+    public:
+        using primary_allocator_type = typename primary_traits::allocator_type;
+        using fallback_allocator_type = typename fallback_traits::allocator_type;
+        using is_stateful = std::integral_constant<bool,
+                                primary_traits::is_stateful::value || fallback_traits::is_stateful::value>;
+
+        /// \effects Creates it by giving it the two allocators.
+        explicit fallback_allocator(primary_allocator_type primary = primary_allocator_type(),
+                                    fallback_allocator_type fallback = fallback_allocator_type())
+        : primary_storage(detail::move(primary)), fallback_storage(detail::move(fallback)) {}
+
+        /// @{
+        /// \effects Allocates a \concept{concept_node,node} or \concept{concept_array,array} from the primary allocator.
+        /// If the size or alignment is too big for it or it throws \ref out_of_memory,
+        /// allocates from the fallback allocator instead.
+        /// \returns The result of the primary or fallback allocator.
+        /// \throws Anything thrown by the fallback allocator
+        /// or by the primary allocator except \ref out_of_memory.
+        /// \note Without exception support, the fallback is only used for sizes or alignments that are too big.
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            auto &primary = get_primary_allocator();
+            if (size <= primary_traits::max_node_size(primary)
+                && alignment <= primary_traits::max_alignment(primary))
+            {
+            #if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    return primary_traits::allocate_node(primary, size, alignment);
+                }
+                catch (out_of_memory&) {}
+            #else
+                return primary_traits::allocate_node(primary, size, alignment);
+            #endif
+            }
+            return fallback_traits::allocate_node(get_fallback_allocator(), size, alignment);
+        }
+
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            auto &primary = get_primary_allocator();
+            if (count * size <= primary_traits::max_array_size(primary)
+                && alignment <= primary_traits::max_alignment(primary))
+            {
+            #if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    return primary_traits::allocate_array(primary, count, size, alignment);
+                }
+                catch (out_of_memory&) {}
+            #else
+                return primary_traits::allocate_array(primary, count, size, alignment);
+            #endif
+            }
+            return fallback_traits::allocate_array(get_fallback_allocator(), count, size, alignment);
+        }
+        /// @}
+
+        /// @{
+        /// \effects Deallocates a \concept{concept_node,node} or \concept{concept_array,array}
+        /// by the primary allocator if it owns the memory, by the fallback allocator otherwise.
+        void deallocate_node(void *ptr, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            if (primary_traits::owns(get_primary_allocator(), ptr))
+                primary_traits::deallocate_node(get_primary_allocator(), ptr, size, alignment);
+            else
+                fallback_traits::deallocate_node(get_fallback_allocator(), ptr, size, alignment);
+        }
+
+        void deallocate_array(void *ptr, std::size_t count,
+                              std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            if (primary_traits::owns(get_primary_allocator(), ptr))
+                primary_traits::deallocate_array(get_primary_allocator(), ptr, count, size, alignment);
+            else
+                fallback_traits::deallocate_array(get_fallback_allocator(), ptr, count, size, alignment);
+        }
+        /// @}
+
+        /// @{
+        /// \returns The maximum of the values of the two allocators.
+        std::size_t max_node_size() const
+        {
+            auto primary = primary_traits::max_node_size(get_primary_allocator());
+            auto fallback = fallback_traits::max_node_size(get_fallback_allocator());
+            return primary > fallback ? primary : fallback;
+        }
+
+        std::size_t max_array_size() const
+        {
+            auto primary = primary_traits::max_array_size(get_primary_allocator());
+            auto fallback = fallback_traits::max_array_size(get_fallback_allocator());
+            return primary > fallback ? primary : fallback;
+        }
+
+        std::size_t max_alignment() const
+        {
+            auto primary = primary_traits::max_alignment(get_primary_allocator());
+            auto fallback = fallback_traits::max_alignment(get_fallback_allocator());
+            return primary > fallback ? primary : fallback;
+        }
+        /// @}
+
+        /// \returns Whether or not one of the two allocators owns the memory pointed to by \c ptr.
+        /// \requires The fallback allocator must support \ref allocator_traits::owns() as well.
+        bool owns(const void *ptr) const
+        {
+            return primary_traits::owns(get_primary_allocator(), ptr)
+                || fallback_traits::owns(get_fallback_allocator(), ptr);
+        }
+
+        /// @{
+        /// \returns A (\c const) reference to the primary allocator.
+        primary_allocator_type& get_primary_allocator() FOONATHAN_NOEXCEPT
+        {
+            return primary_storage::get();
+        }
+
+        const primary_allocator_type& get_primary_allocator() const FOONATHAN_NOEXCEPT
+        {
+            return primary_storage::get();
+        }
+        /// @}
+
+        /// @{
+        /// \returns A (\c const) reference to the fallback allocator.
+        fallback_allocator_type& get_fallback_allocator() FOONATHAN_NOEXCEPT
+        {
+            return fallback_storage::get();
+        }
+
+        const fallback_allocator_type& get_fallback_allocator() const FOONATHAN_NOEXCEPT
+        {
+            return fallback_storage::get();
+        }
+        /// @}
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_FALLBACK_ALLOCATOR_HPP_INCLUDED
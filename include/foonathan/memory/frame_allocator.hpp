@@ -0,0 +1,252 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_FRAME_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_FRAME_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::frame_allocator.
+
+#include <type_traits>
+
+#include "detail/block_list.hpp"
+#include "detail/memory_stack.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} for tick-based programs that keeps the memory of the last \c Frames frames.
+    /// It consists of \c Frames generations, each one a memory stack like \ref memory_stack.
+    /// Every frame allocates from the current generation,
+    /// \ref next_frame() rotates to the oldest generation and unwinds it completely.
+    /// This means that memory allocated during a frame stays valid for the next <tt>Frames - 1</tt> calls to \ref next_frame(),
+    /// so data can be handed over to the following frames without copying it.<br>
+    /// All generations share a single implementation allocator defaulting to \ref default_allocator and a cache of memory blocks,
+    /// blocks released by an unwound generation are reused by the others.
+    /// \ingroup memory
+    template <std::size_t Frames, class RawAllocator = default_allocator>
+    class frame_allocator
+    {
+        static_assert(Frames > 0u, "there must be at least one frame");
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using is_stateful = std::true_type;
+
+        /// \effects Creates it by giving it the size of the initial memory block and the implementation allocator.
+        /// It will allocate the initial memory block for the current frame,
+        /// the other generations get their blocks on their first allocation.
+        explicit frame_allocator(std::size_t block_size,
+                                 allocator_type allocator = allocator_type())
+        : list_(block_size, detail::move(allocator)),
+          cur_(0u), high_water_mark_(0u)
+        {
+            allocate_block(generations_[cur_]);
+        }
+
+        /// \effects Destroys the \ref frame_allocator by returning all memory blocks
+        /// of all generations back to the implementation allocator.
+        ~frame_allocator() FOONATHAN_NOEXCEPT
+        {
+            release_all();
+        }
+
+        /// @{
+        /// \effects Moving a \ref frame_allocator object transfers ownership over the generations,
+        /// i.e. the moved from allocator is completely empty and the new one has all its memory.
+        frame_allocator(frame_allocator &&other) FOONATHAN_NOEXCEPT
+        : list_(detail::move(other.list_)),
+          cur_(other.cur_), high_water_mark_(other.high_water_mark_)
+        {
+            for (std::size_t i = 0u; i != Frames; ++i)
+                generations_[i] = detail::move(other.generations_[i]);
+        }
+
+        frame_allocator& operator=(frame_allocator &&other) FOONATHAN_NOEXCEPT
+        {
+            // blocks in the generations would not be deallocated by the list
+            release_all();
+            list_ = detail::move(other.list_);
+            for (std::size_t i = 0u; i != Frames; ++i)
+                generations_[i] = detail::move(other.generations_[i]);
+            cur_ = other.cur_;
+            high_water_mark_ = other.high_water_mark_;
+            return *this;
+        }
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} from the generation of the current frame.
+        /// If the current memory block of the generation is exhausted,
+        /// it takes a cached block or allocates a new one from the implementation allocator.
+        /// \returns A block of at least \c size bytes aligned for \c alignment.
+        /// It stays valid until the generation is reused, i.e. <tt>Frames</tt> calls to \ref next_frame() later.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if \c size is too big.
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, next_capacity(), info());
+
+            auto &gen = generations_[cur_];
+            auto old_top = gen.stack.top();
+            auto mem = gen.stack.allocate(size, alignment);
+            // a cached block may be too small, so try until one fits
+            while (!mem)
+            {
+                allocate_block(gen);
+                old_top = gen.stack.top();
+                mem = gen.stack.allocate(size, alignment);
+            }
+
+            gen.size += std::size_t(gen.stack.top() - old_top);
+            if (gen.size > high_water_mark_)
+                high_water_mark_ = gen.size;
+            return mem;
+        }
+
+        /// \effects Allocates an \concept{concept_array,array} of nodes as a single block,
+        /// like \ref allocate_node().
+        /// \returns A block of at least <tt>count * size</tt> bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if the size is too big.
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            return allocate_node(count * size, alignment);
+        }
+
+        /// @{
+        /// \effects Does nothing.
+        /// Memory is only deallocated when its generation is reused by \ref next_frame().
+        void deallocate_node(void *, std::size_t, std::size_t) FOONATHAN_NOEXCEPT {}
+
+        void deallocate_array(void *, std::size_t, std::size_t, std::size_t) FOONATHAN_NOEXCEPT {}
+        /// @}
+
+        /// \effects Advances to the next frame by rotating to the oldest generation and unwinding it.
+        /// All memory allocated <tt>Frames</tt> frames ago is deallocated,
+        /// its memory blocks are put into the cache.
+        /// \note This is a constant operation if the oldest generation fits into a single memory block,
+        /// otherwise it is linear in the number of its blocks.
+        /// Call \ref shrink_to_fit() to actually deallocate the cached blocks.
+        void next_frame() FOONATHAN_NOEXCEPT
+        {
+            cur_ = (cur_ + 1u) % Frames;
+            auto &gen = generations_[cur_];
+            list_.deallocate_all(gen.blocks);
+            gen.stack = detail::fixed_memory_stack();
+            gen.size = 0u;
+        }
+
+        /// \returns The number of bytes allocated in the frame \c age frames ago,
+        /// i.e. \c 0 is the current frame.
+        /// This includes alignment and debug fences, but not the memory left at the end of a block.
+        /// \requires \c age must be less than \c Frames.
+        std::size_t frame_size(std::size_t age = 0u) const FOONATHAN_NOEXCEPT
+        {
+            FOONATHAN_MEMORY_ASSERT(age < Frames);
+            return generations_[(cur_ + Frames - age) % Frames].size;
+        }
+
+        /// \returns The maximum \ref frame_size() any frame has reached since construction,
+        /// a good value for the initial block size.
+        std::size_t high_water_mark() const FOONATHAN_NOEXCEPT
+        {
+            return high_water_mark_;
+        }
+
+        /// @{
+        /// \returns The maximum size which is \ref next_capacity().
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            return next_capacity();
+        }
+
+        std::size_t max_array_size() const FOONATHAN_NOEXCEPT
+        {
+            return next_capacity();
+        }
+        /// @}
+
+        /// \returns The maximum possible value since there is no alignment restriction
+        /// (except indirectly through \ref next_capacity()).
+        std::size_t max_alignment() const FOONATHAN_NOEXCEPT
+        {
+            return std::size_t(-1);
+        }
+
+        /// \effects Deallocates all cached memory blocks that are not used by any generation.
+        void shrink_to_fit() FOONATHAN_NOEXCEPT
+        {
+            list_.shrink_to_fit();
+        }
+
+        /// \returns The amount of memory remaining in the current memory block of the current frame.
+        /// This is the number of bytes that are available for allocation without growth.
+        /// \note Alignment buffers might lead to a growth even if the capacity is big enough.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            auto &gen = generations_[cur_];
+            return std::size_t(gen.stack.end() - gen.stack.top());
+        }
+
+        /// \returns The size of the next memory block after the current block is exhausted and the arena grows.
+        /// This function just forwards to the internal block list.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return list_.next_block_size();
+        }
+
+        /// \returns Whether or not the memory pointed to by \c ptr lies in one of the memory blocks of any generation.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            for (auto &gen : generations_)
+                if (gen.blocks.owns(ptr))
+                    return true;
+            return false;
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return list_.get_allocator();
+        }
+
+    private:
+        struct generation
+        {
+            detail::block_list_impl blocks;
+            detail::fixed_memory_stack stack;
+            std::size_t size = 0u;
+        };
+
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::frame_allocator", this};
+        }
+
+        void allocate_block(generation &gen)
+        {
+            gen.stack = detail::fixed_memory_stack(list_.allocate(gen.blocks));
+        }
+
+        void release_all() FOONATHAN_NOEXCEPT
+        {
+            for (auto &gen : generations_)
+            {
+                list_.deallocate_all(gen.blocks);
+                gen.stack = detail::fixed_memory_stack();
+            }
+        }
+
+        detail::block_list<allocator_type> list_;
+        generation generations_[Frames];
+        std::size_t cur_, high_water_mark_;
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_FRAME_ALLOCATOR_HPP_INCLUDED
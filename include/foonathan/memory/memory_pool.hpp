@@ -28,7 +28,7 @@ namespace foonathan { namespace memory
     /// subdivides them in small nodes of given size and puts them onto a free list.
     /// Allocation and deallocation simply remove or add nodes from this list and are thus fast.
     /// The way the list is maintained can be controlled via the \c PoolType
-    /// which is either \ref node_pool, \ref array_pool or \ref small_node_pool.<br>
+    /// which is either \ref node_pool, \ref array_pool, \ref indexed_array_pool, \ref small_node_pool or \ref bitmap_pool.<br>
     /// This kind of allocator is ideal for fixed size allocations and deallocations in any order,
     /// for example in a node based container like \c std::list.
     /// It is not so good for different allocation sizes and has some drawbacks for arrays
@@ -80,9 +80,9 @@ namespace foonathan { namespace memory
         memory_pool& operator=(memory_pool &&other) FOONATHAN_NOEXCEPT
         {
             detail::leak_checker<memory_pool<node_pool, default_allocator>>::operator=(detail::move(other));
-            block_list_ = std::move(other.block_list_);
-            block_list_ = std::move(other.block_list_);
-            free_list_ = std::move(other.free_list_);
+            block_list_ = detail::move(other.block_list_);
+            free_list_ = detail::move(other.free_list_);
+            return *this;
         }
         /// @}
 
@@ -100,6 +100,20 @@ namespace foonathan { namespace memory
             return free_list_.allocate();
         }
 
+        /// \effects Allocates \c count \concept{concept_node,nodes} at once and writes them to \c out.
+        /// It first grows the arena as often as necessary to have enough nodes on the free list,
+        /// then removes them without any further checks.
+        /// \throws Anything thrown by the used implementation allocator's allocation function if a growth is needed.
+        /// If it throws, no node has been allocated.
+        /// \requires \c out must point to an array of at least \c count pointers.
+        void allocate_node_bulk(std::size_t count, void **out)
+        {
+            while (free_list_.capacity() < count)
+                allocate_block();
+            for (std::size_t i = 0u; i != count; ++i)
+                out[i] = free_list_.allocate();
+        }
+
         /// \effects Allocates an \concept{concept_array,array} of nodes by searching for \c n continuous nodes on the list and removing them.
         /// Depending on the \c PoolType this can be a slow operation or not allowed at all.
         /// This can sometimes lead to a growth, even if technically there is enough continuous memory on the free list.
@@ -123,6 +137,15 @@ namespace foonathan { namespace memory
             free_list_.deallocate(ptr);
         }
 
+        /// \effects Deallocates \c count \concept{concept_node,nodes} at once by putting them back onto the free list.
+        /// \requires Each pointer in the array \c nodes must be a result from a previous call to \ref allocate_node()
+        /// or \ref allocate_node_bulk() on the same free list.
+        void deallocate_node_bulk(std::size_t count, void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            for (std::size_t i = 0u; i != count; ++i)
+                free_list_.deallocate(nodes[i]);
+        }
+
         /// \effects Deallocates an \concept{concept_array,array} by putting it back onto the free list.
         /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same \c n on the same free list,
         /// i.e. either this allocator object or a new object created by moving this to it.
@@ -133,6 +156,43 @@ namespace foonathan { namespace memory
             deallocate_array(ptr, n, node_size());
         }
 
+        /// \effects Deallocates all \concept{concept_node,nodes} at once.
+        /// All memory blocks are put into a cache without returning them to the implementation allocator
+        /// and the free list is reset to contain only the first block,
+        /// the other ones are taken from the cache again as the pool grows.
+        /// This is a lot cheaper than destroying and recreating the pool, it is linear in the number of memory blocks.
+        /// \requires No node allocated before may be used or deallocated afterwards.
+        /// \note In debug mode the memory will be marked as freed and the leak checker is reset.
+        void clear()
+        {
+            block_list_.deallocate_all();
+            free_list_ = free_list(node_size());
+            allocate_block(); // never allocates new memory, there is always a cached block
+            this->on_clear();
+        }
+
+        /// \effects Returns all memory blocks without any allocated \concept{concept_node,nodes}
+        /// back to the implementation allocator, except the first one,
+        /// together with the blocks cached by \ref clear().
+        /// Call it after a peak in memory usage to make the pool shrink again.
+        /// \requires The \c PoolType must be \ref small_node_pool, otherwise the body of this function will not compile.
+        /// \note This is linear in the number of memory blocks and the nodes of the unused ones.
+        void shrink_to_fit() FOONATHAN_NOEXCEPT
+        {
+            static_assert(std::is_same<pool_type, small_node_pool>::value,
+                          "only small_node_pool can remove memory");
+            auto no_blocks = block_list_.size();
+            block_list_.deallocate_if([&](const detail::block_info &block)
+            {
+                // the first block is kept, so there is always one for clear()
+                if (--no_blocks == 0u)
+                    return false;
+                auto offset = detail::align_offset(block.memory, detail::max_alignment);
+                return free_list_.remove(static_cast<char*>(block.memory) + offset, block.size - offset);
+            });
+            block_list_.shrink_to_fit();
+        }
+
         /// \returns The size of each \concept{concept_node,node} in the pool,
         /// this is either the same value as in the constructor or \c min_node_size if the value was too small.
         std::size_t node_size() const FOONATHAN_NOEXCEPT
@@ -156,6 +216,14 @@ namespace foonathan { namespace memory
             return block_list_.next_block_size();
         }
 
+        /// \returns Whether or not the memory pointed to by \c ptr was allocated from the arena of this allocator,
+        /// i.e. lies in one of the memory blocks currently used.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.owns(ptr);
+        }
+
         /// \returns A reference to the implementation allocator used for managing the arena.
         /// \requires It is undefined behavior to move this allocator out into another object.
         allocator_type& get_allocator() FOONATHAN_NOEXCEPT
@@ -263,6 +331,27 @@ namespace foonathan { namespace memory
             deallocate_array(PoolType{}, state, array, count , size);
         }
 
+        /// \effects Forwards to \ref memory_pool::allocate_node_bulk(),
+        /// the size and alignment are only checked once for the entire batch.
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if \c size / \c alignment exceeds \ref max_node_size() / \ref max_alignment().
+        static void allocate_node_bulk(allocator_type &state, std::size_t count,
+                                       std::size_t size, std::size_t alignment, void **out)
+        {
+            detail::check_allocation_size(size, max_node_size(state), state.info());
+            detail::check_allocation_size(alignment, max_alignment(state), state.info());
+            state.allocate_node_bulk(count, out);
+            state.on_allocate(count * size);
+        }
+
+        /// \effects Forwards to \ref memory_pool::deallocate_node_bulk().
+        static void deallocate_node_bulk(allocator_type &state, std::size_t count,
+                                         std::size_t size, std::size_t, void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_node_bulk(count, nodes);
+            state.on_deallocate(count * size);
+        }
+
         /// \returns The maximum size of each node which is \ref memory_pool::node_size().
         static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
         {
@@ -282,6 +371,12 @@ namespace foonathan { namespace memory
             return state.free_list_.alignment();
         }
 
+        /// \returns The result of \ref memory_pool::owns().
+        static bool owns(const allocator_type &state, const void *ptr) FOONATHAN_NOEXCEPT
+        {
+            return state.owns(ptr);
+        }
+
     private:
         static void* allocate_array(std::false_type, allocator_type &,
                                     std::size_t, std::size_t)
@@ -38,9 +38,34 @@ namespace foonathan { namespace memory
         using type = detail::log2_access_policy;
     };
 
+    /// A \c BucketDistribution for \ref memory_pool_collection defining that there are four buckets, i.e. pools, for each power of two.
+    /// The sizes between two powers of two are evenly spaced, i.e. after 32 follow 40, 48, 56 and 64,
+    /// like the size classes of allocators such as jemalloc.
+    /// Allocating a node will waste less than a quarter of the memory,
+    /// while there are still only few free lists.
+    struct size_class_buckets
+    {
+        using type = detail::size_class_access_policy;
+    };
+
+    /// A \c BucketDistribution for \ref memory_pool_collection defining that there is a bucket, i.e. pool, for each of the given \c Sizes.
+    /// A node is allocated from the smallest bucket that is big enough.
+    /// The bucket of a size is looked up in a table that is generated at compile-time,
+    /// so it is only a single memory access.
+    /// \requires \c Sizes must not be empty, strictly ascending and not zero, at most 255 sizes are allowed.
+    /// The maximum node size of the \ref memory_pool_collection must not be bigger than the last size.
+    /// \note The table has an entry for each multiple of the largest power of two that divides all \c Sizes
+    /// up to the last size, e.g. 13 entries for <tt>static_buckets<8, 16, 24, 48, 96></tt>.
+    template <std::size_t ... Sizes>
+    struct static_buckets
+    {
+        using type = detail::static_access_policy<Sizes...>;
+    };
+
     /// A stateful \concept{concept_rawallocator,RawAllocator} that behaves as a collection of multiple \ref memory_pool objects.
     /// It maintains a list of multiple free lists, whose types are controlled via the \c PoolType tags defined in \ref memory_pool_type.hpp,
-    /// each of a different size as defined in the \c BucketDistribution (\ref identity_buckets or \ref log2_buckets).
+    /// each of a different size as defined in the \c BucketDistribution
+    /// (\ref identity_buckets, \ref log2_buckets, \ref size_class_buckets or \ref static_buckets).
     /// Allocating a node of given size will use the appropriate free list.<br>
     /// This allocator is ideal for \concept{concept_node,node} allocations in any order but with a predefined set of sizes,
     /// not only one size like \ref memory_pool.
@@ -122,6 +147,23 @@ namespace foonathan { namespace memory
             return pool.allocate();
         }
 
+        /// \effects Allocates \c count \concept{concept_node,nodes} of given size at once and writes them to \c out.
+        /// It first inserts memory from the arena into the appropriate free list as often as necessary
+        /// to have enough nodes on it, growing the arena if needed,
+        /// then removes them without any further checks.
+        /// \throws Anything thrown by the implementation allocator if a growth is needed.
+        /// If it throws, no node has been allocated.
+        /// \requires \c node_size must be a valid \concept{concept_node,node size} less than or equal to \ref max_node_size(),
+        /// \c out must point to an array of at least \c count pointers.
+        void allocate_node_bulk(std::size_t count, std::size_t node_size, void **out)
+        {
+            auto& pool = pools_.get(node_size);
+            while (pool.capacity() < count)
+                reserve_impl(pool, def_capacity());
+            for (std::size_t i = 0u; i != count; ++i)
+                out[i] = pool.allocate();
+        }
+
         /// \effects Allocates an \concept{concept_array,array} of nodes by searching for \c n continuous nodes on the appropriate free list and removing them.
         /// Depending on the \c PoolType this can be a slow operation or not allowed at all.
         /// This can sometimes lead to a growth on the free list, even if technically there is enough continuous memory on the free list.
@@ -160,6 +202,17 @@ namespace foonathan { namespace memory
             pools_.get(node_size).deallocate(ptr);
         }
 
+        /// \effects Deallocates \c count \concept{concept_node,nodes} of given size at once
+        /// by putting them back onto the appropriate free list.
+        /// \requires Each pointer in the array \c nodes must be a result from a previous call to \ref allocate_node()
+        /// or \ref allocate_node_bulk() with the same size on the same free list.
+        void deallocate_node_bulk(std::size_t count, std::size_t node_size, void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            auto& pool = pools_.get(node_size);
+            for (std::size_t i = 0u; i != count; ++i)
+                pool.deallocate(nodes[i]);
+        }
+
         /// \effects Deallocates an \concept{concept_array,array} by putting it back onto the free list.
         /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same sizes on the same free list,
         /// i.e. either this allocator object or a new object created by moving this to it.
@@ -183,6 +236,31 @@ namespace foonathan { namespace memory
             reserve_impl(pool, capacity);
         }
 
+        /// \effects Deallocates all \concept{concept_node,nodes} at once.
+        /// All memory blocks are put into a cache without returning them to the implementation allocator
+        /// and all free lists are reset, the arena will then use the first block again
+        /// and take the other ones from the cache as it grows.
+        /// This is a lot cheaper than destroying and recreating the pool, it is linear in the number of memory blocks.
+        /// \requires No node allocated before may be used or deallocated afterwards.
+        /// \note In debug mode the memory will be marked as freed and the leak checker is reset.
+        void clear()
+        {
+            auto max_size = max_node_size();
+            block_list_.deallocate_all();
+            // never allocates new memory, there is always a cached block
+            stack_ = detail::fixed_memory_stack(block_list_.allocate());
+            pools_ = free_list_array(stack_, max_size);
+            this->on_clear();
+        }
+
+        /// \returns Whether or not the memory pointed to by \c ptr was allocated from the arena of this allocator,
+        /// i.e. lies in one of the memory blocks currently used.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.owns(ptr);
+        }
+
         /// \returns The maximum node size for which is a free list.
         /// This is the value passed to it in the constructor.
         std::size_t max_node_size() const FOONATHAN_NOEXCEPT
@@ -236,8 +314,12 @@ namespace foonathan { namespace memory
 
         void reserve_impl(typename pool_type::type &pool, std::size_t capacity)
         {
+            // keeps memory reserved one after the other adjacent, so the free list can continue the previous memory
+            if (auto misaligned = capacity % detail::max_alignment)
+                capacity += detail::max_alignment - misaligned;
             auto mem = stack_.allocate(capacity, detail::max_alignment);
-            if (!mem)
+            // a block reused after clear() can be too small, then it is given to the pool entirely
+            while (!mem)
             {
                 // insert rest
                 if (auto remaining = std::size_t(stack_.end() - stack_.top()))
@@ -253,7 +335,6 @@ namespace foonathan { namespace memory
                 stack_ = detail::fixed_memory_stack(block_list_.allocate());
                 // allocate ensuring alignment
                 mem = stack_.allocate(capacity, detail::max_alignment);
-                FOONATHAN_MEMORY_ASSERT(mem);
             }
             // insert new
             pool.insert(mem, capacity);
@@ -262,6 +343,8 @@ namespace foonathan { namespace memory
         detail::block_list<RawAllocator> block_list_;
         detail::fixed_memory_stack stack_;
         free_list_array pools_;
+
+        friend allocator_traits<memory_pool_collection<PoolType, BucketDistribution, RawAllocator>>;
     };
 
     /// An alias for \ref memory_pool_collection using the \ref identity_buckets policy
@@ -323,6 +406,28 @@ namespace foonathan { namespace memory
             deallocate_array(Pool{}, state, array, count, size);
         }
 
+        /// \effects Forwards to \ref memory_pool_collection::allocate_node_bulk(),
+        /// the size and alignment are only checked once for the entire batch.
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if \c size / \c alignment exceeds \ref max_node_size() / the suitable alignment value,
+        /// i.e. the node is over-aligned.
+        static void allocate_node_bulk(allocator_type &state, std::size_t count,
+                                       std::size_t size, std::size_t alignment, void **out)
+        {
+            detail::check_allocation_size(size, max_node_size(state), state.info());
+            detail::check_allocation_size(alignment, detail::alignment_for(size), state.info());
+            state.allocate_node_bulk(count, size, out);
+            state.on_allocate(count * size);
+        }
+
+        /// \effects Forwards to \ref memory_pool_collection::deallocate_node_bulk().
+        static void deallocate_node_bulk(allocator_type &state, std::size_t count,
+                                         std::size_t size, std::size_t, void *const *nodes) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_node_bulk(count, size, nodes);
+            state.on_deallocate(count * size);
+        }
+
         /// \returns The maximum size of each node which is \ref memory_pool_collection::max_node_size().
         static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
         {
@@ -342,6 +447,12 @@ namespace foonathan { namespace memory
             return detail::max_alignment;
         }
 
+        /// \returns The result of \ref memory_pool_collection::owns().
+        static bool owns(const allocator_type &state, const void *ptr) FOONATHAN_NOEXCEPT
+        {
+            return state.owns(ptr);
+        }
+
     private:
         static void* allocate_array(std::false_type, allocator_type &,
                                     std::size_t, std::size_t)
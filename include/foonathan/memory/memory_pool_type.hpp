@@ -10,7 +10,9 @@
 
 #include <type_traits>
 
+#include "detail/bitmap_free_list.hpp"
 #include "detail/free_list.hpp"
+#include "detail/indexed_free_list.hpp"
 #include "detail/small_free_list.hpp"
 #include "config.hpp"
 
@@ -38,6 +40,20 @@ namespace foonathan { namespace memory
         using type = detail::array_free_memory_list;
     };
 
+    /// Tag type defining a memory pool optimized for arrays with many nodes.
+    /// Like \ref array_pool it supports arrays by merging consecutive free nodes,
+    /// but the resulting runs are kept in a search tree ordered by address instead of a list.
+    /// Each run also stores the length of the longest run in its subtree, i.e. of itself and all runs below it,
+    /// so deallocation and finding the first run big enough for an array take logarithmic time instead of linear.
+    /// Node allocations are almost as fast as with \ref node_pool.
+    /// \note The header of a run is stored in its first node, so the node size is at least four pointers.
+    /// \ingroup memory
+    struct indexed_array_pool
+    : FOONATHAN_EBO(std::true_type)
+    {
+        using type = detail::indexed_free_memory_list;
+    };
+
     /// Tag type defining a memory pool optimized for small nodes.
     /// The free list is intrusive and thus requires that each node has at least the size of a pointer.
     /// This tag type does not have this requirement and thus allows zero-memory-overhead allocations of small nodes.
@@ -48,6 +64,19 @@ namespace foonathan { namespace memory
     {
         using type = detail::small_free_memory_list;
     };
+
+    /// Tag type defining a memory pool that keeps track of the free nodes in a bitmap.
+    /// Each block stores one bit per node in a separate header, so the nodes itself are never written to,
+    /// there is no minimum node size and double deallocations can be detected by testing a single bit.
+    /// Free nodes are found by scanning the bitmap a word at a time, arrays by searching for a run of free nodes.
+    /// Node allocations are a little bit slower than \ref node_pool,
+    /// array allocations are usually faster than with \ref array_pool.
+    /// \ingroup memory
+    struct bitmap_pool
+    : FOONATHAN_EBO(std::true_type)
+    {
+        using type = detail::bitmap_free_memory_list;
+    };
 }} // namespace foonathan::memory
 
 #endif // FOONATHAN_MEMORY_MEMORY_POOL_TYPE_HPP_INCLUDED
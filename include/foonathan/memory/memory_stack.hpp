@@ -85,6 +85,45 @@ namespace foonathan { namespace memory
             return mem;
         }
 
+        /// \effects Allocates \c count memory blocks of given size and alignment at once and writes them to \c out.
+        /// It works like calling \ref allocate() \c count times, but checks the size only once.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if \c size is too big.
+        /// If it throws, the stack is unwound to the position before the call.
+        /// \requires \c size and \c alignment must be valid,
+        /// \c out must point to an array of at least \c count pointers.
+        void allocate_bulk(std::size_t count, std::size_t size, std::size_t alignment, void **out)
+        {
+            detail::check_allocation_size(size, next_capacity(), info());
+
+            // unwinds to the old top if a growth throws
+            struct unwind_guard
+            {
+                memory_stack *self;
+                marker m;
+                bool done;
+
+                ~unwind_guard() FOONATHAN_NOEXCEPT
+                {
+                    if (!done)
+                        self->unwind(m);
+                }
+            } guard{this, top(), false};
+
+            for (std::size_t i = 0u; i != count; ++i)
+            {
+                auto mem = stack_.allocate(size, alignment);
+                if (!mem)
+                {
+                    allocate_block();
+                    mem = stack_.allocate(size, alignment);
+                    FOONATHAN_MEMORY_ASSERT(mem);
+                }
+                out[i] = mem;
+            }
+            guard.done = true;
+        }
+
         /// The marker type that is used for unwinding.
         /// The exact type is implementation defined,
         /// it is only required that it is copyable.
@@ -151,6 +190,14 @@ namespace foonathan { namespace memory
             return list_.next_block_size();
         }
 
+        /// \returns Whether or not the memory pointed to by \c ptr was allocated from the arena of this allocator,
+        /// i.e. lies in one of the memory blocks currently used.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            return list_.owns(ptr);
+        }
+
         /// \returns A reference to the implementation allocator used for managing the arena.
         /// \requires It is undefined behavior to move this allocator out into another object.
         allocator_type& get_allocator() FOONATHAN_NOEXCEPT
@@ -218,6 +265,21 @@ namespace foonathan { namespace memory
         }
         /// @}
 
+        /// \effects Forwards to \ref memory_stack::allocate_bulk().
+        static void allocate_node_bulk(allocator_type &state, std::size_t count,
+                                       std::size_t size, std::size_t alignment, void **out)
+        {
+            state.allocate_bulk(count, size, alignment, out);
+            state.on_allocate(count * size);
+        }
+
+        /// \effects Does nothing besides bookmarking for leak checking, like \ref deallocate_node().
+        static void deallocate_node_bulk(allocator_type &state, std::size_t count,
+                                         std::size_t size, std::size_t, void *const *) FOONATHAN_NOEXCEPT
+        {
+            state.on_deallocate(count * size);
+        }
+
         /// @{
         /// \returns The maximum size which is \ref memory_stack::next_capacity().
         static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
@@ -237,6 +299,12 @@ namespace foonathan { namespace memory
         {
             return std::size_t(-1);
         }
+
+        /// \returns The result of \ref memory_stack::owns().
+        static bool owns(const allocator_type &state, const void *ptr) FOONATHAN_NOEXCEPT
+        {
+            return state.owns(ptr);
+        }
     };
 }} // namespace foonathan::memory
 
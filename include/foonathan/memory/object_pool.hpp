@@ -0,0 +1,285 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_OBJECT_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_OBJECT_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::object_pool and related classes.
+
+#include "config.hpp"
+
+#include <new>
+#include <type_traits>
+
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+    #include <memory>
+#endif
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "default_allocator.hpp"
+#include "memory_pool.hpp"
+
+namespace foonathan { namespace memory
+{
+    namespace detail
+    {
+        // node of the object cache, the object comes first
+        // so a pointer to it is also a pointer to the node
+        template <typename T>
+        struct object_cache_node
+        {
+            typename std::aligned_storage<sizeof(T), FOONATHAN_ALIGNOF(T)>::type storage;
+            object_cache_node *next;
+        };
+    } // namespace detail
+
+    /// The default reset hook of an \ref object_pool.
+    /// Without arguments it does nothing, so a cached object is handed out in the state it was released in.
+    /// Otherwise it move assigns a new object created with the arguments.
+    /// \ingroup memory
+    struct object_pool_default_reset
+    {
+        template <typename T>
+        void operator()(T &) const FOONATHAN_NOEXCEPT {}
+
+        template <typename T, typename Arg, typename ... Args>
+        void operator()(T &object, Arg &&arg, Args&&... args) const
+        {
+            object = T(detail::forward<Arg>(arg), detail::forward<Args>(args)...);
+        }
+    };
+
+    /// A pool of constructed objects of type \c T, similar to a slab allocator with a constructor cache.
+    /// It allocates \concept{concept_node,nodes} from a \ref memory_pool using the given \c RawAllocator
+    /// defaulting to \ref default_allocator.
+    /// Released objects are not destroyed but put into a cache and handed out again by the next acquisition,
+    /// so resources owned by the objects like internal buffers stay warm.
+    /// Before a cached object is handed out, the \c Reset hook is called with it and the arguments of the acquisition,
+    /// it should bring the object into the state a new object created with those arguments would have.
+    /// It defaults to \ref object_pool_default_reset.
+    /// \ingroup memory
+    template <typename T, class Reset = object_pool_default_reset, class RawAllocator = default_allocator>
+    class object_pool
+    : FOONATHAN_EBO(Reset)
+    {
+        static_assert(FOONATHAN_ALIGNOF(T) <= detail::max_alignment, "over-aligned types are not supported");
+
+        using node = detail::object_cache_node<T>;
+        using pool = memory_pool<node_pool, RawAllocator>;
+
+    public:
+        using value_type = T;
+        using reset_type = Reset;
+        using allocator_type = typename pool::allocator_type;
+
+        /// \effects Creates it by giving it the initial block size for the arena of the \ref memory_pool,
+        /// the implementation allocator and the reset hook.
+        /// The cache is initially empty.
+        explicit object_pool(std::size_t block_size, allocator_type allocator = allocator_type(),
+                             reset_type reset = reset_type())
+        : reset_type(detail::move(reset)),
+          pool_(sizeof(node), block_size, detail::move(allocator)),
+          cache_(nullptr), cached_(0u) {}
+
+        /// \effects Destroys the \ref object_pool by destroying all cached objects
+        /// and returning all memory blocks back to the implementation allocator.
+        /// \requires All objects must have been released, objects still in use are not destroyed.
+        ~object_pool() FOONATHAN_NOEXCEPT
+        {
+            shrink();
+        }
+
+        /// @{
+        /// \effects Moving an \ref object_pool object transfers ownership over the memory and the cache,
+        /// i.e. the moved from pool is completely empty and the new one has all the objects.
+        /// That means that it is not allowed to call \ref release() on a moved-from pool
+        /// even when passing it objects that were previously acquired by this object.
+        object_pool(object_pool &&other) FOONATHAN_NOEXCEPT
+        : reset_type(detail::move(other)),
+          pool_(detail::move(other.pool_)),
+          cache_(other.cache_), cached_(other.cached_)
+        {
+            other.cache_ = nullptr;
+            other.cached_ = 0u;
+        }
+
+        object_pool& operator=(object_pool &&other) FOONATHAN_NOEXCEPT
+        {
+            shrink();
+            reset_type::operator=(detail::move(other));
+            pool_ = detail::move(other.pool_);
+            cache_ = other.cache_;
+            cached_ = other.cached_;
+            other.cache_ = nullptr;
+            other.cached_ = 0u;
+            return *this;
+        }
+        /// @}
+
+        /// \effects Returns an object of the pool.
+        /// If the cache is not empty, it takes a cached object and calls the reset hook with it and the arguments.
+        /// Otherwise it allocates a new node from the \ref memory_pool and constructs an object by passing it the arguments.
+        /// \returns A pointer to the object.
+        /// \throws Anything thrown by the allocation, the constructor or the reset hook.
+        /// If the reset hook throws, the cached object is destroyed.
+        template <typename ... Args>
+        T* acquire(Args&&... args)
+        {
+            if (cache_)
+            {
+                auto n = cache_;
+                cache_ = cache_->next;
+                --cached_;
+
+                auto object = reinterpret_cast<T*>(n);
+            #if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    reset_hook()(*object, detail::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    destroy(object);
+                    throw;
+                }
+            #else
+                reset_hook()(*object, detail::forward<Args>(args)...);
+            #endif
+                return object;
+            }
+
+            auto memory = pool_.allocate_node();
+        #if FOONATHAN_HAS_EXCEPTION_SUPPORT
+            try
+            {
+                return ::new(memory) T(detail::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                pool_.deallocate_node(memory);
+                throw;
+            }
+        #else
+            return ::new(memory) T(detail::forward<Args>(args)...);
+        #endif
+        }
+
+        /// \effects Puts an object back into the cache without destroying it.
+        /// \requires \c object must be a result from a previous call to \ref acquire() on the same pool,
+        /// i.e. either this object or a new object created by moving this to it.
+        void release(T *object) FOONATHAN_NOEXCEPT
+        {
+            auto n = reinterpret_cast<node*>(object);
+            n->next = cache_;
+            cache_ = n;
+            ++cached_;
+        }
+
+        /// \effects Destroys an object and returns its node to the \ref memory_pool,
+        /// bypassing the cache.
+        /// \requires \c object must be a result from a previous call to \ref acquire() on the same pool.
+        void destroy(T *object) FOONATHAN_NOEXCEPT
+        {
+            object->~T();
+            pool_.deallocate_node(object);
+        }
+
+        /// \effects Destroys all cached objects and returns their nodes to the \ref memory_pool.
+        void shrink() FOONATHAN_NOEXCEPT
+        {
+            while (cache_)
+            {
+                auto n = cache_;
+                cache_ = cache_->next;
+                destroy(reinterpret_cast<T*>(n));
+            }
+            cached_ = 0u;
+        }
+
+        /// \returns The number of objects in the cache,
+        /// i.e. the number of objects that can be acquired without constructing a new one.
+        std::size_t cached() const FOONATHAN_NOEXCEPT
+        {
+            return cached_;
+        }
+
+        /// \returns The amount of memory remaining in the \ref memory_pool for new objects.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return pool_.capacity();
+        }
+
+        /// \returns A reference to the reset hook.
+        reset_type& reset_hook() FOONATHAN_NOEXCEPT
+        {
+            return *this;
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return pool_.get_allocator();
+        }
+
+    private:
+        pool pool_;
+        node *cache_;
+        std::size_t cached_;
+    };
+
+    /// A deleter class that releases an object back into an \ref object_pool.
+    /// Only a pointer to the pool is stored.
+    /// \ingroup memory
+    template <typename T, class Reset = object_pool_default_reset, class RawAllocator = default_allocator>
+    class object_pool_deleter
+    {
+    public:
+        using pool_type = object_pool<T, Reset, RawAllocator>;
+        using value_type = T;
+
+        /// \effects Creates it by giving it the pool the objects will be released to.
+        object_pool_deleter(pool_type &pool) FOONATHAN_NOEXCEPT
+        : pool_(&pool) {}
+
+        /// \effects Calls \ref object_pool::release() on the pool.
+        void operator()(value_type *object) FOONATHAN_NOEXCEPT
+        {
+            pool_->release(object);
+        }
+
+        /// \returns A reference to the pool.
+        pool_type& get_pool() const FOONATHAN_NOEXCEPT
+        {
+            return *pool_;
+        }
+
+    private:
+        pool_type *pool_;
+    };
+
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+    /// A \c std::unique_ptr that releases its object back into an \ref object_pool.
+    /// It is an alias template using \ref object_pool_deleter as \c Deleter class.
+    /// \ingroup memory
+    template <typename T, class Reset = object_pool_default_reset, class RawAllocator = default_allocator>
+    FOONATHAN_ALIAS_TEMPLATE(object_pool_ptr, std::unique_ptr<T, object_pool_deleter<T, Reset, RawAllocator>>);
+
+    /// Creates a \c std::unique_ptr owning an object of an \ref object_pool.
+    /// \effects Calls \ref object_pool::acquire() forwarding the arguments.
+    /// \returns A \c std::unique_ptr owning the object that releases it back into the pool when destroyed.
+    /// \note The caller has to ensure that the pool lives as long as the smart pointer.
+    /// \ingroup memory
+    template <typename T, class Reset, class RawAllocator, typename ... Args>
+    std::unique_ptr<T, object_pool_deleter<T, Reset, RawAllocator>>
+        acquire_unique(object_pool<T, Reset, RawAllocator> &pool, Args&&... args)
+    {
+        return {pool.acquire(detail::forward<Args>(args)...), {pool}};
+    }
+#endif
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_OBJECT_POOL_HPP_INCLUDED
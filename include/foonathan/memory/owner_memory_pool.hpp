@@ -0,0 +1,288 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_OWNER_MEMORY_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_OWNER_MEMORY_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::owner_memory_pool and its \ref foonathan::memory::allocator_traits specialization.
+
+#include "config.hpp"
+#if !FOONATHAN_HAS_THREADING_SUPPORT
+    #error "This header is only available if there is threading support."
+#endif
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/block_list.hpp"
+#include "detail/free_list.hpp"
+#include "detail/small_free_list.hpp"
+#include "allocator_traits.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+#include "default_allocator.hpp"
+#include "memory_pool_type.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that manages \concept{concept_node,nodes} of fixed size
+    /// and is owned by a single thread, but allows deallocation from any thread.
+    /// It works like a \ref memory_pool, but only the owning thread - the one that created it - may allocate.
+    /// If the owner deallocates, the node is directly put onto the free list.
+    /// If any other thread deallocates, the node is pushed onto a lock-free queue of remote frees instead.
+    /// The owner reclaims all remote frees at once the next time its free list is empty before requesting a new memory block.<br>
+    /// This is ideal for producer-consumer scenarios where one thread allocates and another one deallocates,
+    /// the owner never needs to lock.
+    /// It does not support \concept{concept_array,arrays} bigger than a single node.
+    /// \note Since the allocator synchronizes itself, use \ref no_mutex when storing it in an \ref allocator_reference
+    /// or similar classes.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    template <typename PoolType = node_pool, class RawAllocator = default_allocator>
+    class owner_memory_pool
+    : FOONATHAN_EBO(detail::concurrent_leak_checker<owner_memory_pool<node_pool, default_allocator>>)
+    {
+        using free_list = typename PoolType::type;
+        using leak_checker = detail::concurrent_leak_checker<owner_memory_pool<node_pool, default_allocator>>;
+
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using pool_type = PoolType;
+
+        /// Each node must be able to store the link of the remote free queue.
+        static FOONATHAN_CONSTEXPR std::size_t min_node_size
+            = FOONATHAN_IMPL_DEFINED(free_list::min_element_size > sizeof(char*)
+                                     ? free_list::min_element_size : sizeof(char*));
+
+        /// \effects Creates it by specifying the size each \concept{concept_node,node} will have,
+        /// the initial block size for the arena and the implementation allocator.
+        /// If the \c node_size is less than the \c min_node_size, the \c min_node_size will be the actual node size.
+        /// It will allocate an initial memory block with given size from the implementation allocator
+        /// and puts it onto the free list.
+        /// The calling thread becomes the owner.
+        /// \requires \c node_size must be a valid \concept{concept_node,node size}
+        /// and \c block_size must be a non-zero value.
+        owner_memory_pool(std::size_t node_size, std::size_t block_size,
+                          allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          block_list_(block_size, detail::move(allocator)),
+          free_list_(node_size > min_node_size ? node_size : min_node_size),
+          remote_(nullptr), owner_(std::this_thread::get_id())
+        {
+            allocate_block();
+        }
+
+        /// \effects Destroys the \ref owner_memory_pool by returning all memory blocks,
+        /// regardless of properly deallocated back to the implementation allocator.
+        /// \requires No other thread may use the pool anymore.
+        ~owner_memory_pool() FOONATHAN_NOEXCEPT = default;
+
+        /// @{
+        /// \effects A \ref owner_memory_pool can neither be copied nor moved,
+        /// since other threads might be deallocating into it.
+        owner_memory_pool(const owner_memory_pool &) = delete;
+        owner_memory_pool& operator=(const owner_memory_pool &) = delete;
+        /// @}
+
+        /// \effects Allocates a single \concept{concept_node,node} by removing it from the free list.
+        /// If the free list is empty, all nodes deallocated by other threads are put onto it.
+        /// If it is still empty, a new memory block will be allocated and put onto it.
+        /// The new block size will be \ref next_capacity() big.
+        /// \returns A node of size \ref node_size() suitable aligned,
+        /// i.e. suitable for any type where <tt>sizeof(T) < node_size()</tt>.
+        /// \throws Anything thrown by the used implementation allocator's allocation function if a growth is needed.
+        /// \requires Must only be called by the owning thread.
+        void* allocate_node()
+        {
+            FOONATHAN_MEMORY_ASSERT_MSG(is_owner(), "only the owner may allocate");
+            if (free_list_.empty() && !reclaim())
+                allocate_block();
+            FOONATHAN_MEMORY_ASSERT(!free_list_.empty());
+            return free_list_.allocate();
+        }
+
+        /// \effects Deallocates a single \concept{concept_node,node}.
+        /// If called by the owning thread, it is put back onto the free list,
+        /// otherwise it is pushed onto the remote free queue, to be reclaimed later by the owner.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() on the same pool.
+        /// \note This function can be called by any thread.
+        void deallocate_node(void *ptr) FOONATHAN_NOEXCEPT
+        {
+            if (is_owner())
+                free_list_.deallocate(ptr);
+            else
+                push_remote(ptr);
+        }
+
+        /// \returns The size of each \concept{concept_node,node} in the pool,
+        /// this is either the same value as in the constructor or \c min_node_size if the value was too small.
+        std::size_t node_size() const FOONATHAN_NOEXCEPT
+        {
+            return free_list_.node_size();
+        }
+
+        /// \effects Returns the total amount of bytes remaining on the free list,
+        /// not counting nodes on the remote free queue.
+        /// Divide it by \ref node_size() to get the number of nodes that can be allocated without growing the arena.
+        /// \requires Must only be called by the owning thread.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return free_list_.capacity() * node_size();
+        }
+
+        /// \returns The size of the next memory block after the free list gets empty and the arena grows.
+        /// \note Due to fence memory, alignment buffers and the like this may not be the exact result \ref capacity() will return,
+        /// but it is an upper bound to it.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.next_block_size();
+        }
+
+        /// \returns The id of the owning thread.
+        std::thread::id owner() const FOONATHAN_NOEXCEPT
+        {
+            return owner_;
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return block_list_.get_allocator();
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::owner_memory_pool", this};
+        }
+
+        bool is_owner() const FOONATHAN_NOEXCEPT
+        {
+            return std::this_thread::get_id() == owner_;
+        }
+
+        void allocate_block()
+        {
+            auto mem = block_list_.allocate();
+            auto offset = detail::align_offset(mem.memory, detail::max_alignment);
+            detail::debug_fill(mem.memory, offset, debug_magic::alignment_memory);
+            free_list_.insert(static_cast<char*>(mem.memory) + offset, mem.size - offset);
+        }
+
+        // multiple producers push single nodes,
+        // the single consumer always takes the entire queue, so there is no ABA problem
+        void push_remote(void *ptr) FOONATHAN_NOEXCEPT
+        {
+            auto node = static_cast<char*>(ptr);
+            auto head = remote_.load(std::memory_order_relaxed);
+            do
+            {
+                *reinterpret_cast<char**>(node) = head;
+            } while (!remote_.compare_exchange_weak(head, node,
+                                                    std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // puts all remote frees onto the free list
+        // returns whether or not there were any
+        bool reclaim() FOONATHAN_NOEXCEPT
+        {
+            auto node = remote_.exchange(nullptr, std::memory_order_acquire);
+            if (!node)
+                return false;
+            while (node)
+            {
+                auto next = *reinterpret_cast<char**>(node);
+                free_list_.deallocate(node);
+                node = next;
+            }
+            return true;
+        }
+
+        detail::block_list<allocator_type> block_list_;
+        free_list free_list_;
+        std::atomic<char*> remote_;
+        std::thread::id owner_;
+
+        friend allocator_traits<owner_memory_pool<PoolType, RawAllocator>>;
+    };
+
+    template <class Type, class Alloc>
+    FOONATHAN_CONSTEXPR std::size_t owner_memory_pool<Type, Alloc>::min_node_size;
+
+    /// Specialization of the \ref allocator_traits for \ref owner_memory_pool classes.
+    /// \note It is not allowed to mix calls through the specialization and through the member functions,
+    /// i.e. \ref owner_memory_pool::allocate_node() and this \c allocate_node().
+    /// \ingroup memory
+    template <typename PoolType, class ImplRawAllocator>
+    class allocator_traits<owner_memory_pool<PoolType, ImplRawAllocator>>
+    {
+    public:
+        using allocator_type = owner_memory_pool<PoolType, ImplRawAllocator>;
+        using is_stateful = std::true_type;
+
+        /// \returns The result of \ref owner_memory_pool::allocate_node().
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if \c size / \c alignment exceeds \ref max_node_size() / \ref max_alignment().
+        static void* allocate_node(allocator_type &state,
+                                   std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_node_size(state), state.info());
+            detail::check_allocation_size(alignment, max_alignment(state), state.info());
+            auto mem = state.allocate_node();
+            state.on_allocate(size);
+            return mem;
+        }
+
+        /// \effects Forwards to \ref allocate_node() with a size of <tt>count * size</tt>,
+        /// since the pool does not support arrays bigger than a single node.
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if the array does not fit into a node.
+        static void* allocate_array(allocator_type &state, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(count * size, max_array_size(state), state.info());
+            return allocate_node(state, count * size, alignment);
+        }
+
+        /// \effects Just forwards to \ref owner_memory_pool::deallocate_node().
+        static void deallocate_node(allocator_type &state,
+                    void *node, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_node(node);
+            state.on_deallocate(size);
+        }
+
+        /// \effects Forwards to \ref deallocate_node() with the same size adjustment.
+        static void deallocate_array(allocator_type &state,
+                    void *array, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(state, array, count * size, alignment);
+        }
+
+        /// \returns The maximum size of each node which is \ref owner_memory_pool::node_size().
+        static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.node_size();
+        }
+
+        /// \returns The maximum size of an array which is \ref owner_memory_pool::node_size() as well.
+        static std::size_t max_array_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.node_size();
+        }
+
+        /// \returns The maximum alignment which is the next bigger power of two if less than \c alignof(std::max_align_t)
+        /// or the maximum alignment itself otherwise.
+        static std::size_t max_alignment(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.free_list_.alignment();
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_OWNER_MEMORY_POOL_HPP_INCLUDED
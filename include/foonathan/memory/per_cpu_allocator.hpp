@@ -0,0 +1,374 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_PER_CPU_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_PER_CPU_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::per_cpu_allocator.
+
+#include "config.hpp"
+#if !FOONATHAN_HAS_THREADING_SUPPORT
+    #error "This header is only available if there is threading support."
+#endif
+
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/cpu.hpp"
+#include "allocator_traits.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "threading.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that keeps one arena for each processor
+    /// to reduce contention when shared between threads.
+    /// Each arena is a separate \c RawAllocator object, typically a \ref memory_pool or \ref memory_pool_collection,
+    /// together with a \c Mutex.
+    /// Allocation uses the arena of the processor the calling thread is currently running on,
+    /// as reported by \c sched_getcpu() on Linux, so the memory footprint scales with the number of cores
+    /// instead of the number of threads.<br>
+    /// If the threads have a registered restartable sequence area (x86_64 Linux with glibc 2.35 or newer),
+    /// each processor also has a small cache of nodes for every size class up to 256 bytes.
+    /// Node allocations and deallocations pop from and push onto the cache of the current processor in a restartable sequence,
+    /// which needs neither a lock nor an atomic read-modify-write operation.
+    /// Those requests are rounded up to the size class, so that the cached nodes can be reused for any size in the class.
+    /// Only if the cache is empty or full, the slow path locks the \c Mutex of an arena.
+    /// Without restartable sequences, every allocation takes the slow path.
+    /// Since a thread is only rarely preempted in the middle of an allocation,
+    /// the lock of an arena is almost never contended and taking it is cheap, especially with the default \ref spin_mutex.
+    /// If the processor number is not available, it falls back to distributing the threads over the arenas.<br>
+    /// Deallocation on the slow path first checks the arena of the current processor and then all others,
+    /// finding the one that owns the pointer, so memory can be deallocated from any thread, even after a migration.
+    /// \requires There must be threading support.
+    /// \c RawAllocator must support \ref allocator_traits::owns().
+    /// \ingroup memory
+    template <class RawAllocator, class Mutex = spin_mutex>
+    class per_cpu_allocator
+    {
+        using traits = allocator_traits<RawAllocator>;
+    public:
+        using allocator_type = typename traits::allocator_type;
+        using mutex = Mutex;
+        using is_stateful = std::true_type;
+
+        /// \effects Creates it by constructing one arena for each configured processor,
+        /// passing each the same \c args.
+        /// \throws Anything thrown by the \ref default_allocator when allocating the bookkeeping
+        /// or by the constructor of the arenas.
+        template <typename ... Args>
+        explicit per_cpu_allocator(const Args&... args)
+        : arenas_(nullptr), cache_memory_(nullptr), caches_(nullptr), no_arenas_(detail::cpu_count()),
+          cache_size_(0u), cache_alignment_(0u)
+        {
+            arenas_ = static_cast<arena*>(allocator_traits<default_allocator>::
+                        allocate_array(bookkeeping_allocator(), no_arenas_,
+                                       sizeof(arena), FOONATHAN_ALIGNOF(arena)));
+            if (detail::has_rseq())
+            {
+            #if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    allocate_caches();
+                }
+                catch (...)
+                {
+                    deallocate_arenas();
+                    throw;
+                }
+            #else
+                allocate_caches();
+            #endif
+            }
+
+            // destroys the already created arenas and frees the bookkeeping if a constructor throws
+            struct construction_guard
+            {
+                per_cpu_allocator *self;
+                std::size_t no_created;
+
+                ~construction_guard() FOONATHAN_NOEXCEPT
+                {
+                    if (no_created == self->no_arenas_)
+                        return;
+                    while (no_created-- != 0u)
+                        self->arenas_[no_created].~arena();
+                    self->deallocate_caches();
+                    self->deallocate_arenas();
+                }
+            } guard{this, 0u};
+
+            for (; guard.no_created != no_arenas_; ++guard.no_created)
+                ::new(static_cast<void*>(arenas_ + guard.no_created)) arena(args...);
+
+            if (caches_)
+            {
+                auto max_size = traits::max_node_size(arenas_[0].alloc);
+                auto max_alignment = traits::max_alignment(arenas_[0].alloc);
+                cache_size_ = no_size_classes * detail::max_alignment;
+                if (cache_size_ > max_size)
+                    cache_size_ = max_size;
+                cache_alignment_ = detail::max_alignment < max_alignment ? detail::max_alignment : max_alignment;
+            }
+        }
+
+        /// \effects Returns all cached nodes to their arenas, destroys all arenas and frees the bookkeeping.
+        /// \requires No other thread may use it anymore.
+        ~per_cpu_allocator() FOONATHAN_NOEXCEPT
+        {
+            flush_caches();
+            for (std::size_t i = 0u; i != no_arenas_; ++i)
+                arenas_[i].~arena();
+            deallocate_caches();
+            deallocate_arenas();
+        }
+
+        /// @{
+        /// \effects A \ref per_cpu_allocator can neither be copied nor moved,
+        /// since other threads might be using it.
+        per_cpu_allocator(const per_cpu_allocator &) = delete;
+        per_cpu_allocator& operator=(const per_cpu_allocator &) = delete;
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} from the cache of the current processor.
+        /// If it is empty or the node is not cached,
+        /// allocates from the arena of the current processor
+        /// by locking its \c Mutex and forwarding to the \ref allocator_traits of the arena.
+        /// \returns The allocated node.
+        /// \throws Anything thrown by the arena's allocation function.
+        /// \note This function is thread-safe.
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            if (is_cached(size, alignment))
+            {
+                auto index = size_class(size);
+                if (auto mem = detail::percpu_pop(caches_ + index, no_arenas_, no_size_classes))
+                    return mem;
+                size = class_size(index);
+                alignment = cache_alignment_;
+            }
+
+            auto &a = local_arena();
+            std::lock_guard<mutex> lock(a.mutex_);
+            return traits::allocate_node(a.alloc, size, alignment);
+        }
+
+        /// \effects Allocates an \concept{concept_array,array} from the arena of the current processor
+        /// like \ref allocate_node().
+        /// \returns The allocated array.
+        /// \throws Anything thrown by the arena's allocation function.
+        /// \note This function is thread-safe.
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            auto &a = local_arena();
+            std::lock_guard<mutex> lock(a.mutex_);
+            return traits::allocate_array(a.alloc, count, size, alignment);
+        }
+
+        /// \effects Deallocates a \concept{concept_node,node} by putting it into the cache of the current processor.
+        /// If it is full or the node is not cached,
+        /// finds the arena that owns \c ptr, locks its \c Mutex and forwards to the \ref allocator_traits of the arena.
+        /// The arena of the current processor is checked first.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() with the same size and alignment.
+        /// \note This function is thread-safe.
+        void deallocate_node(void *ptr, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            if (is_cached(size, alignment))
+            {
+                auto index = size_class(size);
+                if (detail::percpu_push(caches_ + index, no_arenas_, no_size_classes, ptr))
+                    return;
+                size = class_size(index);
+                alignment = cache_alignment_;
+            }
+
+            with_owning_arena(ptr, [&](allocator_type &alloc)
+            {
+                traits::deallocate_node(alloc, ptr, size, alignment);
+            });
+        }
+
+        /// \effects Deallocates an \concept{concept_array,array} by finding the arena like \ref deallocate_node().
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same sizes.
+        /// \note This function is thread-safe.
+        void deallocate_array(void *ptr, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            with_owning_arena(ptr, [&](allocator_type &alloc)
+            {
+                traits::deallocate_array(alloc, ptr, count, size, alignment);
+            });
+        }
+
+        /// @{
+        /// \returns The maximum sizes and alignment as reported by the arenas.
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            return traits::max_node_size(arenas_[0].alloc);
+        }
+
+        std::size_t max_array_size() const FOONATHAN_NOEXCEPT
+        {
+            return traits::max_array_size(arenas_[0].alloc);
+        }
+
+        std::size_t max_alignment() const FOONATHAN_NOEXCEPT
+        {
+            return traits::max_alignment(arenas_[0].alloc);
+        }
+        /// @}
+
+        /// \returns The number of arenas, i.e. the number of configured processors.
+        std::size_t arena_count() const FOONATHAN_NOEXCEPT
+        {
+            return no_arenas_;
+        }
+
+        /// \returns The index of the arena used by the calling thread at this moment.
+        /// \note The thread might be migrated to a different processor immediately afterwards.
+        std::size_t local_arena_index() const FOONATHAN_NOEXCEPT
+        {
+            return detail::current_cpu() % no_arenas_;
+        }
+
+        /// \returns Whether or not node allocations can use the per-processor caches,
+        /// i.e. whether restartable sequences are available.
+        bool has_fast_path() const FOONATHAN_NOEXCEPT
+        {
+            return caches_ != nullptr;
+        }
+
+        /// \returns A reference to the arena with given index.
+        /// \requires \c i must be less than \ref arena_count().
+        /// No other thread may use the arena while the reference is being used.
+        allocator_type& get_arena(std::size_t i) FOONATHAN_NOEXCEPT
+        {
+            FOONATHAN_MEMORY_ASSERT(i < no_arenas_);
+            return arenas_[i].alloc;
+        }
+
+    private:
+        // size classes are multiples of the maximum alignment
+        static FOONATHAN_CONSTEXPR std::size_t no_size_classes = 16u;
+
+        struct arena
+        {
+            allocator_type alloc;
+            Mutex mutex_;
+            char padding[detail::cache_line_size];
+
+            template <typename ... Args>
+            explicit arena(const Args&... args)
+            : alloc(args...) {}
+        };
+
+        static default_allocator& bookkeeping_allocator() FOONATHAN_NOEXCEPT
+        {
+            static default_allocator alloc;
+            return alloc;
+        }
+
+        void deallocate_arenas() FOONATHAN_NOEXCEPT
+        {
+            allocator_traits<default_allocator>::deallocate_array(bookkeeping_allocator(), arenas_, no_arenas_,
+                                                                  sizeof(arena), FOONATHAN_ALIGNOF(arena));
+        }
+
+        // the stacks are aligned on a cache line, so the stacks of different processors do not share one
+        std::size_t cache_memory_size() const FOONATHAN_NOEXCEPT
+        {
+            return no_arenas_ * no_size_classes * sizeof(detail::percpu_stack) + detail::cache_line_size;
+        }
+
+        void allocate_caches()
+        {
+            cache_memory_ = allocator_traits<default_allocator>::
+                                allocate_array(bookkeeping_allocator(), cache_memory_size(),
+                                               1u, detail::max_alignment);
+            auto memory = static_cast<char*>(cache_memory_);
+            caches_ = reinterpret_cast<detail::percpu_stack*>(memory
+                        + detail::align_offset(memory, detail::cache_line_size));
+            for (std::size_t i = 0u; i != no_arenas_ * no_size_classes; ++i)
+                caches_[i].size = 0u;
+        }
+
+        void deallocate_caches() FOONATHAN_NOEXCEPT
+        {
+            if (cache_memory_)
+                allocator_traits<default_allocator>::deallocate_array(bookkeeping_allocator(), cache_memory_,
+                                                                      cache_memory_size(),
+                                                                      1u, detail::max_alignment);
+        }
+
+        void flush_caches() FOONATHAN_NOEXCEPT
+        {
+            if (!caches_)
+                return;
+            for (std::size_t cpu = 0u; cpu != no_arenas_; ++cpu)
+                for (std::size_t index = 0u; index != no_size_classes; ++index)
+                {
+                    auto &stack = caches_[cpu * no_size_classes + index];
+                    while (stack.size != 0u)
+                    {
+                        auto ptr = stack.slots[--stack.size];
+                        with_owning_arena(ptr, [&](allocator_type &alloc)
+                        {
+                            traits::deallocate_node(alloc, ptr, class_size(index), cache_alignment_);
+                        });
+                    }
+                }
+        }
+
+        bool is_cached(std::size_t size, std::size_t alignment) const FOONATHAN_NOEXCEPT
+        {
+            return size <= cache_size_ && alignment <= cache_alignment_;
+        }
+
+        static std::size_t size_class(std::size_t size) FOONATHAN_NOEXCEPT
+        {
+            return size == 0u ? 0u : (size - 1u) / detail::max_alignment;
+        }
+
+        // all nodes of a class are allocated with this size, so they can be reused for any size in it
+        std::size_t class_size(std::size_t index) const FOONATHAN_NOEXCEPT
+        {
+            auto size = (index + 1u) * detail::max_alignment;
+            return size < cache_size_ ? size : cache_size_;
+        }
+
+        arena& local_arena() const FOONATHAN_NOEXCEPT
+        {
+            return arenas_[local_arena_index()];
+        }
+
+        template <typename Func>
+        void with_owning_arena(void *ptr, Func f) const FOONATHAN_NOEXCEPT
+        {
+            auto local = local_arena_index();
+            for (std::size_t i = 0u; i != no_arenas_; ++i)
+            {
+                auto &a = arenas_[(local + i) % no_arenas_];
+                std::lock_guard<mutex> lock(a.mutex_);
+                if (traits::owns(a.alloc, ptr))
+                {
+                    f(a.alloc);
+                    return;
+                }
+            }
+            FOONATHAN_MEMORY_UNREACHABLE("pointer not allocated by any arena");
+        }
+
+        arena *arenas_;
+        void *cache_memory_;
+        detail::percpu_stack *caches_; // one stack per processor and size class, inside cache_memory_
+        std::size_t no_arenas_;
+        std::size_t cache_size_, cache_alignment_; // 0 if there are no caches
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_PER_CPU_ALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,232 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_RING_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_RING_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::ring_allocator.
+
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/block_list.hpp"
+#include "detail/ring_buffer.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that allocates in first-in-first-out (FIFO) order from ring buffers.
+    /// It allocates huge memory blocks serving as arena from a given \c RawAllocator defaulting to \ref default_allocator
+    /// and uses each of them as a ring buffer.
+    /// Allocation simply bumps the head of the current ring, wrapping around to the beginning when it reaches the end.
+    /// Deallocation can be done in any order, it marks the memory as free,
+    /// but memory is only reclaimed when the oldest allocation of the ring is deallocated.
+    /// If the current ring is full, an older ring without allocations is reused or the arena grows.<br>
+    /// This makes it ideal for streaming, where allocations of varying size are deallocated in roughly the same order.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator>
+    class ring_allocator
+    : FOONATHAN_EBO(detail::leak_checker<ring_allocator<default_allocator>>)
+    {
+        using leak_checker = detail::leak_checker<ring_allocator<default_allocator>>;
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using is_stateful = std::true_type;
+
+        /// \effects Creates it by giving it the size of the initial memory block and the implementation allocator.
+        /// It will allocate the initial memory block and uses it as the first ring.
+        explicit ring_allocator(std::size_t block_size, allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          block_list_(block_size, detail::move(allocator)),
+          rings_(nullptr), cur_(nullptr)
+        {
+            allocate_block();
+        }
+
+        /// \effects Destroys the \ref ring_allocator by returning all memory blocks,
+        /// regardless of properly deallocated back to the implementation allocator.
+        ~ring_allocator() FOONATHAN_NOEXCEPT = default;
+
+        /// @{
+        /// \effects Moving a \ref ring_allocator object transfers ownership over the rings,
+        /// i.e. the moved from allocator is completely empty and the new one has all its memory.
+        /// That means that it is not allowed to call \ref deallocate_node() on a moved-from allocator
+        /// even when passing it memory that was previously allocated by this object.
+        ring_allocator(ring_allocator &&other) FOONATHAN_NOEXCEPT
+        : leak_checker(detail::move(other)),
+          block_list_(detail::move(other.block_list_)),
+          rings_(other.rings_), cur_(other.cur_)
+        {
+            other.rings_ = other.cur_ = nullptr;
+        }
+
+        ring_allocator& operator=(ring_allocator &&other) FOONATHAN_NOEXCEPT
+        {
+            leak_checker::operator=(detail::move(other));
+            block_list_ = detail::move(other.block_list_);
+            rings_ = other.rings_;
+            cur_ = other.cur_;
+            other.rings_ = other.cur_ = nullptr;
+            return *this;
+        }
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} at the head of the current ring.
+        /// If there is not enough space, it switches to an older ring without allocations
+        /// or allocates a new memory block as ring.
+        /// \returns A block of at least \c size bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if \c size or \c alignment is too big.
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, next_capacity(), info());
+            detail::check_allocation_size(alignment, next_capacity(), info());
+
+            auto mem = cur_->buffer.allocate(size, alignment);
+            if (!mem)
+            {
+                // an empty ring is just as good as a new one
+                for (auto r = rings_; r; r = r->next)
+                    if (r != cur_ && r->buffer.empty())
+                    {
+                        mem = r->buffer.allocate(size, alignment);
+                        if (mem)
+                        {
+                            cur_ = r;
+                            break;
+                        }
+                    }
+
+                // the blocks grow, so eventually one will fit
+                while (!mem)
+                {
+                    allocate_block();
+                    mem = cur_->buffer.allocate(size, alignment);
+                }
+            }
+            this->on_allocate(size);
+            return mem;
+        }
+
+        /// \effects Allocates an \concept{concept_array,array} of nodes as a single block,
+        /// like \ref allocate_node().
+        /// \returns A block of at least <tt>count * size</tt> bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth
+        /// or \ref bad_allocation_size if the size or \c alignment is too big.
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            return allocate_node(count * size, alignment);
+        }
+
+        /// \effects Deallocates a \concept{concept_node,node} by marking it as free.
+        /// If it is the oldest allocation of its ring, the memory up to the next allocation still in use is reclaimed.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() on the same allocator,
+        /// i.e. either this allocator object or a new object created by moving this to it.
+        /// \note This is a linear operation in the number of rings if \c ptr is not in the current one.
+        void deallocate_node(void *ptr, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            auto r = cur_;
+            if (!r->buffer.owns(ptr))
+            {
+                r = rings_;
+                while (!r->buffer.owns(ptr))
+                    r = r->next;
+            }
+            r->buffer.deallocate(ptr);
+            this->on_deallocate(size);
+        }
+
+        /// \effects Deallocates an \concept{concept_array,array} like \ref deallocate_node().
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_array() on the same allocator.
+        void deallocate_array(void *ptr, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(ptr, count * size, alignment);
+        }
+
+        /// @{
+        /// \returns The maximum size and alignment which is \ref next_capacity(),
+        /// since the arena grows until a ring is big enough.
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            return next_capacity();
+        }
+
+        std::size_t max_array_size() const FOONATHAN_NOEXCEPT
+        {
+            return next_capacity();
+        }
+
+        std::size_t max_alignment() const FOONATHAN_NOEXCEPT
+        {
+            return next_capacity();
+        }
+        /// @}
+
+        /// \returns The amount of memory that can be reclaimed in the current ring.
+        /// \note An allocation may lead to a growth even if the capacity is big enough,
+        /// since the free memory is split at the end of the ring.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return cur_->buffer.capacity();
+        }
+
+        /// \returns The size of the next memory block after the arena grows.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.next_block_size();
+        }
+
+        /// \returns Whether or not the memory pointed to by \c ptr was allocated from the arena of this allocator,
+        /// i.e. lies in one of the memory blocks currently used.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            return block_list_.owns(ptr);
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return block_list_.get_allocator();
+        }
+
+    private:
+        // stored at the beginning of each memory block
+        struct ring
+        {
+            detail::fixed_ring_buffer buffer;
+            ring *next;
+        };
+
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::ring_allocator", this};
+        }
+
+        void allocate_block()
+        {
+            auto block = block_list_.allocate();
+            FOONATHAN_MEMORY_ASSERT(block.size > sizeof(ring));
+            FOONATHAN_MEMORY_ASSERT(detail::is_aligned(block.memory, FOONATHAN_ALIGNOF(ring)));
+
+            auto memory = static_cast<char*>(block.memory);
+            auto r = ::new(static_cast<void*>(memory)) ring;
+            r->buffer = detail::fixed_ring_buffer(memory + sizeof(ring), block.size - sizeof(ring));
+            r->next = rings_;
+            rings_ = cur_ = r;
+        }
+
+        detail::block_list<allocator_type> block_list_;
+        ring *rings_, *cur_;
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_RING_ALLOCATOR_HPP_INCLUDED
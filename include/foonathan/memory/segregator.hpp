@@ -0,0 +1,151 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_SEGREGATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SEGREGATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::segregator.
+
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A \concept{concept_rawallocator,RawAllocator} that dispatches allocations to one of two allocators depending on their size.
+    /// All allocations of at most \c Threshold bytes are done by the \c SmallRawAllocator,
+    /// all bigger ones by the \c LargeRawAllocator.
+    /// For arrays the size is the total size, i.e. <tt>count * size</tt>.
+    /// The threshold is a compile-time constant, so there is no indirection besides a single comparison.
+    /// A typical use is routing small nodes to a \ref memory_pool_collection and big buffers to the \ref heap_allocator.
+    /// \ingroup memory
+    template <std::size_t Threshold, class SmallRawAllocator, class LargeRawAllocator>
+    class segregator
+    : FOONATHAN_EBO(detail::ebo_storage<0, typename allocator_traits<SmallRawAllocator>::allocator_type>,
+                    detail::ebo_storage<1, typename allocator_traits<LargeRawAllocator>::allocator_type>)
+    {
+        using small_traits = allocator_traits<SmallRawAllocator>;
+        using large_traits = allocator_traits<LargeRawAllocator>;
+        using small_storage = detail::ebo_storage<0, typename small_traits::allocator_type>;
+        using large_storage = detail::ebo_storage<1, typename large_traits::allocator_type>;
+    public:
+        using small_allocator_type = typename small_traits::allocator_type;
+        using large_allocator_type = typename large_traits::allocator_type;
+        using is_stateful = std::integral_constant<bool,
+                                small_traits::is_stateful::value || large_traits::is_stateful::value>;
+
+        /// \effects Creates it by giving it the two allocators.
+        explicit segregator(small_allocator_type small = small_allocator_type(),
+                            large_allocator_type large = large_allocator_type())
+        : small_storage(detail::move(small)), large_storage(detail::move(large)) {}
+
+        /// @{
+        /// \effects Allocates a \concept{concept_node,node} or \concept{concept_array,array}
+        /// from the small allocator if its size is at most \c Threshold, from the large allocator otherwise.
+        /// \returns The result of the chosen allocator.
+        /// \throws Anything thrown by the chosen allocator.
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            if (is_small(size))
+                return small_traits::allocate_node(get_small_allocator(), size, alignment);
+            return large_traits::allocate_node(get_large_allocator(), size, alignment);
+        }
+
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            if (is_small(count * size))
+                return small_traits::allocate_array(get_small_allocator(), count, size, alignment);
+            return large_traits::allocate_array(get_large_allocator(), count, size, alignment);
+        }
+        /// @}
+
+        /// @{
+        /// \effects Deallocates a \concept{concept_node,node} or \concept{concept_array,array}
+        /// by the same allocator that allocated it, which is determined by the size.
+        void deallocate_node(void *ptr, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            if (is_small(size))
+                small_traits::deallocate_node(get_small_allocator(), ptr, size, alignment);
+            else
+                large_traits::deallocate_node(get_large_allocator(), ptr, size, alignment);
+        }
+
+        void deallocate_array(void *ptr, std::size_t count,
+                              std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            if (is_small(count * size))
+                small_traits::deallocate_array(get_small_allocator(), ptr, count, size, alignment);
+            else
+                large_traits::deallocate_array(get_large_allocator(), ptr, count, size, alignment);
+        }
+        /// @}
+
+        /// @{
+        /// \returns The maximum size of the large allocator.
+        std::size_t max_node_size() const
+        {
+            return large_traits::max_node_size(get_large_allocator());
+        }
+
+        std::size_t max_array_size() const
+        {
+            return large_traits::max_array_size(get_large_allocator());
+        }
+        /// @}
+
+        /// \returns The minimum of the maximum alignments of the two allocators,
+        /// since either of them might be chosen.
+        std::size_t max_alignment() const
+        {
+            auto small = small_traits::max_alignment(get_small_allocator());
+            auto large = large_traits::max_alignment(get_large_allocator());
+            return small < large ? small : large;
+        }
+
+        /// \returns Whether or not one of the two allocators owns the memory pointed to by \c ptr.
+        /// \requires Both allocators must support \ref allocator_traits::owns().
+        bool owns(const void *ptr) const
+        {
+            return small_traits::owns(get_small_allocator(), ptr)
+                || large_traits::owns(get_large_allocator(), ptr);
+        }
+
+        /// @{
+        /// \returns A (\c const) reference to the allocator used for small allocations.
+        small_allocator_type& get_small_allocator() FOONATHAN_NOEXCEPT
+        {
+            return small_storage::get();
+        }
+
+        const small_allocator_type& get_small_allocator() const FOONATHAN_NOEXCEPT
+        {
+            return small_storage::get();
+        }
+        /// @}
+
+        /// @{
+        /// \returns A (\c const) reference to the allocator used for large allocations.
+        large_allocator_type& get_large_allocator() FOONATHAN_NOEXCEPT
+        {
+            return large_storage::get();
+        }
+
+        const large_allocator_type& get_large_allocator() const FOONATHAN_NOEXCEPT
+        {
+            return large_storage::get();
+        }
+        /// @}
+
+    private:
+        static bool is_small(std::size_t size) FOONATHAN_NOEXCEPT
+        {
+            return size <= Threshold;
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_SEGREGATOR_HPP_INCLUDED
@@ -0,0 +1,346 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_SHARDED_POOL_COLLECTION_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SHARDED_POOL_COLLECTION_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::sharded_pool_collection and its \ref foonathan::memory::allocator_traits specialization.
+
+#include "config.hpp"
+#if !FOONATHAN_HAS_THREADING_SUPPORT
+    #error "This header is only available if there is threading support."
+#endif
+
+#include <climits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/block_map.hpp"
+#include "detail/cpu.hpp"
+#include "allocator_traits.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "memory_pool_collection.hpp"
+#include "tracking.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that splits a \ref memory_pool_collection into multiple independent shards
+    /// to reduce contention when shared between threads.
+    /// Each of the \c NoShards shards is a complete \ref memory_pool_collection with its own arena and its own \c Mutex.
+    /// A thread always allocates from the same shard, the threads are distributed over the shards in a round-robin fashion.
+    /// Deallocation finds the shard whose memory blocks contain the pointer in a map of all blocks sorted by address,
+    /// which is looked up without locking, and then locks only that shard.<br>
+    /// As long as there are not more threads than shards, no two threads ever wait on the same lock for allocation,
+    /// while each operation is still protected and memory can be deallocated from any thread.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    template <class PoolType, class BucketDistribution, std::size_t NoShards = 8u,
+              class RawAllocator = default_allocator, class Mutex = std::mutex>
+    class sharded_pool_collection
+    : FOONATHAN_EBO(detail::concurrent_leak_checker<sharded_pool_collection<node_pool, identity_buckets, 8u,
+                                                                            default_allocator, std::mutex>>)
+    {
+        static_assert(NoShards > 0u, "must have at least one shard");
+
+        using leak_checker = detail::concurrent_leak_checker<sharded_pool_collection<node_pool, identity_buckets, 8u,
+                                                                                     default_allocator, std::mutex>>;
+
+        // registers the memory blocks of a shard in the block map
+        struct block_tracker
+        {
+            detail::block_map *map;
+            std::size_t shard;
+
+            void on_allocator_growth(void *memory, std::size_t size) FOONATHAN_NOEXCEPT
+            {
+                map->insert(memory, size, shard);
+            }
+
+            void on_allocator_shrinking(void *memory, std::size_t) FOONATHAN_NOEXCEPT
+            {
+                map->erase(memory);
+            }
+        };
+
+    public:
+        using collection_type = memory_pool_collection<PoolType, BucketDistribution,
+                                                       tracked_impl_allocator<block_tracker, RawAllocator>>;
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using pool_type = PoolType;
+        using bucket_distribution = BucketDistribution;
+        using mutex = Mutex;
+
+        /// \effects Creates it by giving it the maximum node size it should be able to allocate
+        /// and the size of the initial memory block of each shard.
+        /// Each shard gets its own \ref memory_pool_collection created with these arguments
+        /// and a default constructed implementation allocator.
+        /// \throws Anything thrown by the constructor of \ref memory_pool_collection.
+        /// \requires \c max_node_size must be a valid \concept{concept_node,node} size,
+        /// \c block_size must be non-zero and \c allocator_type must be default constructible.
+        sharded_pool_collection(std::size_t max_node_size, std::size_t block_size)
+        : leak_checker(info().name),
+          block_entries_(), blocks_(block_entries_, NoShards * max_blocks)
+        {
+            // destroys the already created shards if a constructor throws
+            struct construction_guard
+            {
+                sharded_pool_collection *self;
+                std::size_t no_created;
+
+                ~construction_guard() FOONATHAN_NOEXCEPT
+                {
+                    while (no_created-- != 0u)
+                        self->get_shard(no_created).~shard();
+                }
+            } guard{this, 0u};
+
+            for (; guard.no_created != NoShards; ++guard.no_created)
+                ::new(static_cast<void*>(&storage_[guard.no_created]))
+                        shard(blocks_, guard.no_created, max_node_size, block_size);
+            guard.no_created = 0u;
+        }
+
+        /// \effects Destroys all shards, returning all memory blocks back to the implementation allocator.
+        /// \requires No other thread may use it anymore.
+        ~sharded_pool_collection() FOONATHAN_NOEXCEPT
+        {
+            for (std::size_t i = 0u; i != NoShards; ++i)
+                get_shard(i).~shard();
+        }
+
+        /// @{
+        /// \effects A \ref sharded_pool_collection can neither be copied nor moved,
+        /// since other threads might be using it.
+        sharded_pool_collection(const sharded_pool_collection &) = delete;
+        sharded_pool_collection& operator=(const sharded_pool_collection &) = delete;
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} of given size from the shard of the calling thread
+        /// by locking its \c Mutex and calling \ref memory_pool_collection::allocate_node().
+        /// \returns A \concept{concept_node,node} of given size suitable aligned,
+        /// i.e. suitable for any type where <tt>sizeof(T) < node_size</tt>.
+        /// \throws Anything thrown by the implementation allocator if a growth is needed.
+        /// \requires \c node_size must be a valid \concept{concept_node,node size} less than or equal to \ref max_node_size().
+        /// \note This function is thread-safe.
+        void* allocate_node(std::size_t node_size)
+        {
+            auto &s = local_shard();
+            std::lock_guard<mutex> lock(s.mutex_);
+            return s.collection.allocate_node(node_size);
+        }
+
+        /// \effects Allocates an \concept{concept_array,array} of nodes from the shard of the calling thread
+        /// by locking its \c Mutex and calling \ref memory_pool_collection::allocate_array().
+        /// \returns An array of \c n nodes of size \c node_size suitable aligned.
+        /// \throws Anything thrown by \ref memory_pool_collection::allocate_array().
+        /// \requires The \c PoolType must support array allocations, otherwise the body of this function will not compile.
+        /// \c count must be valid \concept{concept_array,array count} and
+        /// \c node_size must be valid \concept{concept_node,node size} less than or equal to \ref max_node_size().
+        /// \note This function is thread-safe.
+        void* allocate_array(std::size_t count, std::size_t node_size)
+        {
+            auto &s = local_shard();
+            std::lock_guard<mutex> lock(s.mutex_);
+            return s.collection.allocate_array(count, node_size);
+        }
+
+        /// \effects Deallocates a \concept{concept_node,node} by finding the shard whose memory blocks contain \c ptr,
+        /// locking its \c Mutex and calling \ref memory_pool_collection::deallocate_node().
+        /// Finding the shard is a binary search in the memory blocks of all shards.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() with the same size on this allocator.
+        /// \note This function is thread-safe.
+        void deallocate_node(void *ptr, std::size_t node_size) FOONATHAN_NOEXCEPT
+        {
+            with_owning_shard(ptr, [&](collection_type &collection)
+            {
+                collection.deallocate_node(ptr, node_size);
+            });
+        }
+
+        /// \effects Deallocates an \concept{concept_array,array} by finding the shard like \ref deallocate_node()
+        /// and calling \ref memory_pool_collection::deallocate_array().
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same sizes on this allocator.
+        /// \note This function is thread-safe.
+        void deallocate_array(void *ptr, std::size_t count, std::size_t node_size) FOONATHAN_NOEXCEPT
+        {
+            with_owning_shard(ptr, [&](collection_type &collection)
+            {
+                collection.deallocate_array(ptr, count, node_size);
+            });
+        }
+
+        /// \returns The maximum node size for which is a free list.
+        /// This is the value passed to it in the constructor.
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            // same for all shards and never changed
+            return get_shard(0u).collection.max_node_size();
+        }
+
+        /// \returns An upper bound for the size of the next memory block of any shard.
+        /// \note This function is thread-safe.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            std::size_t result = 0u;
+            for (std::size_t i = 0u; i != NoShards; ++i)
+            {
+                auto &s = get_shard(i);
+                std::lock_guard<mutex> lock(s.mutex_);
+                auto cap = s.collection.next_capacity();
+                if (cap > result)
+                    result = cap;
+            }
+            return result;
+        }
+
+        /// \returns The number of shards, i.e. \c NoShards.
+        static FOONATHAN_CONSTEXPR_FNC std::size_t shard_count() FOONATHAN_NOEXCEPT
+        {
+            return NoShards;
+        }
+
+        /// \returns The index of the shard used by the calling thread.
+        std::size_t local_shard_index() const FOONATHAN_NOEXCEPT
+        {
+            return detail::thread_index() % NoShards;
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::sharded_pool_collection", this};
+        }
+
+        // the block size doubles with every block a shard allocates, so it cannot have more than that
+        static FOONATHAN_CONSTEXPR std::size_t max_blocks = sizeof(std::size_t) * CHAR_BIT;
+
+        struct shard
+        {
+            block_tracker tracker;
+            collection_type collection;
+            mutable Mutex mutex_;
+            char padding[detail::cache_line_size];
+
+            shard(detail::block_map &blocks, std::size_t index,
+                  std::size_t max_node_size, std::size_t block_size)
+            : tracker{&blocks, index},
+              collection(max_node_size, block_size,
+                         tracked_impl_allocator<block_tracker, RawAllocator>(tracker)) {}
+        };
+
+        shard& get_shard(std::size_t i) const FOONATHAN_NOEXCEPT
+        {
+            return *static_cast<shard*>(static_cast<void*>(&storage_[i]));
+        }
+
+        shard& local_shard() const FOONATHAN_NOEXCEPT
+        {
+            return get_shard(local_shard_index());
+        }
+
+        template <typename Func>
+        void with_owning_shard(void *ptr, Func f) const FOONATHAN_NOEXCEPT
+        {
+            auto index = blocks_.find(ptr);
+            if (index == detail::block_map::no_owner)
+            {
+                FOONATHAN_MEMORY_UNREACHABLE("pointer not allocated by any shard");
+                return;
+            }
+
+            auto &s = get_shard(index);
+            std::lock_guard<mutex> lock(s.mutex_);
+            f(s.collection);
+        }
+
+        detail::block_map::entry block_entries_[NoShards * max_blocks];
+        detail::block_map blocks_;
+        mutable typename std::aligned_storage<sizeof(shard), FOONATHAN_ALIGNOF(shard)>::type storage_[NoShards];
+
+        friend allocator_traits<sharded_pool_collection<PoolType, BucketDistribution, NoShards, RawAllocator, Mutex>>;
+    };
+
+    /// Specialization of the \ref allocator_traits for \ref sharded_pool_collection classes.
+    /// All functions are thread-safe.
+    /// \note It is not allowed to mix calls through the specialization and through the member functions,
+    /// i.e. \ref sharded_pool_collection::allocate_node() and this \c allocate_node().
+    /// \ingroup memory
+    template <class Pool, class BucketDist, std::size_t NoShards, class RawAllocator, class Mutex>
+    class allocator_traits<sharded_pool_collection<Pool, BucketDist, NoShards, RawAllocator, Mutex>>
+    {
+    public:
+        using allocator_type = sharded_pool_collection<Pool, BucketDist, NoShards, RawAllocator, Mutex>;
+        using is_stateful = std::true_type;
+
+        /// \returns The result of \ref sharded_pool_collection::allocate_node().
+        /// \throws Anything thrown by the pool allocation function
+        /// or \ref bad_allocation_size if \c size / \c alignment exceeds \ref max_node_size() / the suitable alignment value,
+        /// i.e. the node is over-aligned.
+        static void* allocate_node(allocator_type &state,
+                                   std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_node_size(state), state.info());
+            detail::check_allocation_size(alignment, detail::alignment_for(size), state.info());
+            auto mem = state.allocate_node(size);
+            state.on_allocate(size);
+            return mem;
+        }
+
+        /// \returns The result of \ref sharded_pool_collection::allocate_array().
+        /// \throws Anything thrown by the pool allocation function.
+        /// \requires The \ref sharded_pool_collection has to support array allocations.
+        static void* allocate_array(allocator_type &state, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_node_size(state), state.info());
+            detail::check_allocation_size(alignment, max_alignment(state), state.info());
+            auto mem = state.allocate_array(count, size);
+            state.on_allocate(count * size);
+            return mem;
+        }
+
+        /// \effects Calls \ref sharded_pool_collection::deallocate_node().
+        static void deallocate_node(allocator_type &state,
+                    void *node, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_node(node, size);
+            state.on_deallocate(size);
+        }
+
+        /// \effects Calls \ref sharded_pool_collection::deallocate_array().
+        /// \requires The \ref sharded_pool_collection has to support array allocations.
+        static void deallocate_array(allocator_type &state,
+                    void *array, std::size_t count, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_array(array, count, size);
+            state.on_deallocate(count * size);
+        }
+
+        /// \returns The maximum size of each node which is \ref sharded_pool_collection::max_node_size().
+        static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.max_node_size();
+        }
+
+        /// \returns An upper bound on the maximum array size which is \ref sharded_pool_collection::next_capacity().
+        static std::size_t max_array_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.next_capacity();
+        }
+
+        /// \returns Just \c alignof(std::max_align_t) since the actual maximum alignment depends on the node size,
+        /// the nodes must not be over-aligned.
+        static std::size_t max_alignment(const allocator_type &) FOONATHAN_NOEXCEPT
+        {
+            return detail::max_alignment;
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_SHARDED_POOL_COLLECTION_HPP_INCLUDED
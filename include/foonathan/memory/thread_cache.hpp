@@ -0,0 +1,345 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_THREAD_CACHE_HPP_INCLUDED
+#define FOONATHAN_MEMORY_THREAD_CACHE_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::thread_cache and its \ref foonathan::memory::allocator_traits specialization.
+
+#include "config.hpp"
+#if !FOONATHAN_HAS_THREADING_SUPPORT
+    #error "This header is only available if there is threading support."
+#endif
+
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "allocator_storage.hpp"
+#include "allocator_traits.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "memory_pool_collection.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} that caches \concept{concept_node,nodes}
+    /// of a \ref memory_pool_collection shared between multiple threads.
+    /// The shared collection - the depot - is stored in a \ref thread_safe_allocator.
+    /// Each thread creates its own \ref thread_cache referring to the depot.
+    /// It keeps a magazine of free nodes for each bucket of the depot, as defined in the \c BucketDistribution.
+    /// Allocation and deallocation only use the magazine and do not need any synchronization.
+    /// If a magazine is empty, it is filled with half of its maximum size by locking the depot once;
+    /// if it is full, half of it is returned to the depot the same way.<br>
+    /// A \ref thread_cache object itself must not be shared between threads,
+    /// but memory allocated by one \ref thread_cache can be deallocated by any other one using the same depot.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    template <class PoolType, class BucketDistribution,
+              class RawAllocator = default_allocator, class Mutex = std::mutex>
+    class thread_cache
+    {
+        using free_list = typename PoolType::type;
+        using access_policy = typename BucketDistribution::type;
+
+    public:
+        using depot_type = thread_safe_allocator<memory_pool_collection<PoolType, BucketDistribution, RawAllocator>, Mutex>;
+        using pool_type = PoolType;
+        using bucket_distribution = BucketDistribution;
+
+        /// The default maximum number of nodes in each magazine.
+        static FOONATHAN_CONSTEXPR std::size_t default_magazine_size = 64u;
+
+        /// \effects Creates it by giving it the depot and the maximum number of nodes cached for each bucket.
+        /// All magazines are initially empty.
+        /// \throws Anything thrown by the \ref default_allocator when allocating the magazine bookkeeping.
+        /// \requires \c magazine_size must not be zero.
+        /// The depot must live longer than the \ref thread_cache.
+        explicit thread_cache(depot_type &depot,
+                              std::size_t magazine_size = default_magazine_size)
+        : depot_(&depot), magazines_(nullptr),
+          no_magazines_(index_from_size(depot.get_allocator().max_node_size()) - min_size_index + 1),
+          magazine_size_(magazine_size)
+        {
+            FOONATHAN_MEMORY_ASSERT_MSG(magazine_size_ != 0u, "magazine size must not be zero");
+            magazines_ = static_cast<magazine*>(allocator_traits<default_allocator>::
+                            allocate_array(bookkeeping_allocator(), no_magazines_,
+                                           sizeof(magazine), FOONATHAN_ALIGNOF(magazine)));
+            for (std::size_t i = 0u; i != no_magazines_; ++i)
+                ::new(static_cast<void*>(magazines_ + i)) magazine();
+        }
+
+        /// \effects Returns all cached nodes back to the depot.
+        ~thread_cache() FOONATHAN_NOEXCEPT
+        {
+            if (!magazines_)
+                return;
+            flush();
+            allocator_traits<default_allocator>::deallocate_array(bookkeeping_allocator(), magazines_, no_magazines_,
+                                                                  sizeof(magazine), FOONATHAN_ALIGNOF(magazine));
+        }
+
+        /// @{
+        /// \effects Moving a \ref thread_cache transfers ownership over the cached nodes.
+        /// The moved-from object must not be used for allocation anymore.
+        thread_cache(thread_cache &&other) FOONATHAN_NOEXCEPT
+        : depot_(other.depot_), magazines_(other.magazines_),
+          no_magazines_(other.no_magazines_), magazine_size_(other.magazine_size_)
+        {
+            other.magazines_ = nullptr;
+            other.no_magazines_ = 0u;
+        }
+
+        thread_cache& operator=(thread_cache &&other) FOONATHAN_NOEXCEPT
+        {
+            thread_cache tmp(detail::move(other));
+            detail::adl_swap(depot_, tmp.depot_);
+            detail::adl_swap(magazines_, tmp.magazines_);
+            detail::adl_swap(no_magazines_, tmp.no_magazines_);
+            detail::adl_swap(magazine_size_, tmp.magazine_size_);
+            return *this;
+        }
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} of given size
+        /// by removing it from the magazine of the appropriate bucket.
+        /// If the magazine is empty, it will be refilled from the depot first.
+        /// \returns A \concept{concept_node,node} of given size suitable aligned,
+        /// i.e. suitable for any type where <tt>sizeof(T) < node_size</tt>.
+        /// \throws Anything thrown by the depot if it needs to grow.
+        /// \requires \c node_size must be a valid \concept{concept_node,node size} less than or equal to \ref max_node_size().
+        void* allocate_node(std::size_t node_size)
+        {
+            auto &mag = get(node_size);
+            if (!mag.first)
+                fill(mag, node_size);
+            return mag.pop();
+        }
+
+        /// \effects Deallocates a \concept{concept_node,node} by putting it into the magazine of the appropriate bucket.
+        /// If the magazine is full, half of it will be returned to the depot first.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() with the same size
+        /// on a \ref thread_cache using the same depot.
+        void deallocate_node(void *ptr, std::size_t node_size) FOONATHAN_NOEXCEPT
+        {
+            auto &mag = get(node_size);
+            if (mag.count == magazine_size_)
+                drain(mag, node_size, (magazine_size_ + 1) / 2);
+            mag.push(ptr);
+        }
+
+        /// \effects Returns all cached nodes back to the depot by locking it once.
+        void flush() FOONATHAN_NOEXCEPT
+        {
+            auto depot = depot_->lock();
+            for (std::size_t i = 0u; i != no_magazines_; ++i)
+            {
+                auto size = size_from_index(i + min_size_index);
+                auto &mag = magazines_[i];
+                while (mag.first)
+                    depot->deallocate_node(mag.pop(), size);
+            }
+        }
+
+        /// \returns The number of nodes currently cached for nodes of given size.
+        std::size_t cached(std::size_t node_size) const FOONATHAN_NOEXCEPT
+        {
+            return get(node_size).count;
+        }
+
+        /// \returns The maximum number of nodes in each magazine.
+        /// This is the value passed to it in the constructor.
+        std::size_t magazine_size() const FOONATHAN_NOEXCEPT
+        {
+            return magazine_size_;
+        }
+
+        /// \returns The maximum node size which is the maximum node size of the depot.
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            return depot_->get_allocator().max_node_size();
+        }
+
+        /// \returns A reference to the depot.
+        depot_type& get_depot() const FOONATHAN_NOEXCEPT
+        {
+            return *depot_;
+        }
+
+    private:
+        // intrusive list of cached nodes
+        struct magazine
+        {
+            char *first;
+            std::size_t count;
+
+            magazine() FOONATHAN_NOEXCEPT
+            : first(nullptr), count(0u) {}
+
+            void push(void *ptr) FOONATHAN_NOEXCEPT
+            {
+                auto node = static_cast<char*>(ptr);
+                *reinterpret_cast<char**>(node) = first;
+                first = node;
+                ++count;
+            }
+
+            void* pop() FOONATHAN_NOEXCEPT
+            {
+                FOONATHAN_MEMORY_ASSERT(first);
+                auto node = first;
+                first = *reinterpret_cast<char**>(node);
+                --count;
+                return node;
+            }
+        };
+
+        // every node must be able to store the link
+        static const std::size_t min_size_index;
+
+        static std::size_t index_from_size(std::size_t size) FOONATHAN_NOEXCEPT
+        {
+            return access_policy::index_from_size(size);
+        }
+
+        static std::size_t size_from_index(std::size_t index) FOONATHAN_NOEXCEPT
+        {
+            return access_policy::size_from_index(index);
+        }
+
+        static default_allocator& bookkeeping_allocator() FOONATHAN_NOEXCEPT
+        {
+            static default_allocator alloc;
+            return alloc;
+        }
+
+        magazine& get(std::size_t node_size) const FOONATHAN_NOEXCEPT
+        {
+            auto i = index_from_size(node_size);
+            if (i < min_size_index)
+                i = min_size_index;
+            FOONATHAN_MEMORY_ASSERT(i - min_size_index < no_magazines_);
+            return magazines_[i - min_size_index];
+        }
+
+        // the size used for the depot, it is the same bucket as node_size
+        static std::size_t bucket_size(std::size_t node_size) FOONATHAN_NOEXCEPT
+        {
+            auto i = index_from_size(node_size);
+            return size_from_index(i < min_size_index ? min_size_index : i);
+        }
+
+        void fill(magazine &mag, std::size_t node_size)
+        {
+            auto size = bucket_size(node_size);
+            auto no_nodes = (magazine_size_ + 1) / 2;
+
+            auto depot = depot_->lock();
+            for (std::size_t i = 0u; i != no_nodes; ++i)
+                mag.push(depot->allocate_node(size));
+        }
+
+        void drain(magazine &mag, std::size_t node_size, std::size_t no_nodes) FOONATHAN_NOEXCEPT
+        {
+            auto size = bucket_size(node_size);
+
+            auto depot = depot_->lock();
+            for (std::size_t i = 0u; i != no_nodes && mag.first; ++i)
+                depot->deallocate_node(mag.pop(), size);
+        }
+
+        depot_type *depot_;
+        magazine *magazines_;
+        std::size_t no_magazines_, magazine_size_;
+
+        friend allocator_traits<thread_cache<PoolType, BucketDistribution, RawAllocator, Mutex>>;
+    };
+
+    template <class PoolType, class BucketDistribution, class RawAllocator, class Mutex>
+    FOONATHAN_CONSTEXPR std::size_t thread_cache<PoolType, BucketDistribution, RawAllocator, Mutex>::default_magazine_size;
+
+    template <class PoolType, class BucketDistribution, class RawAllocator, class Mutex>
+    const std::size_t thread_cache<PoolType, BucketDistribution, RawAllocator, Mutex>::min_size_index
+        = BucketDistribution::type::index_from_size(PoolType::type::min_element_size > sizeof(char*)
+                                                    ? PoolType::type::min_element_size : sizeof(char*));
+
+    /// Specialization of the \ref allocator_traits for \ref thread_cache classes.
+    /// \note It is not allowed to mix calls through the specialization and through the member functions,
+    /// i.e. \ref thread_cache::allocate_node() and this \c allocate_node().
+    /// \ingroup memory
+    template <class PoolType, class BucketDistribution, class RawAllocator, class Mutex>
+    class allocator_traits<thread_cache<PoolType, BucketDistribution, RawAllocator, Mutex>>
+    {
+        using depot_traits = allocator_traits<typename thread_cache<PoolType, BucketDistribution,
+                                                                   RawAllocator, Mutex>::depot_type>;
+    public:
+        using allocator_type = thread_cache<PoolType, BucketDistribution, RawAllocator, Mutex>;
+        using is_stateful = std::true_type;
+
+        /// \returns The result of \ref thread_cache::allocate_node().
+        /// \throws Anything thrown by the depot allocation function
+        /// or \ref bad_allocation_size if \c size / \c alignment exceeds \ref max_node_size() / the suitable alignment value,
+        /// i.e. the node is over-aligned.
+        static void* allocate_node(allocator_type &state,
+                                   std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_node_size(state), info(state));
+            detail::check_allocation_size(alignment, detail::alignment_for(size), info(state));
+            return state.allocate_node(size);
+        }
+
+        /// \effects Forwards to the depot, arrays are not cached.
+        /// \returns The result of the \ref allocator_traits of the depot.
+        /// \throws Anything thrown by it.
+        static void* allocate_array(allocator_type &state, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+        {
+            return depot_traits::allocate_array(state.get_depot(), count, size, alignment);
+        }
+
+        /// \effects Calls \ref thread_cache::deallocate_node().
+        static void deallocate_node(allocator_type &state,
+                    void *node, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            state.deallocate_node(node, size);
+        }
+
+        /// \effects Forwards to the depot, arrays are not cached.
+        static void deallocate_array(allocator_type &state,
+                    void *array, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            depot_traits::deallocate_array(state.get_depot(), array, count, size, alignment);
+        }
+
+        /// \returns The maximum size of each node which is \ref thread_cache::max_node_size().
+        static std::size_t max_node_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return state.max_node_size();
+        }
+
+        /// \returns The maximum array size of the depot.
+        static std::size_t max_array_size(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return depot_traits::max_array_size(state.get_depot());
+        }
+
+        /// \returns Just \c alignof(std::max_align_t) since the actual maximum alignment depends on the node size,
+        /// the nodes must not be over-aligned.
+        static std::size_t max_alignment(const allocator_type &) FOONATHAN_NOEXCEPT
+        {
+            return detail::max_alignment;
+        }
+
+    private:
+        static allocator_info info(const allocator_type &state) FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::thread_cache", &state};
+        }
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_THREAD_CACHE_HPP_INCLUDED
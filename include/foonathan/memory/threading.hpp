@@ -6,7 +6,7 @@
 #define FOONATHAN_MEMORY_THREADING_HPP_INCLUDED
 
 /// \file
-/// The \ref foonathan::memory::default_mutex.
+/// The \ref foonathan::memory::default_mutex and other \c Mutex types.
 
 #include <type_traits>
 
@@ -18,6 +18,15 @@
     #include <mutex>
 #endif
 
+#if FOONATHAN_HAS_THREADING_SUPPORT
+    #include <atomic>
+    #include <thread>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    #include <intrin.h>
+#endif
+
 namespace foonathan { namespace memory
 {
     /// A dummy \c Mutex class that does not lock anything.
@@ -37,6 +46,149 @@ namespace foonathan { namespace memory
         {}
     };
 
+#if FOONATHAN_HAS_THREADING_SUPPORT
+    namespace detail
+    {
+        // hint to the processor that this is a spin-wait loop
+        inline void spin_pause() FOONATHAN_NOEXCEPT
+        {
+        #if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+            __builtin_ia32_pause();
+        #elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+            _mm_pause();
+        #endif
+        }
+
+        // spins with exponential backoff, starting with a single pause
+        // after the maximum is reached it yields the time slice instead
+        class spin_backoff
+        {
+        public:
+            spin_backoff() FOONATHAN_NOEXCEPT
+            : count_(1u) {}
+
+            void operator()() FOONATHAN_NOEXCEPT
+            {
+                if (count_ <= max_count)
+                {
+                    for (auto i = 0u; i != count_; ++i)
+                        spin_pause();
+                    count_ *= 2u;
+                }
+                else
+                    std::this_thread::yield();
+            }
+
+            // whether or not the maximum backoff has been reached
+            bool saturated() const FOONATHAN_NOEXCEPT
+            {
+                return count_ > max_count;
+            }
+
+        private:
+            static FOONATHAN_CONSTEXPR unsigned max_count = 64u;
+            unsigned count_;
+        };
+    } // namespace detail
+
+    /// A \c Mutex that never blocks but busy-waits until the lock can be acquired.
+    /// It uses a test-and-test-and-set loop with exponential backoff,
+    /// so waiting threads do not write to the shared cache line until it appears to be unlocked.<br>
+    /// This is faster than \c std::mutex if the critical section is very short,
+    /// e.g. a single free list operation of a \ref memory_pool stored in a \ref thread_safe_allocator.
+    /// It is slow if the lock is held for a long time or there are more threads than cores.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    class spin_mutex
+    {
+    public:
+        spin_mutex() FOONATHAN_NOEXCEPT
+        : locked_(false) {}
+
+        spin_mutex(const spin_mutex &) = delete;
+        spin_mutex& operator=(const spin_mutex &) = delete;
+
+        void lock() FOONATHAN_NOEXCEPT
+        {
+            while (locked_.exchange(true, std::memory_order_acquire))
+            {
+                detail::spin_backoff backoff;
+                do
+                {
+                    backoff();
+                } while (locked_.load(std::memory_order_relaxed));
+            }
+        }
+
+        bool try_lock() FOONATHAN_NOEXCEPT
+        {
+            return !locked_.load(std::memory_order_relaxed)
+                && !locked_.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock() FOONATHAN_NOEXCEPT
+        {
+            locked_.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<bool> locked_;
+    };
+
+    /// A \c Mutex that first spins and then blocks.
+    /// It tries to acquire the lock with exponential backoff for a short time like \ref spin_mutex,
+    /// if it did not succeed the thread is suspended on a \c std::mutex.
+    /// While spinning it only reads a flag telling whether the mutex is locked
+    /// and tries to acquire the \c std::mutex only once the flag is cleared,
+    /// so waiting threads do not write to the shared cache line.<br>
+    /// This gives the speed of a spin lock for short critical sections
+    /// without wasting time if the lock is held for long.
+    /// \requires There must be threading support.
+    /// \ingroup memory
+    class adaptive_mutex
+    {
+    public:
+        adaptive_mutex() FOONATHAN_NOEXCEPT
+        : locked_(false) {}
+
+        adaptive_mutex(const adaptive_mutex &) = delete;
+        adaptive_mutex& operator=(const adaptive_mutex &) = delete;
+
+        void lock()
+        {
+            detail::spin_backoff backoff;
+            while (!backoff.saturated())
+            {
+                if (try_lock())
+                    return;
+                backoff();
+            }
+            mutex_.lock();
+            locked_.store(true, std::memory_order_relaxed);
+        }
+
+        bool try_lock() FOONATHAN_NOEXCEPT
+        {
+            if (locked_.load(std::memory_order_relaxed) || !mutex_.try_lock())
+                return false;
+            locked_.store(true, std::memory_order_relaxed);
+            return true;
+        }
+
+        void unlock() FOONATHAN_NOEXCEPT
+        {
+            locked_.store(false, std::memory_order_relaxed);
+            mutex_.unlock();
+        }
+
+    private:
+        // only a hint, the mutex does the synchronization
+        // it is only written while holding the mutex, so it is never stale for long
+        std::atomic<bool> locked_;
+        std::mutex mutex_;
+    };
+#endif
+
 #if FOONATHAN_MEMORY_THREAD_SAFE_REFERENCE && FOONATHAN_HAS_THREADING_SUPPORT
     using default_mutex = std::mutex;
 #else
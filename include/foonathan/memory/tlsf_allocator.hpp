@@ -0,0 +1,224 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef FOONATHAN_MEMORY_TLSF_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_TLSF_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::tlsf_allocator.
+
+#include <type_traits>
+
+#include "detail/block_list.hpp"
+#include "detail/tlsf_list.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "debugging.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+
+namespace foonathan { namespace memory
+{
+    /// A stateful \concept{concept_rawallocator,RawAllocator} implementing a two-level segregated fit (TLSF) allocator.
+    /// It manages memory regions, either huge memory blocks allocated from a given \c RawAllocator
+    /// defaulting to \ref default_allocator or a single buffer provided by the user.
+    /// The free blocks are segregated into size classes,
+    /// a power of two on the first level and a linear subdivision of it on the second level,
+    /// and bitmaps of the non-empty classes allow finding a good fit in constant time.
+    /// Deallocation merges the block with its physical neighbours immediately.<br>
+    /// Both allocation and deallocation take constant time regardless of the number or size of the blocks,
+    /// which makes it suitable for latency-critical code that needs arbitrary sizes and individual deallocation.
+    /// Unlike \ref memory_stack it can free in any order and unlike \ref memory_pool_collection it coalesces free memory.
+    /// \ingroup memory
+    template <class RawAllocator = default_allocator>
+    class tlsf_allocator
+    : FOONATHAN_EBO(detail::leak_checker<tlsf_allocator<default_allocator>>)
+    {
+        using leak_checker = detail::leak_checker<tlsf_allocator<default_allocator>>;
+    public:
+        using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+        using is_stateful = std::true_type;
+
+        /// \effects Creates it by giving it the size of the initial memory block for the arena and the implementation allocator.
+        /// It will allocate the initial memory block with given size from the implementation allocator
+        /// and grow by allocating bigger ones if it runs out of memory.
+        explicit tlsf_allocator(std::size_t block_size, allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          block_list_(block_size, detail::move(allocator)),
+          buffer_(nullptr), buffer_size_(0u)
+        {
+            allocate_block();
+        }
+
+        /// \effects Creates it by giving it a memory buffer of given size to use as arena.
+        /// It will never allocate memory from the implementation allocator,
+        /// so the time of every allocation is bounded.
+        /// \requires \c memory must not be \c nullptr and stay valid as long as the allocator is used.
+        /// It must also not be smaller than a few bytes for the internal block headers.
+        tlsf_allocator(void *memory, std::size_t size, allocator_type allocator = allocator_type())
+        : leak_checker(info().name),
+          block_list_(0u, detail::move(allocator)),
+          buffer_(static_cast<char*>(memory)), buffer_size_(size)
+        {
+            FOONATHAN_MEMORY_ASSERT(memory);
+            list_.insert(memory, size);
+        }
+
+        /// \effects Destroys the \ref tlsf_allocator by returning all memory blocks,
+        /// regardless of properly deallocated back to the implementation allocator.
+        /// A user-provided buffer is not touched.
+        ~tlsf_allocator() FOONATHAN_NOEXCEPT = default;
+
+        /// @{
+        /// \effects Moving a \ref tlsf_allocator object transfers ownership over the free lists,
+        /// i.e. the moved from allocator is completely empty and the new one has all its memory.
+        /// That means that it is not allowed to call \ref deallocate_node() on a moved-from allocator
+        /// even when passing it memory that was previously allocated by this object.
+        tlsf_allocator(tlsf_allocator &&other) FOONATHAN_NOEXCEPT
+        : leak_checker(detail::move(other)),
+          block_list_(detail::move(other.block_list_)),
+          list_(detail::move(other.list_)),
+          buffer_(other.buffer_), buffer_size_(other.buffer_size_)
+        {
+            other.buffer_ = nullptr;
+            other.buffer_size_ = 0u;
+        }
+
+        tlsf_allocator& operator=(tlsf_allocator &&other) FOONATHAN_NOEXCEPT
+        {
+            leak_checker::operator=(detail::move(other));
+            block_list_ = detail::move(other.block_list_);
+            list_ = detail::move(other.list_);
+            buffer_ = other.buffer_;
+            buffer_size_ = other.buffer_size_;
+            other.buffer_ = nullptr;
+            other.buffer_size_ = 0u;
+            return *this;
+        }
+        /// @}
+
+        /// \effects Allocates a \concept{concept_node,node} by taking a free block from the first non-empty size class
+        /// that is big enough for \c size and \c alignment and splitting off the rest.
+        /// If there is none, a new memory block will be allocated, unless it uses a user-provided buffer.
+        /// \returns A block of at least \c size bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth,
+        /// \ref out_of_memory if the user-provided buffer is exhausted
+        /// or \ref bad_allocation_size if \c size or \c alignment exceeds \ref max_node_size().
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            detail::check_allocation_size(size, max_node_size(), info());
+            detail::check_allocation_size(alignment, max_alignment(), info());
+            auto mem = list_.allocate(size, alignment);
+            while (!mem)
+            {
+                if (buffer_)
+                    FOONATHAN_THROW(out_of_memory(info(), size));
+                allocate_block();
+                mem = list_.allocate(size, alignment);
+            }
+            this->on_allocate(size);
+            return mem;
+        }
+
+        /// \effects Allocates an \concept{concept_array,array} of nodes as a single block,
+        /// like \ref allocate_node().
+        /// \returns A block of at least <tt>count * size</tt> bytes aligned for \c alignment.
+        /// \throws Anything thrown by the implementation allocator on growth,
+        /// \ref out_of_memory if the user-provided buffer is exhausted
+        /// or \ref bad_allocation_size if <tt>count * size</tt> or \c alignment exceeds \ref max_array_size().
+        void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+        {
+            return allocate_node(count * size, alignment);
+        }
+
+        /// \effects Deallocates a \concept{concept_node,node} by putting its block back
+        /// and merging it with its free neighbours.
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_node() with the same size and alignment
+        /// on the same allocator, i.e. either this allocator object or a new object created by moving this to it.
+        void deallocate_node(void *ptr, std::size_t size, std::size_t) FOONATHAN_NOEXCEPT
+        {
+            list_.deallocate(ptr);
+            this->on_deallocate(size);
+        }
+
+        /// \effects Deallocates an \concept{concept_array,array} like \ref deallocate_node().
+        /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same sizes
+        /// on the same allocator.
+        void deallocate_array(void *ptr, std::size_t count, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+        {
+            deallocate_node(ptr, count * size, alignment);
+        }
+
+        /// @{
+        /// \returns The maximum size and alignment supported by the size classes.
+        /// \note It is a theoretical maximum, the memory blocks or the user-provided buffer are usually far smaller.
+        std::size_t max_node_size() const FOONATHAN_NOEXCEPT
+        {
+            return list_.max_block_size();
+        }
+
+        std::size_t max_array_size() const FOONATHAN_NOEXCEPT
+        {
+            return list_.max_block_size();
+        }
+
+        std::size_t max_alignment() const FOONATHAN_NOEXCEPT
+        {
+            return list_.max_block_size();
+        }
+        /// @}
+
+        /// \returns The total amount of bytes remaining in free blocks.
+        /// \note An allocation may fail even if the capacity is big enough,
+        /// since there might not be a single block big enough.
+        std::size_t capacity() const FOONATHAN_NOEXCEPT
+        {
+            return list_.capacity();
+        }
+
+        /// \returns The size of the next memory block after the arena grows.
+        /// This is zero if it uses a user-provided buffer, since it never grows.
+        std::size_t next_capacity() const FOONATHAN_NOEXCEPT
+        {
+            return buffer_ ? 0u : block_list_.next_block_size();
+        }
+
+        /// \returns Whether or not the memory pointed to by \c ptr was allocated from the arena of this allocator,
+        /// i.e. lies in the user-provided buffer or one of the memory blocks currently used.
+        /// \note This is a linear operation in the number of memory blocks.
+        bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+        {
+            auto address = static_cast<const char*>(ptr);
+            if (buffer_)
+                return buffer_ <= address && address < buffer_ + buffer_size_;
+            return block_list_.owns(ptr);
+        }
+
+        /// \returns A reference to the implementation allocator used for managing the arena.
+        /// \requires It is undefined behavior to move this allocator out into another object.
+        allocator_type& get_allocator() FOONATHAN_NOEXCEPT
+        {
+            return block_list_.get_allocator();
+        }
+
+    private:
+        allocator_info info() const FOONATHAN_NOEXCEPT
+        {
+            return {FOONATHAN_MEMORY_LOG_PREFIX "::tlsf_allocator", this};
+        }
+
+        void allocate_block()
+        {
+            auto mem = block_list_.allocate();
+            list_.insert(mem.memory, mem.size);
+        }
+
+        detail::block_list<allocator_type> block_list_;
+        detail::tlsf_free_memory_list list_;
+        char *buffer_;
+        std::size_t buffer_size_;
+    };
+}} // namespace foonathan::memory
+
+#endif // FOONATHAN_MEMORY_TLSF_ALLOCATOR_HPP_INCLUDED
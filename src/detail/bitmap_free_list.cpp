@@ -0,0 +1,347 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/bitmap_free_list.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <new>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+struct detail::bitmap_block
+{
+    bitmap_block *next;
+    char *nodes;
+    std::size_t no_nodes, no_free;
+    std::size_t hint; // index of the first word that might have a free node
+};
+
+namespace
+{
+    using word = std::uint64_t;
+    FOONATHAN_CONSTEXPR std::size_t bits_per_word = sizeof(word) * CHAR_BIT;
+
+    // index of the lowest set bit
+    // pre: w != 0
+    std::size_t count_trailing_zeros(word w) FOONATHAN_NOEXCEPT
+    {
+        FOONATHAN_MEMORY_ASSERT(w != 0u);
+    #if defined(__GNUC__)
+        return std::size_t(__builtin_ctzll(w));
+    #elif defined(_MSC_VER) && defined(_WIN64)
+        unsigned long index;
+        _BitScanForward64(&index, w);
+        return std::size_t(index);
+    #else
+        std::size_t index = 0u;
+        for (; (w & 1u) == 0u; w >>= 1)
+            ++index;
+        return index;
+    #endif
+    }
+
+    std::size_t no_words(std::size_t no_nodes) FOONATHAN_NOEXCEPT
+    {
+        return (no_nodes + bits_per_word - 1u) / bits_per_word;
+    }
+
+    word* bitmap(bitmap_block *block) FOONATHAN_NOEXCEPT
+    {
+        static_assert(sizeof(bitmap_block) % FOONATHAN_ALIGNOF(word) == 0u, "bitmap not aligned");
+        return reinterpret_cast<word*>(block + 1);
+    }
+
+    // offset from the block to the first node
+    std::size_t nodes_offset(std::size_t no_nodes, std::size_t alignment) FOONATHAN_NOEXCEPT
+    {
+        auto offset = sizeof(bitmap_block) + no_words(no_nodes) * sizeof(word);
+        return (offset + alignment - 1u) / alignment * alignment;
+    }
+
+    // calls f(word, mask) for each word in the bitmap covering the nodes [index, index + count)
+    template <typename Func>
+    void for_each_word(bitmap_block *block, std::size_t index, std::size_t count, Func f) FOONATHAN_NOEXCEPT
+    {
+        auto bits = bitmap(block);
+        while (count != 0u)
+        {
+            auto bit = index % bits_per_word;
+            auto n = bits_per_word - bit < count ? bits_per_word - bit : count;
+            auto mask = (n == bits_per_word ? word(-1) : (word(1) << n) - 1u) << bit;
+            f(bits[index / bits_per_word], mask);
+            index += n;
+            count -= n;
+        }
+    }
+
+    // finds a run of count free nodes, returns its first index or no_nodes if there is none
+    std::size_t find_run(bitmap_block *block, std::size_t count) FOONATHAN_NOEXCEPT
+    {
+        auto bits = bitmap(block);
+        std::size_t start = 0u, length = 0u;
+        for (std::size_t i = block->hint; i != no_words(block->no_nodes); ++i)
+        {
+            auto w = bits[i];
+            if (w == 0u)
+                length = 0u;
+            else if (w == word(-1))
+            {
+                // whole word is free
+                if (length == 0u)
+                    start = i * bits_per_word;
+                length += bits_per_word;
+                if (length >= count)
+                    return start;
+            }
+            else
+                // jump from run to run
+                for (std::size_t bit = 0u; bit != bits_per_word;)
+                {
+                    auto rest = w >> bit;
+                    if (rest & 1u)
+                    {
+                        // zeros are shifted in, so ~rest is never zero
+                        auto run = count_trailing_zeros(~rest);
+                        if (length == 0u)
+                            start = i * bits_per_word + bit;
+                        length += run;
+                        if (length >= count)
+                            return start;
+                        bit += run;
+                    }
+                    else if (rest == 0u)
+                    {
+                        length = 0u;
+                        break;
+                    }
+                    else
+                    {
+                        length = 0u;
+                        bit += count_trailing_zeros(rest);
+                    }
+                }
+        }
+        return block->no_nodes;
+    }
+}
+
+FOONATHAN_CONSTEXPR std::size_t bitmap_free_memory_list::min_element_size;
+FOONATHAN_CONSTEXPR std::size_t bitmap_free_memory_list::min_element_alignment;
+
+bitmap_free_memory_list::bitmap_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT
+: first_block_(nullptr), alloc_block_(nullptr), dealloc_block_(nullptr),
+  node_size_(node_size), capacity_(0u) {}
+
+bitmap_free_memory_list::bitmap_free_memory_list(std::size_t node_size,
+                                                 void *mem, std::size_t size) FOONATHAN_NOEXCEPT
+: bitmap_free_memory_list(node_size)
+{
+    insert(mem, size);
+}
+
+bitmap_free_memory_list::bitmap_free_memory_list(bitmap_free_memory_list &&other) FOONATHAN_NOEXCEPT
+: first_block_(other.first_block_), alloc_block_(other.alloc_block_), dealloc_block_(other.dealloc_block_),
+  node_size_(other.node_size_), capacity_(other.capacity_)
+{
+    other.first_block_ = other.alloc_block_ = other.dealloc_block_ = nullptr;
+    other.capacity_ = 0u;
+}
+
+bitmap_free_memory_list& bitmap_free_memory_list::operator=(bitmap_free_memory_list &&other) FOONATHAN_NOEXCEPT
+{
+    bitmap_free_memory_list tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(bitmap_free_memory_list &a, bitmap_free_memory_list &b) FOONATHAN_NOEXCEPT
+{
+    detail::adl_swap(a.first_block_, b.first_block_);
+    detail::adl_swap(a.alloc_block_, b.alloc_block_);
+    detail::adl_swap(a.dealloc_block_, b.dealloc_block_);
+    detail::adl_swap(a.node_size_, b.node_size_);
+    detail::adl_swap(a.capacity_, b.capacity_);
+}
+
+void bitmap_free_memory_list::insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, max_alignment));
+    FOONATHAN_MEMORY_ASSERT_MSG(size > sizeof(bitmap_block), "too small memory size");
+
+    // each node needs its slot plus one bit, start with that estimate and adjust for the padding
+    auto no_nodes = (size - sizeof(bitmap_block)) * CHAR_BIT / (slot_size() * CHAR_BIT + 1u);
+    while (no_nodes != 0u && nodes_offset(no_nodes, alignment()) + no_nodes * slot_size() > size)
+        --no_nodes;
+    FOONATHAN_MEMORY_ASSERT_MSG(no_nodes > 0u, "too small memory size");
+
+    auto block = ::new(mem) bitmap_block;
+    block->nodes = static_cast<char*>(mem) + nodes_offset(no_nodes, alignment());
+    block->no_nodes = block->no_free = no_nodes;
+    block->hint = 0u;
+
+    auto bits = bitmap(block);
+    for (std::size_t i = 0u; i != no_nodes / bits_per_word; ++i)
+        bits[i] = word(-1);
+    if (auto rest = no_nodes % bits_per_word)
+        bits[no_nodes / bits_per_word] = (word(1) << rest) - 1u;
+
+    block->next = first_block_;
+    first_block_ = block;
+    alloc_block_ = dealloc_block_ = block;
+    capacity_ += no_nodes;
+}
+
+void* bitmap_free_memory_list::allocate() FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(!empty());
+    if (alloc_block_->no_free == 0u)
+        alloc_block_ = find_block();
+
+    // all words before the hint are zero
+    auto i = alloc_block_->hint;
+    auto w = bitmap(alloc_block_)[i];
+    return take(alloc_block_, i * bits_per_word + count_trailing_zeros(w), 1u, node_size_);
+}
+
+void* bitmap_free_memory_list::allocate(std::size_t n) FOONATHAN_NOEXCEPT
+{
+    auto count = no_slots(n);
+    if (count > capacity_)
+        return nullptr;
+
+    auto try_block = [&](bitmap_block *block) -> void*
+    {
+        if (block->no_free < count)
+            return nullptr;
+        auto index = find_run(block, count);
+        return index == block->no_nodes ? nullptr : take(block, index, count, n);
+    };
+
+    // start with alloc_block_, it most likely has the most free memory
+    if (auto mem = try_block(alloc_block_))
+        return mem;
+    for (auto block = first_block_; block; block = block->next)
+        if (block != alloc_block_)
+            if (auto mem = try_block(block))
+                return mem;
+    return nullptr;
+}
+
+void bitmap_free_memory_list::deallocate(void *node) FOONATHAN_NOEXCEPT
+{
+    give_back(node, 1u, node_size_);
+}
+
+void bitmap_free_memory_list::deallocate(void *ptr, std::size_t n) FOONATHAN_NOEXCEPT
+{
+    give_back(ptr, no_slots(n), n);
+}
+
+std::size_t bitmap_free_memory_list::node_size() const FOONATHAN_NOEXCEPT
+{
+    return node_size_;
+}
+
+std::size_t bitmap_free_memory_list::alignment() const FOONATHAN_NOEXCEPT
+{
+    return alignment_for(node_size_);
+}
+
+std::size_t bitmap_free_memory_list::slot_size() const FOONATHAN_NOEXCEPT
+{
+    auto size = (node_size_ + alignment() - 1u) / alignment() * alignment();
+    return size + (debug_fence_size ? 2 * alignment() : 0u);
+}
+
+std::size_t bitmap_free_memory_list::no_slots(std::size_t n) const FOONATHAN_NOEXCEPT
+{
+    auto fence = debug_fence_size ? alignment() : 0u;
+    return (fence + n + fence + slot_size() - 1u) / slot_size();
+}
+
+bitmap_block* bitmap_free_memory_list::block_for(void *memory) FOONATHAN_NOEXCEPT
+{
+    auto contains = [&](bitmap_block *block)
+    {
+        // comparision not strictly legal, but works
+        return block->nodes <= memory && memory < block->nodes + block->no_nodes * slot_size();
+    };
+
+    if (dealloc_block_ && contains(dealloc_block_))
+        return dealloc_block_;
+    else if (alloc_block_ && contains(alloc_block_))
+        return dealloc_block_ = alloc_block_;
+
+    for (auto block = first_block_; block; block = block->next)
+        if (contains(block))
+            return dealloc_block_ = block;
+    return nullptr;
+}
+
+bitmap_block* bitmap_free_memory_list::find_block() FOONATHAN_NOEXCEPT
+{
+    if (dealloc_block_->no_free != 0u)
+        return dealloc_block_;
+    for (auto block = first_block_; block; block = block->next)
+        if (block->no_free != 0u)
+            return block;
+    FOONATHAN_MEMORY_UNREACHABLE("capacity is not zero but no block has a free node");
+    return nullptr;
+}
+
+void* bitmap_free_memory_list::take(bitmap_block *block, std::size_t index,
+                                    std::size_t count, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    for_each_word(block, index, count, [](word &w, word mask)
+    {
+        w &= ~mask;
+    });
+    block->no_free -= count;
+    capacity_ -= count;
+
+    // skip all words without free nodes
+    auto bits = bitmap(block);
+    while (block->hint != no_words(block->no_nodes) && bits[block->hint] == 0u)
+        ++block->hint;
+
+    // alignment is fence memory
+    return debug_fill_new(block->nodes + index * slot_size(), size, alignment());
+}
+
+void bitmap_free_memory_list::give_back(void *memory, std::size_t count, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    auto info = allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::bitmap_free_memory_list", this);
+
+    // alignment is fence memory
+    auto node = debug_fill_free(memory, size, alignment());
+    auto block = block_for(node);
+    // memory was never managed by this list
+    check_pointer(block, info, memory);
+    auto offset = std::size_t(node - block->nodes);
+    // memory is not at the right position
+    check_pointer(offset % slot_size() == 0u, info, memory);
+
+    auto index = offset / slot_size();
+    for_each_word(block, index, count, [&](word &w, word mask)
+    {
+        // double-free
+        check_pointer((w & mask) == 0u, info, memory);
+        w |= mask;
+    });
+    if (index / bits_per_word < block->hint)
+        block->hint = index / bits_per_word;
+    block->no_free += count;
+    capacity_ += count;
+}
@@ -56,3 +56,16 @@ block_info block_list_impl::top() const FOONATHAN_NOEXCEPT
     FOONATHAN_MEMORY_ASSERT_MSG(head_, "stack underflow");
     return {head_ + 1, head_->size - sizeof(node)};
 }
+
+bool block_list_impl::owns(const void *ptr) const FOONATHAN_NOEXCEPT
+{
+    auto address = static_cast<const char*>(ptr);
+    for (auto cur = head_; cur; cur = cur->prev)
+    {
+        auto begin = reinterpret_cast<const char*>(cur + 1);
+        auto end = reinterpret_cast<const char*>(cur) + cur->size;
+        if (begin <= address && address < end)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/block_map.hpp"
+
+#include "debugging.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+FOONATHAN_CONSTEXPR std::size_t block_map::no_owner;
+
+void block_map::insert(const void *memory, std::size_t size, std::size_t owner) FOONATHAN_NOEXCEPT
+{
+    auto begin = reinterpret_cast<std::uintptr_t>(memory);
+    auto version = begin_write();
+
+    auto cur_size = size_.load(std::memory_order_relaxed);
+    FOONATHAN_MEMORY_ASSERT_MSG(cur_size < capacity_, "too many memory blocks");
+    auto pos = upper_bound(begin, cur_size);
+    for (auto i = cur_size; i != pos; --i)
+        copy(i, i - 1);
+
+    entries_[pos].begin.store(begin, std::memory_order_relaxed);
+    entries_[pos].end.store(begin + size, std::memory_order_relaxed);
+    entries_[pos].owner.store(owner, std::memory_order_relaxed);
+    size_.store(cur_size + 1, std::memory_order_relaxed);
+
+    end_write(version);
+}
+
+void block_map::erase(const void *memory) FOONATHAN_NOEXCEPT
+{
+    auto begin = reinterpret_cast<std::uintptr_t>(memory);
+    auto version = begin_write();
+
+    auto cur_size = size_.load(std::memory_order_relaxed);
+    auto pos = upper_bound(begin, cur_size);
+    FOONATHAN_MEMORY_ASSERT_MSG(pos != 0u && entries_[pos - 1].begin.load(std::memory_order_relaxed) == begin,
+                                "block not inserted");
+    for (auto i = pos; i != cur_size; ++i)
+        copy(i - 1, i);
+    size_.store(cur_size - 1, std::memory_order_relaxed);
+
+    end_write(version);
+}
+
+std::size_t block_map::find(const void *ptr) const FOONATHAN_NOEXCEPT
+{
+    auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    while (true)
+    {
+        auto version = version_.load(std::memory_order_acquire);
+        if (version % 2u != 0u)
+            // a block is inserted or erased right now
+            continue;
+
+        // the values might be torn by a concurrent write, but they are only used if the version didn't change
+        auto pos = upper_bound(address, size_.load(std::memory_order_relaxed));
+        auto owner = pos != 0u && address < entries_[pos - 1].end.load(std::memory_order_relaxed)
+                   ? entries_[pos - 1].owner.load(std::memory_order_relaxed) : no_owner;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) == version)
+            return owner;
+    }
+}
+
+std::size_t block_map::begin_write() FOONATHAN_NOEXCEPT
+{
+    auto version = version_.load(std::memory_order_relaxed);
+    // wait for other writers and make the version odd
+    while (version % 2u != 0u
+        || !version_.compare_exchange_weak(version, version + 1u, std::memory_order_acquire,
+                                           std::memory_order_relaxed))
+        version = version_.load(std::memory_order_relaxed);
+    // readers that see one of the following writes also see the odd version
+    std::atomic_thread_fence(std::memory_order_release);
+    return version + 1u;
+}
+
+void block_map::end_write(std::size_t version) FOONATHAN_NOEXCEPT
+{
+    version_.store(version + 1u, std::memory_order_release);
+}
+
+std::size_t block_map::upper_bound(std::uintptr_t address, std::size_t size) const FOONATHAN_NOEXCEPT
+{
+    // a torn size can be too big
+    if (size > capacity_)
+        size = capacity_;
+
+    std::size_t first = 0u;
+    while (size != 0u)
+    {
+        auto half = size / 2u;
+        if (entries_[first + half].begin.load(std::memory_order_relaxed) <= address)
+        {
+            first += half + 1u;
+            size -= half + 1u;
+        }
+        else
+            size = half;
+    }
+    return first;
+}
+
+void block_map::copy(std::size_t to, std::size_t from) FOONATHAN_NOEXCEPT
+{
+    auto &src = entries_[from];
+    auto &dest = entries_[to];
+    dest.begin.store(src.begin.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    dest.end.store(src.end.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    dest.owner.store(src.owner.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
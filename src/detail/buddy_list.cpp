@@ -0,0 +1,202 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/buddy_list.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "detail/align.hpp"
+#include "detail/free_list_array.hpp"
+#include "detail/utility.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+struct detail::buddy_node
+{
+    buddy_node *next, *prev;
+};
+
+namespace
+{
+    static_assert(sizeof(buddy_node) <= buddy_free_memory_list::min_element_size,
+                  "links do not fit into a block");
+
+    // table entry of a block that is not the start of a free block
+    // otherwise it is the order plus one
+    FOONATHAN_CONSTEXPR unsigned char not_free = 0u;
+
+    std::uintptr_t to_int(void *ptr) FOONATHAN_NOEXCEPT
+    {
+        return reinterpret_cast<std::uintptr_t>(ptr);
+    }
+}
+
+FOONATHAN_CONSTEXPR std::size_t buddy_free_memory_list::min_element_size;
+FOONATHAN_CONSTEXPR std::size_t buddy_free_memory_list::max_orders;
+
+buddy_free_memory_list::buddy_free_memory_list(std::size_t min_block_size,
+                                               std::size_t max_block_size) FOONATHAN_NOEXCEPT
+: min_block_log2_(ilog2(min_block_size > min_element_size ? min_block_size : min_element_size)),
+  max_order_(0u), capacity_(0u)
+{
+    // a tree is twice the maximum block size
+    while ((this->min_block_size() << max_order_) < max_block_size)
+        ++max_order_;
+    ++max_order_;
+    FOONATHAN_MEMORY_ASSERT(max_order_ < max_orders && max_order_ < UCHAR_MAX);
+
+    for (auto &head : free_)
+        head = nullptr;
+}
+
+buddy_free_memory_list::buddy_free_memory_list(buddy_free_memory_list &&other) FOONATHAN_NOEXCEPT
+: min_block_log2_(other.min_block_log2_), max_order_(other.max_order_), capacity_(other.capacity_)
+{
+    for (std::size_t i = 0u; i != max_orders; ++i)
+    {
+        free_[i] = other.free_[i];
+        other.free_[i] = nullptr;
+    }
+    other.capacity_ = 0u;
+}
+
+buddy_free_memory_list& buddy_free_memory_list::operator=(buddy_free_memory_list &&other) FOONATHAN_NOEXCEPT
+{
+    buddy_free_memory_list tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(buddy_free_memory_list &a, buddy_free_memory_list &b) FOONATHAN_NOEXCEPT
+{
+    for (std::size_t i = 0u; i != buddy_free_memory_list::max_orders; ++i)
+        detail::adl_swap(a.free_[i], b.free_[i]);
+    detail::adl_swap(a.min_block_log2_, b.min_block_log2_);
+    detail::adl_swap(a.max_order_, b.max_order_);
+    detail::adl_swap(a.capacity_, b.capacity_);
+}
+
+void buddy_free_memory_list::insert_tree(void *mem) FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, tree_size()));
+    auto memory = static_cast<char*>(mem);
+
+    // one entry for each minimum block
+    auto table_size = std::size_t(1) << max_order_;
+    std::memset(memory, not_free, table_size);
+
+    // split the rest into the biggest blocks possible
+    auto offset = (table_size + min_block_size() - 1u) >> min_block_log2_ << min_block_log2_;
+    while (offset != tree_size())
+    {
+        std::size_t order = 0u;
+        while (offset % (min_block_size() << (order + 1u)) == 0u
+               && offset + (min_block_size() << (order + 1u)) <= tree_size())
+            ++order;
+        push(memory + offset, order);
+        capacity_ += min_block_size() << order;
+        offset += min_block_size() << order;
+    }
+}
+
+void* buddy_free_memory_list::allocate(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+{
+    auto order = order_for(size, alignment);
+    auto cur_order = order;
+    while (cur_order < max_order_ && !free_[cur_order])
+        ++cur_order;
+    if (cur_order >= max_order_)
+        return nullptr;
+
+    auto node = free_[cur_order];
+    erase(node, cur_order);
+    auto memory = reinterpret_cast<char*>(node);
+    // the upper halves are the buddies of the lower halves
+    while (cur_order != order)
+    {
+        --cur_order;
+        push(memory + (min_block_size() << cur_order), cur_order);
+    }
+
+    auto block_size = min_block_size() << order;
+    capacity_ -= block_size;
+    detail::debug_fill(memory, block_size, debug_magic::new_memory);
+    return memory;
+}
+
+void buddy_free_memory_list::deallocate(void *ptr, std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+{
+    auto info = allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::buddy_free_memory_list", this);
+
+    auto order = order_for(size, alignment);
+    auto table = table_for(ptr);
+    auto tree = reinterpret_cast<char*>(table);
+    auto offset = std::size_t(static_cast<char*>(ptr) - tree);
+    // memory is inside the table or not at a block of that order
+    check_pointer(offset >= (std::size_t(1) << max_order_)
+                  && offset % (min_block_size() << order) == 0u, info, ptr);
+    // double-free
+    check_pointer(table[offset >> min_block_log2_] == not_free, info, ptr);
+
+    auto block_size = min_block_size() << order;
+    capacity_ += block_size;
+    detail::debug_fill(ptr, block_size, debug_magic::freed_memory);
+
+    // the table is never free, so the merging stops before the entire tree
+    while (order + 1u < max_order_)
+    {
+        auto buddy_offset = offset ^ (min_block_size() << order);
+        if (table[buddy_offset >> min_block_log2_] != order + 1u)
+            break;
+        erase(reinterpret_cast<buddy_node*>(tree + buddy_offset), order);
+        offset = offset < buddy_offset ? offset : buddy_offset;
+        ++order;
+    }
+    push(tree + offset, order);
+}
+
+std::size_t buddy_free_memory_list::order_for(std::size_t size, std::size_t alignment) const FOONATHAN_NOEXCEPT
+{
+    auto needed = size > alignment ? size : alignment;
+    if (needed <= min_block_size())
+        return 0u;
+    return ilog2((needed + min_block_size() - 1u) >> min_block_log2_);
+}
+
+unsigned char* buddy_free_memory_list::table_for(void *memory) const FOONATHAN_NOEXCEPT
+{
+    return reinterpret_cast<unsigned char*>(to_int(memory) & ~std::uintptr_t(tree_size() - 1u));
+}
+
+std::size_t buddy_free_memory_list::table_index(void *memory) const FOONATHAN_NOEXCEPT
+{
+    return std::size_t(to_int(memory) & std::uintptr_t(tree_size() - 1u)) >> min_block_log2_;
+}
+
+void buddy_free_memory_list::push(void *memory, std::size_t order) FOONATHAN_NOEXCEPT
+{
+    auto node = ::new(memory) buddy_node;
+    node->next = free_[order];
+    node->prev = nullptr;
+    if (free_[order])
+        free_[order]->prev = node;
+    free_[order] = node;
+    table_for(memory)[table_index(memory)] = static_cast<unsigned char>(order + 1u);
+}
+
+void buddy_free_memory_list::erase(buddy_node *node, std::size_t order) FOONATHAN_NOEXCEPT
+{
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        free_[order] = node->next;
+    if (node->next)
+        node->next->prev = node->prev;
+    table_for(node)[table_index(node)] = not_free;
+}
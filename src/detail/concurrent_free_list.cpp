@@ -0,0 +1,108 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/concurrent_free_list.hpp"
+
+#include "detail/align.hpp"
+#include "debugging.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+namespace
+{
+    // reads a stored pointer value
+    // a concurrent pop may read the link of a node that is already in use by someone else,
+    // the value is garbage then but the following compare-exchange will fail because the tag has changed
+    char* get_ptr(void *address) FOONATHAN_NOEXCEPT
+    {
+        FOONATHAN_MEMORY_ASSERT(address);
+        return *static_cast<char* volatile*>(address);
+    }
+
+    // stores a pointer value
+    void set_ptr(void *address, char *ptr) FOONATHAN_NOEXCEPT
+    {
+        FOONATHAN_MEMORY_ASSERT(address);
+        *static_cast<char**>(address) = ptr;
+    }
+}
+
+FOONATHAN_CONSTEXPR std::size_t concurrent_free_memory_list::min_element_size;
+FOONATHAN_CONSTEXPR std::size_t concurrent_free_memory_list::min_element_alignment;
+
+concurrent_free_memory_list::concurrent_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT
+: head_(tagged_ptr{nullptr, 0u}),
+  node_size_(node_size > min_element_size ? node_size : min_element_size)
+{}
+
+std::size_t concurrent_free_memory_list::insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(mem);
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, alignment()));
+
+    auto actual_size = node_fence_size();
+    auto no_nodes = size / actual_size;
+    if (no_nodes == 0u)
+        return 0u;
+
+    // link the nodes privately, nobody else can see them yet
+    auto first = static_cast<char*>(mem);
+    auto cur = first;
+    for (std::size_t i = 0u; i != no_nodes - 1; ++i)
+    {
+        set_ptr(cur, cur + actual_size);
+        cur += actual_size;
+    }
+
+    push(first, cur);
+    return no_nodes;
+}
+
+void* concurrent_free_memory_list::allocate() FOONATHAN_NOEXCEPT
+{
+    auto old_head = head_.load(std::memory_order_acquire);
+    tagged_ptr new_head;
+    do
+    {
+        if (!old_head.ptr)
+            return nullptr;
+        new_head.ptr = get_ptr(old_head.ptr);
+        new_head.tag = old_head.tag + 1;
+    } while (!head_.compare_exchange_weak(old_head, new_head,
+                                          std::memory_order_acquire, std::memory_order_acquire));
+
+    // alignment is fence memory
+    return debug_fill_new(old_head.ptr, node_size_, alignment());
+}
+
+void concurrent_free_memory_list::deallocate(void *ptr) FOONATHAN_NOEXCEPT
+{
+    // alignment is fence memory
+    auto node = debug_fill_free(ptr, node_size_, alignment());
+    push(node, node);
+}
+
+std::size_t concurrent_free_memory_list::alignment() const FOONATHAN_NOEXCEPT
+{
+    return alignment_for(node_size_);
+}
+
+std::size_t concurrent_free_memory_list::node_fence_size() const FOONATHAN_NOEXCEPT
+{
+    return node_size_ + (debug_fence_size ? 2 * alignment() : 0u);
+}
+
+void concurrent_free_memory_list::push(char *first, char *last) FOONATHAN_NOEXCEPT
+{
+    auto old_head = head_.load(std::memory_order_relaxed);
+    tagged_ptr new_head;
+    do
+    {
+        set_ptr(last, old_head.ptr);
+        new_head.ptr = first;
+        new_head.tag = old_head.tag + 1;
+    } while (!head_.compare_exchange_weak(old_head, new_head,
+                                          std::memory_order_release, std::memory_order_relaxed));
+}
@@ -0,0 +1,229 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/cpu.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__linux__)
+    #include <sched.h>
+    #include <unistd.h>
+#elif FOONATHAN_HAS_THREADING_SUPPORT
+    #include <thread>
+#endif
+
+using namespace foonathan::memory;
+using namespace detail;
+
+std::size_t detail::thread_index() FOONATHAN_NOEXCEPT
+{
+    static std::atomic<std::size_t> next_index(0u);
+    static FOONATHAN_THREAD_LOCAL std::size_t index = 0u; // 0 means not yet assigned
+    if (index == 0u)
+        index = next_index.fetch_add(1u, std::memory_order_relaxed) + 1u;
+    return index - 1u;
+}
+
+std::size_t detail::cpu_count() FOONATHAN_NOEXCEPT
+{
+#if defined(__linux__)
+    auto count = sysconf(_SC_NPROCESSORS_CONF);
+    return count > 0 ? std::size_t(count) : 1u;
+#elif FOONATHAN_HAS_THREADING_SUPPORT
+    auto count = std::thread::hardware_concurrency();
+    return count > 0u ? std::size_t(count) : 1u;
+#else
+    return 1u;
+#endif
+}
+
+std::size_t detail::current_cpu() FOONATHAN_NOEXCEPT
+{
+#if defined(__linux__)
+    // recent glibc versions read it from the restartable sequence area registered for the thread,
+    // older ones use the vDSO, so it does not need a real system call
+    auto cpu = sched_getcpu();
+    if (cpu >= 0)
+        return std::size_t(cpu);
+#endif
+    return thread_index();
+}
+
+// asm goto with output operands needs GCC 11 or clang 11
+#if defined(__clang__)
+    #define FOONATHAN_MEMORY_IMPL_ASM_GOTO_OUTPUT (__clang_major__ >= 11)
+#elif defined(__GNUC__)
+    #define FOONATHAN_MEMORY_IMPL_ASM_GOTO_OUTPUT (__GNUC__ >= 11)
+#else
+    #define FOONATHAN_MEMORY_IMPL_ASM_GOTO_OUTPUT 0
+#endif
+
+// ThreadSanitizer cannot see that the processor owning a stack orders the accesses to it,
+// so it would report the nodes passed between threads on the same processor as races
+#if defined(__SANITIZE_THREAD__)
+    #define FOONATHAN_MEMORY_IMPL_TSAN 1
+#elif defined(__has_feature)
+    #if __has_feature(thread_sanitizer)
+        #define FOONATHAN_MEMORY_IMPL_TSAN 1
+    #endif
+#endif
+
+#if defined(__linux__) && defined(__x86_64__) && defined(__GLIBC__) \
+    && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35)) \
+    && FOONATHAN_MEMORY_IMPL_ASM_GOTO_OUTPUT && !defined(FOONATHAN_MEMORY_IMPL_TSAN)
+    #include <sys/rseq.h>
+
+    #define FOONATHAN_MEMORY_IMPL_HAS_RSEQ 1
+#else
+    #define FOONATHAN_MEMORY_IMPL_HAS_RSEQ 0
+#endif
+
+#if FOONATHAN_MEMORY_IMPL_HAS_RSEQ
+namespace
+{
+    // glibc registers the area for every thread unless disabled by the glibc.pthread.rseq tunable
+    rseq* rseq_area() FOONATHAN_NOEXCEPT
+    {
+        if (__rseq_size == 0u)
+            return nullptr;
+        return reinterpret_cast<rseq*>(static_cast<char*>(__builtin_thread_pointer()) + __rseq_offset);
+    }
+
+    // the processor the thread is running on, no_cpus if it is not available
+    std::uint32_t rseq_cpu(const rseq *area, std::size_t no_cpus) FOONATHAN_NOEXCEPT
+    {
+        // also catches the uninitialized and registration failed states
+        auto cpu = __atomic_load_n(&area->cpu_id, __ATOMIC_RELAXED);
+        return cpu < no_cpus ? cpu : std::uint32_t(no_cpus);
+    }
+}
+
+#define FOONATHAN_MEMORY_IMPL_STRINGIFY_IMPL(x) #x
+#define FOONATHAN_MEMORY_IMPL_STRINGIFY(x) FOONATHAN_MEMORY_IMPL_STRINGIFY_IMPL(x)
+
+// the critical section starts at label 1 and ends with the commit store before label 2
+// if the thread is preempted, migrated or interrupted by a signal in between,
+// the kernel continues at the abort handler at label 4, which must be preceded by the signature
+#define FOONATHAN_MEMORY_IMPL_RSEQ_CS \
+    ".pushsection __rseq_cs, \"aw\"\n\t" \
+    ".balign 32\n\t" \
+    "3:\n\t" \
+    ".long 0x0, 0x0\n\t" \
+    ".quad 1f, (2f - 1f), 4f\n\t" \
+    ".popsection\n\t" \
+    "leaq 3b(%%rip), %%rax\n\t" \
+    "movq %%rax, %[rseq_cs]\n\t" \
+    "1:\n\t" \
+    "cmpl %[cpu], %[cpu_id]\n\t" \
+    "jnz %l[abort]\n\t"
+
+#define FOONATHAN_MEMORY_IMPL_RSEQ_ABORT \
+    "2:\n\t" \
+    ".pushsection __rseq_failure, \"ax\"\n\t" \
+    ".byte 0x0f, 0xb9, 0x3d\n\t" \
+    ".long " FOONATHAN_MEMORY_IMPL_STRINGIFY(RSEQ_SIG) "\n\t" \
+    "4:\n\t" \
+    "jmp %l[abort]\n\t" \
+    ".popsection\n\t"
+
+bool detail::has_rseq() FOONATHAN_NOEXCEPT
+{
+    // the uninitialized and registration failed states are negative
+    auto area = rseq_area();
+    return area && std::int32_t(__atomic_load_n(&area->cpu_id, __ATOMIC_RELAXED)) >= 0;
+}
+
+void* detail::percpu_pop(percpu_stack *stacks, std::size_t no_cpus, std::size_t stride) FOONATHAN_NOEXCEPT
+{
+    auto area = rseq_area();
+    if (!area)
+        return nullptr;
+
+    while (true)
+    {
+        auto cpu = rseq_cpu(area, no_cpus);
+        if (cpu == no_cpus)
+            return nullptr;
+        auto stack = stacks + cpu * stride;
+
+        void *result;
+        __asm__ __volatile__ goto(
+            FOONATHAN_MEMORY_IMPL_RSEQ_CS
+            "movq %[size], %%rbx\n\t"
+            "testq %%rbx, %%rbx\n\t"
+            "jz %l[empty]\n\t"
+            "movq -8(%[slots], %%rbx, 8), %[result]\n\t"
+            "decq %%rbx\n\t"
+            // commit
+            "movq %%rbx, %[size]\n\t"
+            FOONATHAN_MEMORY_IMPL_RSEQ_ABORT
+            // result is written before the inputs are used for the last time
+            : [result] "=&r"(result)
+            : [cpu] "r"(cpu), [cpu_id] "m"(area->cpu_id), [rseq_cs] "m"(area->rseq_cs),
+              [size] "m"(stack->size), [slots] "r"(stack->slots)
+            : "memory", "cc", "rax", "rbx"
+            : abort, empty);
+        return result;
+    abort:
+        continue;
+    empty:
+        return nullptr;
+    }
+}
+
+bool detail::percpu_push(percpu_stack *stacks, std::size_t no_cpus, std::size_t stride,
+                         void *ptr) FOONATHAN_NOEXCEPT
+{
+    auto area = rseq_area();
+    if (!area)
+        return false;
+
+    while (true)
+    {
+        auto cpu = rseq_cpu(area, no_cpus);
+        if (cpu == no_cpus)
+            return false;
+        auto stack = stacks + cpu * stride;
+
+        __asm__ __volatile__ goto(
+            FOONATHAN_MEMORY_IMPL_RSEQ_CS
+            "movq %[size], %%rbx\n\t"
+            "cmpq %[capacity], %%rbx\n\t"
+            "jae %l[full]\n\t"
+            // the slot is not visible before the commit, so it can be written speculatively
+            "movq %[ptr], (%[slots], %%rbx, 8)\n\t"
+            "incq %%rbx\n\t"
+            // commit
+            "movq %%rbx, %[size]\n\t"
+            FOONATHAN_MEMORY_IMPL_RSEQ_ABORT
+            :
+            : [cpu] "r"(cpu), [cpu_id] "m"(area->cpu_id), [rseq_cs] "m"(area->rseq_cs),
+              [size] "m"(stack->size), [slots] "r"(stack->slots), [ptr] "r"(ptr),
+              [capacity] "i"(percpu_stack::capacity)
+            : "memory", "cc", "rax", "rbx"
+            : abort, full);
+        return true;
+    abort:
+        continue;
+    full:
+        return false;
+    }
+}
+#else
+bool detail::has_rseq() FOONATHAN_NOEXCEPT
+{
+    return false;
+}
+
+void* detail::percpu_pop(percpu_stack *, std::size_t, std::size_t) FOONATHAN_NOEXCEPT
+{
+    return nullptr;
+}
+
+bool detail::percpu_push(percpu_stack *, std::size_t, std::size_t, void *) FOONATHAN_NOEXCEPT
+{
+    return false;
+}
+#endif
@@ -0,0 +1,321 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/indexed_free_list.hpp"
+
+#include <cstdint>
+#include <new>
+
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+    #include <functional>
+#endif
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+struct detail::free_run
+{
+    free_run *left, *right;
+    std::size_t no_nodes;
+    std::size_t max_nodes; // longest run in this subtree
+};
+
+namespace
+{
+    static_assert(sizeof(free_run) <= indexed_free_memory_list::min_element_size,
+                  "run header does not fit into a node");
+
+    bool less(const void *a, const void *b) FOONATHAN_NOEXCEPT
+    {
+    #if FOONATHAN_HOSTED_IMPLEMENTATION
+        return std::less<const void*>()(a, b);
+    #else
+        // compare integral values and hope it works
+        return reinterpret_cast<std::uintptr_t>(a) < reinterpret_cast<std::uintptr_t>(b);
+    #endif
+    }
+
+    // priority of a run in the treap
+    // the runs are at arbitrary addresses, so a hash of it is random enough
+    std::uintptr_t priority(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        auto x = reinterpret_cast<std::uintptr_t>(run);
+        x ^= x >> 16;
+        x *= std::uintptr_t(0x9E3779B97F4A7C15ull);
+        x ^= x >> 15;
+        return x;
+    }
+
+    char* run_end(free_run *run, std::size_t slot_size) FOONATHAN_NOEXCEPT
+    {
+        return reinterpret_cast<char*>(run) + run->no_nodes * slot_size;
+    }
+
+    std::size_t max_nodes(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        return run ? run->max_nodes : 0u;
+    }
+
+    void update(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        auto max = run->no_nodes;
+        if (max_nodes(run->left) > max)
+            max = max_nodes(run->left);
+        if (max_nodes(run->right) > max)
+            max = max_nodes(run->right);
+        run->max_nodes = max;
+    }
+
+    // merges two treaps, all runs in a must be before all runs in b
+    free_run* merge(free_run *a, free_run *b) FOONATHAN_NOEXCEPT
+    {
+        if (!a)
+            return b;
+        else if (!b)
+            return a;
+        else if (priority(a) > priority(b))
+        {
+            a->right = merge(a->right, b);
+            update(a);
+            return a;
+        }
+        b->left = merge(a, b->left);
+        update(b);
+        return b;
+    }
+
+    // splits a treap into the runs before memory and the runs at or after memory
+    void split(free_run *run, const char *memory, free_run *&before, free_run *&after) FOONATHAN_NOEXCEPT
+    {
+        if (!run)
+            before = after = nullptr;
+        else if (less(run, memory))
+        {
+            split(run->right, memory, run->right, after);
+            before = run;
+            update(run);
+        }
+        else
+        {
+            split(run->left, memory, before, run->left);
+            after = run;
+            update(run);
+        }
+    }
+
+    free_run* first(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        while (run->left)
+            run = run->left;
+        return run;
+    }
+
+    free_run* last(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        while (run->right)
+            run = run->right;
+        return run;
+    }
+
+    free_run* erase_first(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        if (!run->left)
+            return run->right;
+        run->left = erase_first(run->left);
+        update(run);
+        return run;
+    }
+
+    free_run* erase_last(free_run *run) FOONATHAN_NOEXCEPT
+    {
+        if (!run->right)
+            return run->left;
+        run->right = erase_last(run->right);
+        update(run);
+        return run;
+    }
+
+    // removes count nodes from the end of the first run with at least count nodes
+    // pre: max_nodes(run) >= count
+    free_run* erase_first_fit(free_run *run, std::size_t count, std::size_t slot_size,
+                              char *&memory) FOONATHAN_NOEXCEPT
+    {
+        if (max_nodes(run->left) >= count)
+            run->left = erase_first_fit(run->left, count, slot_size, memory);
+        else if (run->no_nodes >= count)
+        {
+            // take from the end, so the header can stay
+            run->no_nodes -= count;
+            memory = run_end(run, slot_size);
+            if (run->no_nodes == 0u)
+                return merge(run->left, run->right);
+        }
+        else
+            run->right = erase_first_fit(run->right, count, slot_size, memory);
+        update(run);
+        return run;
+    }
+}
+
+FOONATHAN_CONSTEXPR std::size_t indexed_free_memory_list::min_element_size;
+FOONATHAN_CONSTEXPR std::size_t indexed_free_memory_list::min_element_alignment;
+
+indexed_free_memory_list::indexed_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT
+: root_(nullptr),
+  node_size_(node_size > min_element_size ? node_size : min_element_size),
+  capacity_(0u)
+{}
+
+indexed_free_memory_list::indexed_free_memory_list(std::size_t node_size,
+                                                   void *mem, std::size_t size) FOONATHAN_NOEXCEPT
+: indexed_free_memory_list(node_size)
+{
+    insert(mem, size);
+}
+
+indexed_free_memory_list::indexed_free_memory_list(indexed_free_memory_list &&other) FOONATHAN_NOEXCEPT
+: root_(other.root_),
+  node_size_(other.node_size_), capacity_(other.capacity_)
+{
+    other.root_ = nullptr;
+    other.capacity_ = 0u;
+}
+
+indexed_free_memory_list& indexed_free_memory_list::operator=(indexed_free_memory_list &&other) FOONATHAN_NOEXCEPT
+{
+    indexed_free_memory_list tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(indexed_free_memory_list &a, indexed_free_memory_list &b) FOONATHAN_NOEXCEPT
+{
+    detail::adl_swap(a.root_, b.root_);
+    detail::adl_swap(a.node_size_, b.node_size_);
+    detail::adl_swap(a.capacity_, b.capacity_);
+}
+
+void indexed_free_memory_list::insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, alignment()));
+    auto no_nodes = size / slot_size();
+    insert_run(static_cast<char*>(mem), no_nodes);
+    capacity_ += no_nodes;
+}
+
+void* indexed_free_memory_list::allocate() FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(!empty());
+    --capacity_;
+
+    // any run will do, so take the last node of the root
+    auto run = root_;
+    --run->no_nodes;
+    auto node = run_end(run, slot_size());
+    if (run->no_nodes == 0u)
+        root_ = merge(run->left, run->right);
+    else
+        update(run);
+
+    // alignment is fence memory
+    return debug_fill_new(node, node_size_, alignment());
+}
+
+void* indexed_free_memory_list::allocate(std::size_t n) FOONATHAN_NOEXCEPT
+{
+    auto count = no_slots(n);
+    if (max_nodes(root_) < count)
+        return nullptr;
+
+    char *memory = nullptr;
+    root_ = erase_first_fit(root_, count, slot_size(), memory);
+    FOONATHAN_MEMORY_ASSERT(memory);
+    capacity_ -= count;
+
+    // alignment is fence memory
+    return debug_fill_new(memory, n, alignment());
+}
+
+void indexed_free_memory_list::deallocate(void *ptr) FOONATHAN_NOEXCEPT
+{
+    // alignment is fence memory
+    auto node = debug_fill_free(ptr, node_size_, alignment());
+    insert_run(node, 1u);
+    ++capacity_;
+}
+
+void indexed_free_memory_list::deallocate(void *ptr, std::size_t n) FOONATHAN_NOEXCEPT
+{
+    // alignment is fence memory
+    auto node = debug_fill_free(ptr, n, alignment());
+    auto count = no_slots(n);
+    insert_run(node, count);
+    capacity_ += count;
+}
+
+std::size_t indexed_free_memory_list::node_size() const FOONATHAN_NOEXCEPT
+{
+    return node_size_;
+}
+
+std::size_t indexed_free_memory_list::alignment() const FOONATHAN_NOEXCEPT
+{
+    return alignment_for(node_size_);
+}
+
+std::size_t indexed_free_memory_list::slot_size() const FOONATHAN_NOEXCEPT
+{
+    auto size = (node_size_ + alignment() - 1u) / alignment() * alignment();
+    return size + (debug_fence_size ? 2 * alignment() : 0u);
+}
+
+std::size_t indexed_free_memory_list::no_slots(std::size_t n) const FOONATHAN_NOEXCEPT
+{
+    auto fence = debug_fence_size ? alignment() : 0u;
+    return (fence + n + fence + slot_size() - 1u) / slot_size();
+}
+
+void indexed_free_memory_list::insert_run(char *memory, std::size_t no_nodes) FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(no_nodes > 0u);
+    auto info = allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::indexed_free_memory_list", this);
+    auto end = memory + no_nodes * slot_size();
+
+    free_run *before, *after;
+    split(root_, memory, before, after);
+
+    if (before)
+    {
+        auto prev = last(before);
+        // memory is already in the previous run
+        check_pointer(!less(memory, run_end(prev, slot_size())), info, memory);
+        if (run_end(prev, slot_size()) == memory)
+        {
+            before = erase_last(before);
+            memory = reinterpret_cast<char*>(prev);
+            no_nodes += prev->no_nodes;
+        }
+    }
+    if (after)
+    {
+        auto next = first(after);
+        // memory overlaps with the next run
+        check_pointer(!less(next, end), info, memory);
+        if (reinterpret_cast<char*>(next) == end)
+        {
+            after = erase_first(after);
+            no_nodes += next->no_nodes;
+        }
+    }
+
+    auto run = ::new(static_cast<void*>(memory)) free_run;
+    run->left = run->right = nullptr;
+    run->no_nodes = run->max_nodes = no_nodes;
+    root_ = merge(merge(before, run), after);
+}
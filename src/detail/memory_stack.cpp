@@ -4,6 +4,8 @@
 
 #include "detail/memory_stack.hpp"
 
+#include <cstdint>
+
 #include "detail/align.hpp"
 #include "debugging.hpp"
 
@@ -54,3 +56,30 @@ void fixed_memory_stack::unwind(char *top) FOONATHAN_NOEXCEPT
     debug_fill(top, std::size_t(cur_ - top), debug_magic::freed_memory);
     cur_ = top;
 }
+
+void* detail::allocate_reverse(char *&top, const char *begin,
+                               std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+{
+    auto remaining = std::size_t(top - begin);
+    if (debug_fence_size + size + debug_fence_size > remaining)
+        return nullptr;
+    // align downwards
+    auto offset = std::size_t(reinterpret_cast<std::uintptr_t>(top - debug_fence_size - size) & (alignment - 1u));
+    if (debug_fence_size + size + offset + debug_fence_size > remaining)
+        return nullptr;
+
+    top -= debug_fence_size;
+    debug_fill(top, debug_fence_size, debug_magic::fence_memory);
+
+    top -= offset;
+    debug_fill(top, offset, debug_magic::alignment_memory);
+
+    top -= size;
+    auto memory = top;
+    debug_fill(top, size, debug_magic::new_memory);
+
+    top -= debug_fence_size;
+    debug_fill(top, debug_fence_size, debug_magic::fence_memory);
+
+    return memory;
+}
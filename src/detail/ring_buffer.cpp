@@ -0,0 +1,176 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/ring_buffer.hpp"
+
+#include <cstring>
+
+#include "detail/align.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+namespace
+{
+    // records are multiples of it, so the memory after a header is always aligned for it
+    FOONATHAN_CONSTEXPR std::size_t granularity = detail::max_alignment;
+    FOONATHAN_CONSTEXPR std::size_t header_size = granularity;
+    static_assert(sizeof(std::size_t) <= header_size, "header does not fit");
+
+    // the header stores the length of the record including the header, the lowest bit is the free flag
+    FOONATHAN_CONSTEXPR std::size_t free_bit = 1u;
+
+    std::size_t round_up(std::size_t size) FOONATHAN_NOEXCEPT
+    {
+        return (size + granularity - 1u) / granularity * granularity;
+    }
+
+    std::size_t get_header(const char *record) FOONATHAN_NOEXCEPT
+    {
+        std::size_t header;
+        std::memcpy(&header, record, sizeof(header));
+        return header;
+    }
+
+    void set_header(char *record, std::size_t length, bool free) FOONATHAN_NOEXCEPT
+    {
+        std::size_t header = length | (free ? free_bit : 0u);
+        std::memcpy(record, &header, sizeof(header));
+    }
+
+    std::size_t record_length(const char *record) FOONATHAN_NOEXCEPT
+    {
+        return get_header(record) & ~free_bit;
+    }
+
+    bool is_free(const char *record) FOONATHAN_NOEXCEPT
+    {
+        return (get_header(record) & free_bit) != 0u;
+    }
+}
+
+fixed_ring_buffer::fixed_ring_buffer(void *memory, std::size_t size) FOONATHAN_NOEXCEPT
+: fixed_ring_buffer()
+{
+    auto offset = align_offset(memory, granularity);
+    if (offset >= size)
+        return;
+    begin_ = static_cast<char*>(memory) + offset;
+    end_ = begin_ + (size - offset) / granularity * granularity;
+    head_ = tail_ = begin_;
+}
+
+fixed_ring_buffer::fixed_ring_buffer(fixed_ring_buffer &&other) FOONATHAN_NOEXCEPT
+: begin_(other.begin_), end_(other.end_), head_(other.head_), tail_(other.tail_),
+  live_(other.live_), wrapped_(other.wrapped_)
+{
+    other.begin_ = other.end_ = other.head_ = other.tail_ = nullptr;
+    other.live_ = 0u;
+    other.wrapped_ = false;
+}
+
+fixed_ring_buffer& fixed_ring_buffer::operator=(fixed_ring_buffer &&other) FOONATHAN_NOEXCEPT
+{
+    begin_ = other.begin_;
+    end_ = other.end_;
+    head_ = other.head_;
+    tail_ = other.tail_;
+    live_ = other.live_;
+    wrapped_ = other.wrapped_;
+    other.begin_ = other.end_ = other.head_ = other.tail_ = nullptr;
+    other.live_ = 0u;
+    other.wrapped_ = false;
+    return *this;
+}
+
+void* fixed_ring_buffer::allocate(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+{
+    if (wrapped_)
+        return allocate_at(head_, tail_, size, alignment);
+    else if (auto mem = allocate_at(head_, end_, size, alignment))
+        return mem;
+
+    // wrap around, the rest of the buffer becomes padding
+    auto old_head = head_;
+    auto mem = allocate_at(begin_, tail_, size, alignment);
+    if (!mem)
+        return nullptr;
+    if (old_head != end_)
+        set_header(old_head, std::size_t(end_ - old_head), true);
+    wrapped_ = true;
+    return mem;
+}
+
+void fixed_ring_buffer::deallocate(void *ptr) FOONATHAN_NOEXCEPT
+{
+    auto info = allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::fixed_ring_buffer", this);
+
+    auto record = static_cast<char*>(ptr) - header_size;
+    // double-free
+    check_pointer(!is_free(record), info, ptr);
+    set_header(record, record_length(record), true);
+    detail::debug_fill(ptr, record_length(record) - header_size, debug_magic::freed_memory);
+
+    if (--live_ == 0u)
+    {
+        // start at the beginning again to get the most contiguous space
+        head_ = tail_ = begin_;
+        wrapped_ = false;
+        return;
+    }
+
+    // reclaim all free records at the tail, there is a live one somewhere
+    while (is_free(tail_))
+    {
+        tail_ += record_length(tail_);
+        if (tail_ == end_)
+        {
+            tail_ = begin_;
+            wrapped_ = false;
+        }
+    }
+}
+
+std::size_t fixed_ring_buffer::capacity() const FOONATHAN_NOEXCEPT
+{
+    if (wrapped_)
+        return std::size_t(tail_ - head_);
+    return std::size_t(end_ - head_) + std::size_t(tail_ - begin_);
+}
+
+bool fixed_ring_buffer::owns(const void *ptr) const FOONATHAN_NOEXCEPT
+{
+    auto address = static_cast<const char*>(ptr);
+    return begin_ <= address && address < end_;
+}
+
+void* fixed_ring_buffer::allocate_at(char *pos, const char *limit,
+                                     std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+{
+    // also prevents round_up() from overflowing
+    if (size > std::size_t(limit - pos))
+        return nullptr;
+
+    // an over-aligned allocation is preceded by a free padding record
+    // the offset is a multiple of the granularity, so there is always room for its header
+    auto padding = alignment > granularity ? align_offset(pos + header_size, alignment) : 0u;
+    auto length = header_size + round_up(size ? size : 1u);
+    if (std::size_t(limit - pos) < padding + length)
+        return nullptr;
+
+    if (padding != 0u)
+    {
+        set_header(pos, padding, true);
+        pos += padding;
+    }
+    set_header(pos, length, false);
+    ++live_;
+    head_ = pos + length;
+
+    auto memory = pos + header_size;
+    detail::debug_fill(memory, length - header_size, debug_magic::new_memory);
+    return memory;
+}
@@ -4,6 +4,10 @@
 
 #include "detail/small_free_list.hpp"
 
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <new>
 
@@ -15,10 +19,16 @@
 using namespace foonathan::memory;
 using namespace detail;
 
+// index of a node in a chunk
+// the header always uses 16 bit, the nodes use 8 bit unless they are wide enough
+using chunk_index = std::uint16_t;
+
 struct detail::chunk
 {
     chunk *next = this, *prev = this;
-    unsigned char first_node = 0u, capacity = 0u, no_nodes = 0u;
+    chunk *next_odd = nullptr; // next chunk that is not on the grid in the same bucket
+    chunk_index first_node = 0u, capacity = 0u, no_nodes = 0u;
+    std::uint16_t tag = 0u; // tag of the list owning the chunk
 };
 
 namespace
@@ -28,8 +38,27 @@ namespace
     // offset from chunk to actual list
     static FOONATHAN_CONSTEXPR auto chunk_memory_offset = alignment_mod == 0u ? sizeof(chunk)
                                         : (alignment_div + 1) * detail::max_alignment;
+    // maximum nodes per chunk with 8 bit indices
+    static FOONATHAN_CONSTEXPR std::size_t narrow_max_nodes = std::numeric_limits<unsigned char>::max();
+    // size of a chunk with 16 bit indices
+    // 8 bit chunks of nodes that can store a 16 bit index and are smaller than this use it instead
+    static FOONATHAN_CONSTEXPR std::size_t wide_chunk_size = 4096u;
+    static_assert((wide_chunk_size - chunk_memory_offset) / sizeof(chunk_index)
+                    <= std::numeric_limits<chunk_index>::max(), "chunk index too small");
+
+    // whether or not the nodes of a chunk use 16 bit indices
+    // only done if it results in fewer chunks
+    bool wide_index(std::size_t node_size) FOONATHAN_NOEXCEPT
+    {
+        return node_size >= sizeof(chunk_index)
+            && chunk_memory_offset + node_size * narrow_max_nodes < wide_chunk_size;
+    }
+
     // maximum nodes per chunk
-    static FOONATHAN_CONSTEXPR auto chunk_max_nodes = std::numeric_limits<unsigned char>::max();
+    std::size_t chunk_max_nodes(std::size_t node_size) FOONATHAN_NOEXCEPT
+    {
+        return wide_index(node_size) ? (wide_chunk_size - chunk_memory_offset) / node_size : narrow_max_nodes;
+    }
 
     // returns the memory of the actual free list of a chunk
     unsigned char* list_memory(void *c) FOONATHAN_NOEXCEPT
@@ -37,17 +66,55 @@ namespace
         return static_cast<unsigned char*>(c) + chunk_memory_offset;
     }
 
+    // reads/writes the index of the next free node stored in a node
+    // nodes are not aligned for 16 bit, so memcpy
+    std::size_t get_index(const unsigned char *node, bool wide) FOONATHAN_NOEXCEPT
+    {
+        if (!wide)
+            return *node;
+        chunk_index index;
+        std::memcpy(&index, node, sizeof(index));
+        return index;
+    }
+
+    void set_index(unsigned char *node, std::size_t index, bool wide) FOONATHAN_NOEXCEPT
+    {
+        if (!wide)
+            *node = static_cast<unsigned char>(index);
+        else
+        {
+            auto i = static_cast<chunk_index>(index);
+            std::memcpy(node, &i, sizeof(i));
+        }
+    }
+
+    // returns a new tag for a list, never 0
+    // it only needs to be different for lists used at the same time, so it can wrap around
+    std::uint16_t new_tag() FOONATHAN_NOEXCEPT
+    {
+        static std::atomic<std::uint16_t> counter(0u);
+        std::uint16_t tag;
+        do
+        {
+            tag = ++counter;
+        } while (tag == 0u);
+        return tag;
+    }
+
     // creates a chunk at mem
     // mem must have at least the size chunk_memory_offset + no_nodes * node_size
-    chunk* create_chunk(void *mem, std::size_t node_size, unsigned char no_nodes) FOONATHAN_NOEXCEPT
+    chunk* create_chunk(void *mem, std::size_t node_size, std::size_t no_nodes,
+                        std::uint16_t tag) FOONATHAN_NOEXCEPT
     {
         auto c = ::new(mem) chunk;
+        c->tag = tag;
         c->first_node = 0;
-        c->no_nodes = no_nodes;
-        c->capacity = no_nodes;
+        c->no_nodes = static_cast<chunk_index>(no_nodes);
+        c->capacity = static_cast<chunk_index>(no_nodes);
+        auto wide = wide_index(node_size);
         auto p = list_memory(c);
-        for (unsigned char i = 0u; i != no_nodes; p += node_size)
-            *p = ++i;
+        for (std::size_t i = 0u; i != no_nodes; p += node_size)
+            set_index(p, ++i, wide);
         return c;
     }
 
@@ -59,33 +126,54 @@ namespace
             && mem < list_memory(c) + node_size * c->no_nodes;
     }
 
+    // number of nodes a chunk of given size can hold
+    std::size_t chunk_nodes(std::size_t size, std::size_t node_size) FOONATHAN_NOEXCEPT
+    {
+        if (size <= chunk_memory_offset)
+            return 0u;
+        auto nodes = (size - chunk_memory_offset) / node_size;
+        auto max_nodes = chunk_max_nodes(node_size);
+        return nodes < max_nodes ? nodes : max_nodes;
+    }
+
+    // size of a chunk, a power of two around the size needed for the maximum number of nodes
+    // chunks are aligned at their size, so the chunk of a node can be calculated by masking its address
+    std::size_t chunk_size(std::size_t node_size) FOONATHAN_NOEXCEPT
+    {
+        if (wide_index(node_size))
+            return wide_chunk_size;
+
+        // largest power of two not greater than the maximum size
+        auto size = chunk_memory_offset + node_size * narrow_max_nodes;
+        for (std::size_t shift = 1u; shift < sizeof(std::size_t) * CHAR_BIT; shift *= 2u)
+            size |= size >> shift;
+        size = (size >> 1) + 1u;
+        // the next power of two can hold all nodes,
+        // it wastes less memory if this one cannot hold half of them
+        return size - chunk_memory_offset < (narrow_max_nodes / 2u + 1u) * node_size ? 2u * size : size;
+    }
+
+    // returns the position of the chunk on the grid that contains memory
+    char* grid_position(const void *memory, std::size_t chunk_size) FOONATHAN_NOEXCEPT
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(memory);
+        return reinterpret_cast<char*>(address & ~std::uintptr_t(chunk_size - 1u));
+    }
+
     // whether or not a pointer is in the list of a certain chunk
     bool chunk_contains(chunk *c, std::size_t node_size, void *pointer) FOONATHAN_NOEXCEPT
     {
-        auto cur_index = c->first_node;
+        auto wide = wide_index(node_size);
+        std::size_t cur_index = c->first_node;
         while (cur_index != c->no_nodes)
         {
             auto cur_mem = list_memory(c) + cur_index * node_size;
             if (cur_mem == pointer)
                 return true;
-            cur_index = *cur_mem;
+            cur_index = get_index(cur_mem, wide);
         }
         return false;
     }
-
-    // advances a pointer to the next chunk
-    void next(chunk* &c) FOONATHAN_NOEXCEPT
-    {
-        FOONATHAN_MEMORY_ASSERT(c);
-        c = c->next;
-    }
-
-    // advances a pointer to the previous chunk
-    void prev(chunk* &c) FOONATHAN_NOEXCEPT
-    {
-        FOONATHAN_MEMORY_ASSERT(c);
-        c = c->prev;
-    }
 }
 
 chunk_list::chunk_list(chunk_list &&other) FOONATHAN_NOEXCEPT
@@ -120,6 +208,7 @@ void chunk_list::insert(chunk *c) FOONATHAN_NOEXCEPT
     {
         c->next = first_;
         c->prev = first_->prev;
+        c->prev->next = c;
         first_->prev = c;
         first_ = c;
     }
@@ -129,15 +218,7 @@ chunk* chunk_list::insert(chunk_list &other) FOONATHAN_NOEXCEPT
 {
     FOONATHAN_MEMORY_ASSERT(!other.empty());
     auto c = other.first_;
-    if (other.first_ == other.first_->next)
-        // only element
-        other.first_ = nullptr;
-    else
-    {
-        c->prev->next = c->next;
-        c->next->prev = c->prev;
-        other.first_ = other.first_->next;
-    }
+    other.erase(c);
     insert(c);
     return c;
 }
@@ -146,8 +227,13 @@ FOONATHAN_CONSTEXPR std::size_t small_free_memory_list::min_element_size;
 FOONATHAN_CONSTEXPR std::size_t small_free_memory_list::min_element_alignment;
 
 small_free_memory_list::small_free_memory_list(std::size_t node_size) FOONATHAN_NOEXCEPT
-: alloc_chunk_(nullptr), dealloc_chunk_(nullptr),
-  node_size_(node_size), capacity_(0u) {}
+: alloc_chunk_(nullptr), dealloc_chunk_(nullptr), last_chunk_(nullptr),
+  uncarved_begin_(nullptr), uncarved_end_(nullptr),
+  node_size_(node_size), capacity_(0u), tag_(new_tag())
+{
+    for (auto &bucket : odd_chunks_)
+        bucket = nullptr;
+}
 
 small_free_memory_list::small_free_memory_list(std::size_t node_size,
                                     void *mem, std::size_t size) FOONATHAN_NOEXCEPT
@@ -157,12 +243,22 @@ small_free_memory_list::small_free_memory_list(std::size_t node_size,
 }
 
 small_free_memory_list::small_free_memory_list(small_free_memory_list &&other) FOONATHAN_NOEXCEPT
-: unused_chunks_(detail::move(other.unused_chunks_)), used_chunks_(detail::move(other.used_chunks_)),
-  alloc_chunk_(other.alloc_chunk_), dealloc_chunk_(other.dealloc_chunk_),
-  node_size_(other.node_size_), capacity_(other.capacity_)
+: unused_chunks_(detail::move(other.unused_chunks_)), partial_chunks_(detail::move(other.partial_chunks_)),
+  full_chunks_(detail::move(other.full_chunks_)),
+  alloc_chunk_(other.alloc_chunk_), dealloc_chunk_(other.dealloc_chunk_), last_chunk_(other.last_chunk_),
+  uncarved_begin_(other.uncarved_begin_), uncarved_end_(other.uncarved_end_),
+  node_size_(other.node_size_), capacity_(other.capacity_), tag_(other.tag_)
 {
-    other.alloc_chunk_ = other.dealloc_chunk_ = nullptr;
+    for (std::size_t i = 0u; i != no_odd_buckets; ++i)
+    {
+        odd_chunks_[i] = other.odd_chunks_[i];
+        other.odd_chunks_[i] = nullptr;
+    }
+    other.alloc_chunk_ = other.dealloc_chunk_ = other.last_chunk_ = nullptr;
+    other.uncarved_begin_ = other.uncarved_end_ = nullptr;
     other.capacity_ = 0u;
+    // the chunks keep the tag
+    other.tag_ = new_tag();
 }
 
 small_free_memory_list& small_free_memory_list::operator=(small_free_memory_list &&other) FOONATHAN_NOEXCEPT
@@ -175,39 +271,105 @@ small_free_memory_list& small_free_memory_list::operator=(small_free_memory_list
 void foonathan::memory::detail::swap(small_free_memory_list &a, small_free_memory_list &b) FOONATHAN_NOEXCEPT
 {
     detail::adl_swap(a.unused_chunks_, b.unused_chunks_);
-    detail::adl_swap(a.used_chunks_, b.used_chunks_);
+    detail::adl_swap(a.partial_chunks_, b.partial_chunks_);
+    detail::adl_swap(a.full_chunks_, b.full_chunks_);
     detail::adl_swap(a.alloc_chunk_, b.alloc_chunk_);
     detail::adl_swap(a.dealloc_chunk_, b.dealloc_chunk_);
+    detail::adl_swap(a.last_chunk_, b.last_chunk_);
+    for (std::size_t i = 0u; i != small_free_memory_list::no_odd_buckets; ++i)
+        detail::adl_swap(a.odd_chunks_[i], b.odd_chunks_[i]);
+    detail::adl_swap(a.uncarved_begin_, b.uncarved_begin_);
+    detail::adl_swap(a.uncarved_end_, b.uncarved_end_);
     detail::adl_swap(a.node_size_, b.node_size_);
     detail::adl_swap(a.capacity_, b.capacity_);
+    detail::adl_swap(a.tag_, b.tag_);
+}
+
+void chunk_list::erase(chunk *c) FOONATHAN_NOEXCEPT
+{
+    FOONATHAN_MEMORY_ASSERT(!empty());
+    if (c->next == c)
+        // only element
+        first_ = nullptr;
+    else
+    {
+        c->prev->next = c->next;
+        c->next->prev = c->prev;
+        if (first_ == c)
+            first_ = c->next;
+    }
+    c->next = c->prev = c;
 }
 
 void small_free_memory_list::insert(void *memory, std::size_t size) FOONATHAN_NOEXCEPT
 {
     FOONATHAN_MEMORY_ASSERT(is_aligned(memory, max_alignment));
-    auto chunk_unit = chunk_memory_offset + node_fence_size() * chunk_max_nodes;
-    auto no_chunks = size / chunk_unit;
-    auto mem = static_cast<char*>(memory);
-    for (std::size_t i = 0; i != no_chunks; ++i)
+    auto begin = static_cast<char*>(memory), end = begin + size;
+    auto old_capacity = capacity_;
+
+    if (begin == uncarved_end_ && uncarved_begin_ != uncarved_end_)
+        // continue the uncarved memory
+        capacity_ -= no_nodes(uncarved_begin_, uncarved_end_);
+    else
     {
-        auto c = create_chunk(mem, node_fence_size(), chunk_max_nodes);
-        unused_chunks_.insert(c);
-        mem += chunk_unit;
+        // carve the rest of the previous memory now, only one uncarved range is stored
+        while (auto c = carve_chunk())
+            unused_chunks_.insert(c);
+
+        // memory directly after the last chunk would start a chunk off the grid, so put it into the last chunk
+        if (last_chunk_ && begin == uncarved_end_)
+            begin = extend_last_chunk(begin, end);
+        uncarved_begin_ = begin;
     }
-    std::size_t remaining = 0;
-    if (size % chunk_unit > chunk_memory_offset)
+    uncarved_end_ = end;
+    capacity_ += no_nodes(uncarved_begin_, uncarved_end_);
+
+    FOONATHAN_MEMORY_ASSERT_MSG(capacity_ > old_capacity, "too small memory size");
+}
+
+bool small_free_memory_list::remove(void *memory, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    auto begin = static_cast<char*>(memory), end = begin + size;
+    // the uncarved memory does not have chunks yet
+    auto uncarved = begin <= uncarved_begin_ && uncarved_end_ <= end;
+    auto carved_end = uncarved ? uncarved_begin_ : end;
+
+    for (auto cur = begin; auto c = next_carved_chunk(cur, carved_end);)
+        if (c->capacity != c->no_nodes)
+            return false;
+
+    for (auto cur = begin; auto c = next_carved_chunk(cur, carved_end);)
     {
-        remaining = size % chunk_unit - chunk_memory_offset;
-        if (remaining > node_fence_size())
+        // an unused chunk is in the unused list, unless it is the alloc_chunk_
+        if (c == alloc_chunk_)
         {
-            auto c = create_chunk(mem, node_fence_size(),
-                                  static_cast<unsigned char>(remaining / node_fence_size()));
-            unused_chunks_.insert(c);
+            partial_chunks_.erase(c);
+            alloc_chunk_ = nullptr;
+        }
+        else
+            unused_chunks_.erase(c);
+        if (c == dealloc_chunk_)
+            dealloc_chunk_ = nullptr;
+        if (c == last_chunk_)
+            last_chunk_ = nullptr;
+
+        if (grid_position(c, chunk_size(node_fence_size())) != reinterpret_cast<char*>(c))
+        {
+            auto next = &odd_bucket(c);
+            while (*next != c)
+                next = &(*next)->next_odd;
+            *next = c->next_odd;
         }
+        capacity_ -= c->no_nodes;
     }
-    auto inserted_memory = no_chunks * chunk_max_nodes + remaining / node_fence_size();
-    FOONATHAN_MEMORY_ASSERT_MSG(inserted_memory > 0u, "too small memory size");
-    capacity_ += inserted_memory;
+
+    if (uncarved)
+    {
+        capacity_ -= no_nodes(uncarved_begin_, uncarved_end_);
+        // memory inserted later must not continue it
+        uncarved_begin_ = uncarved_end_ = nullptr;
+    }
+    return true;
 }
 
 void* small_free_memory_list::allocate() FOONATHAN_NOEXCEPT
@@ -217,7 +379,7 @@ void* small_free_memory_list::allocate() FOONATHAN_NOEXCEPT
     FOONATHAN_MEMORY_ASSERT(alloc_chunk_ && alloc_chunk_->capacity != 0u);
 
     auto node_memory = list_memory(alloc_chunk_) + alloc_chunk_->first_node * node_fence_size();
-    alloc_chunk_->first_node = *node_memory;
+    alloc_chunk_->first_node = static_cast<chunk_index>(get_index(node_memory, wide_index(node_fence_size())));
     --alloc_chunk_->capacity;
     --capacity_;
 
@@ -230,6 +392,7 @@ void small_free_memory_list::deallocate(void *memory) FOONATHAN_NOEXCEPT
     debug_fill(memory, node_size(), debug_magic::freed_memory);
     auto node_memory = static_cast<unsigned char*>(memory) - (debug_fence_size ? alignment() : 0u);
     auto dealloc_chunk = chunk_for(node_memory);
+    dealloc_chunk_ = dealloc_chunk;
 
     auto info = allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::small_free_memory_list", this);
 
@@ -243,10 +406,24 @@ void small_free_memory_list::deallocate(void *memory) FOONATHAN_NOEXCEPT
     check_pointer(!chunk_contains(dealloc_chunk, node_fence_size(), node_memory), info, memory);
 #endif
 
-    *node_memory = dealloc_chunk->first_node;
-    dealloc_chunk->first_node = static_cast<unsigned char>(offset / node_fence_size());
+    if (dealloc_chunk->capacity == 0u && dealloc_chunk != alloc_chunk_)
+    {
+        // no longer full
+        full_chunks_.erase(dealloc_chunk);
+        partial_chunks_.insert(dealloc_chunk);
+    }
+
+    set_index(node_memory, dealloc_chunk->first_node, wide_index(node_fence_size()));
+    dealloc_chunk->first_node = static_cast<chunk_index>(offset / node_fence_size());
     ++dealloc_chunk->capacity;
     ++capacity_;
+
+    if (dealloc_chunk->capacity == dealloc_chunk->no_nodes && dealloc_chunk != alloc_chunk_)
+    {
+        // completely unused again, so it can be used for anything
+        partial_chunks_.erase(dealloc_chunk);
+        unused_chunks_.insert(dealloc_chunk);
+    }
 }
 
 std::size_t small_free_memory_list::node_size() const FOONATHAN_NOEXCEPT
@@ -261,78 +438,192 @@ std::size_t small_free_memory_list::alignment() const FOONATHAN_NOEXCEPT
 
 bool small_free_memory_list::find_chunk(std::size_t n) FOONATHAN_NOEXCEPT
 {
-    FOONATHAN_MEMORY_ASSERT(capacity_ >= n && n <= chunk_max_nodes);
+    FOONATHAN_MEMORY_ASSERT(capacity_ >= n && n <= chunk_max_nodes(node_fence_size()));
     if (alloc_chunk_ && alloc_chunk_->capacity >= n)
         return true;
-    else if (!unused_chunks_.empty())
+
+    // put the old chunk where it belongs
+    if (alloc_chunk_ && alloc_chunk_->capacity == 0u)
     {
-        alloc_chunk_ = used_chunks_.insert(unused_chunks_);
-        if (!dealloc_chunk_)
-            dealloc_chunk_ = alloc_chunk_;
-        return true;
+        partial_chunks_.erase(alloc_chunk_);
+        full_chunks_.insert(alloc_chunk_);
     }
-    FOONATHAN_MEMORY_ASSERT(dealloc_chunk_);
-    if (dealloc_chunk_->capacity >= n)
+    else if (alloc_chunk_ && alloc_chunk_->capacity == alloc_chunk_->no_nodes)
     {
-        alloc_chunk_ = dealloc_chunk_;
-        return true;
+        partial_chunks_.erase(alloc_chunk_);
+        unused_chunks_.insert(alloc_chunk_);
     }
+    alloc_chunk_ = nullptr;
 
-    auto forward_iter = dealloc_chunk_, backward_iter = dealloc_chunk_;
-    do
+    // prefer partially used chunks, so that unused ones stay unused
+    if (n == 1u && !partial_chunks_.empty())
+        // every chunk there has a free node
+        alloc_chunk_ = partial_chunks_.top();
+    else if (n != 1u && !partial_chunks_.empty())
     {
-        forward_iter = forward_iter->next;
-        backward_iter = backward_iter->prev;
+        auto cur = partial_chunks_.top();
+        do
+        {
+            if (cur->capacity >= n)
+            {
+                alloc_chunk_ = cur;
+                break;
+            }
+            cur = cur->next;
+        } while (cur != partial_chunks_.top());
+    }
 
-        if (forward_iter->capacity >= n)
+    if (!alloc_chunk_ && !unused_chunks_.empty() && unused_chunks_.top()->capacity >= n)
+        alloc_chunk_ = partial_chunks_.insert(unused_chunks_);
+    else if (!alloc_chunk_)
+    {
+        auto c = carve_chunk();
+        while (c && c->capacity < n)
         {
-            alloc_chunk_ = forward_iter;
-            return true;
+            // only happens for small chunks at the end of the memory
+            unused_chunks_.insert(c);
+            c = carve_chunk();
         }
-        else if (backward_iter->capacity >= n)
+        if (c)
         {
-            alloc_chunk_ = backward_iter;
-            return true;
+            partial_chunks_.insert(c);
+            alloc_chunk_ = c;
         }
-    } while (forward_iter != backward_iter);
-    return false;
+    }
+
+    if (alloc_chunk_ && !dealloc_chunk_)
+        dealloc_chunk_ = alloc_chunk_;
+    return alloc_chunk_ != nullptr;
 }
 
 chunk* small_free_memory_list::chunk_for(void *memory) FOONATHAN_NOEXCEPT
 {
-    FOONATHAN_MEMORY_ASSERT(dealloc_chunk_ && alloc_chunk_);
-    if (from_chunk(dealloc_chunk_, node_fence_size(), memory))
+    // consecutive deallocations are often from the same chunk
+    if (dealloc_chunk_ && from_chunk(dealloc_chunk_, node_fence_size(), memory))
         return dealloc_chunk_;
-    else if (from_chunk(alloc_chunk_, node_fence_size(), memory))
+
+    // chunks off the grid are only at the beginning of inserted memory that does not continue the previous one,
+    // only the few in the same bucket can contain it
+    for (auto c = odd_bucket(memory); c; c = c->next_odd)
+        if (from_chunk(c, node_fence_size(), memory))
+            return c;
+
+    // otherwise the chunk is at the beginning of the grid cell
+    auto c = reinterpret_cast<chunk*>(grid_position(memory, chunk_size(node_fence_size())));
+#if FOONATHAN_MEMORY_DEBUG_POINTER_CHECK
+    // memory never managed by this list does not have a chunk of it there
+    if (c->tag != tag_)
+        return nullptr;
+#endif
+    return from_chunk(c, node_fence_size(), memory) ? c : nullptr;
+}
+
+chunk*& small_free_memory_list::odd_bucket(const void *memory) FOONATHAN_NOEXCEPT
+{
+    auto cell = reinterpret_cast<std::uintptr_t>(memory) / chunk_size(node_fence_size());
+    return odd_chunks_[cell % no_odd_buckets];
+}
+
+char* small_free_memory_list::extend_last_chunk(char *begin, char *end) FOONATHAN_NOEXCEPT
+{
+    auto c = last_chunk_;
+    auto size = chunk_size(node_fence_size());
+    // a chunk never crosses the grid
+    auto cell_end = grid_position(c, size) + size;
+    if (begin >= cell_end)
+        return begin;
+
+    auto limit = end < cell_end ? end : cell_end;
+    auto lattice_end = reinterpret_cast<char*>(list_memory(c)) + c->no_nodes * node_fence_size();
+    auto new_nodes = std::size_t(limit - lattice_end) / node_fence_size();
+    auto max_nodes = chunk_max_nodes(node_fence_size());
+    if (c->no_nodes + new_nodes > max_nodes)
+        new_nodes = max_nodes - c->no_nodes;
+    if (new_nodes == 0u)
+        return begin;
+
+    if (c->capacity == 0u && c != alloc_chunk_)
     {
-        dealloc_chunk_ = alloc_chunk_;
-        return alloc_chunk_;
+        // no longer full
+        full_chunks_.erase(c);
+        partial_chunks_.insert(c);
     }
 
-    auto i = 0u;
-    auto forward_iter = dealloc_chunk_, backward_iter = dealloc_chunk_;
-    do
+    // the free list of the chunk ends with the index no_nodes,
+    // which is now the first new node, so they are appended to it
+    auto wide = wide_index(node_fence_size());
+    auto p = reinterpret_cast<unsigned char*>(lattice_end);
+    for (std::size_t i = c->no_nodes; i != c->no_nodes + new_nodes; p += node_fence_size())
+        set_index(p, ++i, wide);
+    c->no_nodes = static_cast<chunk_index>(c->no_nodes + new_nodes);
+    c->capacity = static_cast<chunk_index>(c->capacity + new_nodes);
+    capacity_ += new_nodes;
+
+    // the rest is carved into chunks
+    auto rest = reinterpret_cast<char*>(p);
+    rest += align_offset(rest, max_alignment);
+    return rest < begin ? begin : rest;
+}
+
+std::size_t small_free_memory_list::node_fence_size() const FOONATHAN_NOEXCEPT
+{
+    return node_size_ + (debug_fence_size ? 2 * alignment() : 0u);
+}
+
+std::size_t small_free_memory_list::no_nodes(char *begin, char *end) const FOONATHAN_NOEXCEPT
+{
+    auto size = chunk_size(node_fence_size());
+    auto grid_begin = grid_position(begin + size - 1u, size);
+    if (end <= grid_begin)
+        // only a single chunk off the grid
+        return chunk_nodes(std::size_t(end - begin), node_fence_size());
+
+    auto grid_end = grid_position(end, size);
+    // chunk off the grid at the beginning, complete chunks and a smaller one at the end
+    return chunk_nodes(std::size_t(grid_begin - begin), node_fence_size())
+         + std::size_t(grid_end - grid_begin) / size * chunk_nodes(size, node_fence_size())
+         + chunk_nodes(std::size_t(end - grid_end), node_fence_size());
+}
+
+chunk* small_free_memory_list::carve_chunk() FOONATHAN_NOEXCEPT
+{
+    auto size = chunk_size(node_fence_size());
+    while (uncarved_begin_ < uncarved_end_)
     {
-        next(forward_iter);
-        prev(backward_iter);
-        ++i;
-        if (from_chunk(forward_iter, node_fence_size(), memory))
-        {
-            dealloc_chunk_ = forward_iter;
-            return forward_iter;
-        }
-        else if (from_chunk(backward_iter, node_fence_size(), memory))
+        auto begin = uncarved_begin_;
+        auto end = grid_position(begin, size) + size;
+        uncarved_begin_ = end < uncarved_end_ ? end : uncarved_end_;
+
+        auto nodes = chunk_nodes(std::size_t(uncarved_begin_ - begin), node_fence_size());
+        if (nodes == 0u)
+            // too small for any node
+            continue;
+
+        auto c = create_chunk(begin, node_fence_size(), nodes, tag_);
+        if (grid_position(begin, size) != begin)
         {
-            dealloc_chunk_ = backward_iter;
-            return backward_iter;
+            // chunk_for() cannot calculate it
+            auto &bucket = odd_bucket(begin);
+            c->next_odd = bucket;
+            bucket = c;
         }
-    } while (forward_iter != backward_iter);
-    // at this point, both iterators point to the same chunk
-    // this only happens after the entire list has been searched
+        last_chunk_ = c;
+        return c;
+    }
     return nullptr;
 }
 
-std::size_t small_free_memory_list::node_fence_size() const FOONATHAN_NOEXCEPT
+chunk* small_free_memory_list::next_carved_chunk(char *&cur, char *end) const FOONATHAN_NOEXCEPT
 {
-    return node_size_ + (debug_fence_size ? 2 * alignment() : 0u);
+    // the same pieces as in carve_chunk()
+    auto size = chunk_size(node_fence_size());
+    while (cur < end)
+    {
+        auto begin = cur;
+        auto piece_end = grid_position(begin, size) + size;
+        cur = piece_end < end ? piece_end : end;
+        if (chunk_nodes(std::size_t(cur - begin), node_fence_size()) != 0u)
+            return reinterpret_cast<chunk*>(begin);
+    }
+    return nullptr;
 }
@@ -0,0 +1,417 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/tlsf_list.hpp"
+
+#include <climits>
+#include <new>
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "debugging.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+struct detail::tlsf_block
+{
+    tlsf_block *prev_phys; // only valid if the previous block is free
+    std::size_t size; // usable size, the lowest bits are the flags
+};
+
+namespace
+{
+    // links of a free block, they are stored in its usable memory
+    struct tlsf_links
+    {
+        tlsf_block *next, *prev;
+    };
+
+    FOONATHAN_CONSTEXPR std::size_t round_up(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+    {
+        return (size + alignment - 1u) / alignment * alignment;
+    }
+
+    FOONATHAN_CONSTEXPR std::size_t constexpr_log2(std::size_t value) FOONATHAN_NOEXCEPT
+    {
+        return value <= 1u ? 0u : 1u + constexpr_log2(value / 2u);
+    }
+
+    // block sizes are multiples of it, so the usable memory is always aligned for it
+    FOONATHAN_CONSTEXPR std::size_t granularity = detail::max_alignment;
+    FOONATHAN_CONSTEXPR std::size_t granularity_log2 = constexpr_log2(granularity);
+
+    FOONATHAN_CONSTEXPR std::size_t header_size = round_up(sizeof(tlsf_block), granularity);
+    FOONATHAN_CONSTEXPR std::size_t min_block_size = round_up(sizeof(tlsf_links), granularity);
+    // smallest block splitting off a free block is worth it
+    FOONATHAN_CONSTEXPR std::size_t min_split_size = header_size + min_block_size;
+
+    static_assert(granularity >= 4u && (granularity & (granularity - 1u)) == 0u,
+                  "flags do not fit into the size");
+
+    FOONATHAN_CONSTEXPR std::size_t free_bit = 1u;
+    FOONATHAN_CONSTEXPR std::size_t prev_free_bit = 2u;
+    FOONATHAN_CONSTEXPR std::size_t flag_bits = free_bit | prev_free_bit;
+
+    char* memory_of(tlsf_block *block) FOONATHAN_NOEXCEPT
+    {
+        return reinterpret_cast<char*>(block) + header_size;
+    }
+
+    tlsf_block* block_of(void *memory) FOONATHAN_NOEXCEPT
+    {
+        return reinterpret_cast<tlsf_block*>(static_cast<char*>(memory) - header_size);
+    }
+
+    tlsf_links& links(tlsf_block *block) FOONATHAN_NOEXCEPT
+    {
+        return *reinterpret_cast<tlsf_links*>(memory_of(block));
+    }
+
+    std::size_t block_size(const tlsf_block *block) FOONATHAN_NOEXCEPT
+    {
+        return block->size & ~flag_bits;
+    }
+
+    void set_block_size(tlsf_block *block, std::size_t size) FOONATHAN_NOEXCEPT
+    {
+        block->size = size | (block->size & flag_bits);
+    }
+
+    tlsf_block* next_phys(tlsf_block *block) FOONATHAN_NOEXCEPT
+    {
+        return reinterpret_cast<tlsf_block*>(memory_of(block) + block_size(block));
+    }
+
+    bool is_free(const tlsf_block *block) FOONATHAN_NOEXCEPT
+    {
+        return (block->size & free_bit) != 0u;
+    }
+
+    bool is_prev_free(const tlsf_block *block) FOONATHAN_NOEXCEPT
+    {
+        return (block->size & prev_free_bit) != 0u;
+    }
+
+    void set_flag(tlsf_block *block, std::size_t flag, bool value) FOONATHAN_NOEXCEPT
+    {
+        if (value)
+            block->size |= flag;
+        else
+            block->size &= ~flag;
+    }
+
+    // marks a block as free or used and updates the next block
+    void set_free(tlsf_block *block, bool value) FOONATHAN_NOEXCEPT
+    {
+        set_flag(block, free_bit, value);
+        auto next = next_phys(block);
+        set_flag(next, prev_free_bit, value);
+        next->prev_phys = block;
+    }
+
+    // index of the lowest set bit
+    // pre: value != 0
+    std::size_t find_first_set(std::uint32_t value) FOONATHAN_NOEXCEPT
+    {
+        FOONATHAN_MEMORY_ASSERT(value != 0u);
+    #if defined(__GNUC__)
+        return std::size_t(__builtin_ctzl(value));
+    #else
+        std::size_t index = 0u;
+        for (; (value & 1u) == 0u; value >>= 1)
+            ++index;
+        return index;
+    #endif
+    }
+
+    // index of the highest set bit
+    // pre: value != 0
+    std::size_t find_last_set(std::size_t value) FOONATHAN_NOEXCEPT
+    {
+        FOONATHAN_MEMORY_ASSERT(value != 0u);
+    #if defined(__GNUC__)
+        return sizeof(unsigned long long) * CHAR_BIT - 1u - std::size_t(__builtin_clzll(value));
+    #else
+        std::size_t index = 0u;
+        while (value >>= 1)
+            ++index;
+        return index;
+    #endif
+    }
+
+    // mask of all bits at or above index
+    std::uint32_t mask_from(std::size_t index) FOONATHAN_NOEXCEPT
+    {
+        return index >= 32u ? 0u : ~std::uint32_t(0u) << index;
+    }
+}
+
+FOONATHAN_CONSTEXPR std::size_t tlsf_free_memory_list::sl_count_log2;
+FOONATHAN_CONSTEXPR std::size_t tlsf_free_memory_list::sl_count;
+FOONATHAN_CONSTEXPR std::size_t tlsf_free_memory_list::fl_count;
+
+namespace
+{
+    // number of second level lists per first level is 2^sl_log2
+    FOONATHAN_CONSTEXPR std::size_t sl_log2 = 4u;
+    // sizes below it are all in the first level, divided by the granularity
+    FOONATHAN_CONSTEXPR std::size_t fl_shift = sl_log2 + granularity_log2;
+    FOONATHAN_CONSTEXPR std::size_t small_block_size = std::size_t(1) << fl_shift;
+
+    // size class containing blocks of size bytes
+    void mapping_insert(std::size_t size, std::size_t &fl, std::size_t &sl) FOONATHAN_NOEXCEPT
+    {
+        if (size < small_block_size)
+        {
+            fl = 0u;
+            sl = size >> granularity_log2;
+        }
+        else
+        {
+            auto last = find_last_set(size);
+            sl = (size >> (last - sl_log2)) ^ (std::size_t(1) << sl_log2);
+            fl = last - (fl_shift - 1u);
+        }
+    }
+
+    // first size class where every block has at least size bytes
+    void mapping_search(std::size_t size, std::size_t &fl, std::size_t &sl) FOONATHAN_NOEXCEPT
+    {
+        if (size >= small_block_size)
+            size += (std::size_t(1) << (find_last_set(size) - sl_log2)) - 1u;
+        mapping_insert(size, fl, sl);
+    }
+}
+
+tlsf_free_memory_list::tlsf_free_memory_list() FOONATHAN_NOEXCEPT
+: fl_bitmap_(0u), capacity_(0u)
+{
+    static_assert(sl_count_log2 == sl_log2 && fl_shift > sl_count_log2, "mapping out of sync");
+    static_assert(fl_count <= 32u && sl_count <= 32u, "bitmaps too small");
+
+    for (std::size_t fl = 0u; fl != fl_count; ++fl)
+    {
+        sl_bitmap_[fl] = 0u;
+        for (auto &head : free_[fl])
+            head = nullptr;
+    }
+}
+
+tlsf_free_memory_list::tlsf_free_memory_list(tlsf_free_memory_list &&other) FOONATHAN_NOEXCEPT
+: fl_bitmap_(other.fl_bitmap_), capacity_(other.capacity_)
+{
+    for (std::size_t fl = 0u; fl != fl_count; ++fl)
+    {
+        sl_bitmap_[fl] = other.sl_bitmap_[fl];
+        other.sl_bitmap_[fl] = 0u;
+        for (std::size_t sl = 0u; sl != sl_count; ++sl)
+        {
+            free_[fl][sl] = other.free_[fl][sl];
+            other.free_[fl][sl] = nullptr;
+        }
+    }
+    other.fl_bitmap_ = 0u;
+    other.capacity_ = 0u;
+}
+
+tlsf_free_memory_list& tlsf_free_memory_list::operator=(tlsf_free_memory_list &&other) FOONATHAN_NOEXCEPT
+{
+    tlsf_free_memory_list tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(tlsf_free_memory_list &a, tlsf_free_memory_list &b) FOONATHAN_NOEXCEPT
+{
+    for (std::size_t fl = 0u; fl != tlsf_free_memory_list::fl_count; ++fl)
+    {
+        detail::adl_swap(a.sl_bitmap_[fl], b.sl_bitmap_[fl]);
+        for (std::size_t sl = 0u; sl != tlsf_free_memory_list::sl_count; ++sl)
+            detail::adl_swap(a.free_[fl][sl], b.free_[fl][sl]);
+    }
+    detail::adl_swap(a.fl_bitmap_, b.fl_bitmap_);
+    detail::adl_swap(a.capacity_, b.capacity_);
+}
+
+void tlsf_free_memory_list::insert(void *mem, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    auto offset = align_offset(mem, granularity);
+    if (offset >= size)
+        return;
+    auto memory = static_cast<char*>(mem) + offset;
+    size -= offset;
+
+    // a region bigger than the last size class is inserted as multiple regions
+    auto max_size = 4u * max_block_size() - granularity;
+    while (size >= 2u * header_size + min_block_size)
+    {
+        auto usable = (size - 2u * header_size) / granularity * granularity;
+        if (usable > max_size)
+            usable = max_size;
+
+        auto block = ::new(static_cast<void*>(memory)) tlsf_block;
+        block->prev_phys = nullptr;
+        block->size = usable;
+
+        auto sentinel = ::new(static_cast<void*>(next_phys(block))) tlsf_block;
+        sentinel->size = 0u;
+        set_free(block, true);
+        insert_free(block);
+
+        memory += 2u * header_size + usable;
+        size -= 2u * header_size + usable;
+    }
+}
+
+void* tlsf_free_memory_list::allocate(std::size_t size, std::size_t alignment) FOONATHAN_NOEXCEPT
+{
+    if (size > max_block_size() || alignment > max_block_size())
+        return nullptr;
+    size = size < min_block_size ? min_block_size : round_up(size, granularity);
+
+    // an over-aligned allocation needs room to split off a free block in front of it
+    auto over_aligned = alignment > granularity;
+    auto block = find_free(over_aligned ? size + alignment + min_split_size : size);
+    if (!block)
+        return nullptr;
+
+    if (over_aligned)
+    {
+        auto gap = align_offset(memory_of(block), alignment);
+        if (gap != 0u && gap < min_split_size)
+            gap = min_split_size + align_offset(memory_of(block) + min_split_size, alignment);
+        if (gap != 0u)
+        {
+            auto aligned = ::new(static_cast<void*>(reinterpret_cast<char*>(block) + gap)) tlsf_block;
+            aligned->size = block_size(block) - gap;
+            set_block_size(block, gap - header_size);
+            set_free(block, true);
+            insert_free(block);
+            block = aligned;
+        }
+    }
+
+    trim(block, size);
+    set_free(block, false);
+
+    auto memory = memory_of(block);
+    FOONATHAN_MEMORY_ASSERT(is_aligned(memory, alignment));
+    detail::debug_fill(memory, block_size(block), debug_magic::new_memory);
+    return memory;
+}
+
+void tlsf_free_memory_list::deallocate(void *ptr) FOONATHAN_NOEXCEPT
+{
+    auto info = allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::tlsf_free_memory_list", this);
+
+    auto block = block_of(ptr);
+    // double-free
+    check_pointer(!is_free(block), info, ptr);
+    detail::debug_fill(ptr, block_size(block), debug_magic::freed_memory);
+
+    // coalesce with the neighbours, they are never both free with the one in between
+    if (is_prev_free(block))
+    {
+        auto prev = block->prev_phys;
+        erase_free(prev);
+        set_block_size(prev, block_size(prev) + header_size + block_size(block));
+        block = prev;
+    }
+    auto next = next_phys(block);
+    if (is_free(next))
+    {
+        erase_free(next);
+        set_block_size(block, block_size(block) + header_size + block_size(next));
+    }
+
+    set_free(block, true);
+    insert_free(block);
+}
+
+std::size_t tlsf_free_memory_list::max_block_size() const FOONATHAN_NOEXCEPT
+{
+    // the search rounds up to the next size class and over-aligned allocations need twice the size,
+    // so use a quarter of the last first level
+    return std::size_t(1) << (fl_shift + fl_count - 3u);
+}
+
+void tlsf_free_memory_list::insert_free(tlsf_block *block) FOONATHAN_NOEXCEPT
+{
+    std::size_t fl, sl;
+    mapping_insert(block_size(block), fl, sl);
+    FOONATHAN_MEMORY_ASSERT(fl < fl_count);
+
+    auto &head = free_[fl][sl];
+    links(block).next = head;
+    links(block).prev = nullptr;
+    if (head)
+        links(head).prev = block;
+    head = block;
+
+    fl_bitmap_ |= std::uint32_t(1u) << fl;
+    sl_bitmap_[fl] |= std::uint32_t(1u) << sl;
+    capacity_ += block_size(block);
+}
+
+void tlsf_free_memory_list::erase_free(tlsf_block *block) FOONATHAN_NOEXCEPT
+{
+    std::size_t fl, sl;
+    mapping_insert(block_size(block), fl, sl);
+
+    auto &l = links(block);
+    if (l.prev)
+        links(l.prev).next = l.next;
+    else
+        free_[fl][sl] = l.next;
+    if (l.next)
+        links(l.next).prev = l.prev;
+
+    if (!free_[fl][sl])
+    {
+        sl_bitmap_[fl] &= ~(std::uint32_t(1u) << sl);
+        if (sl_bitmap_[fl] == 0u)
+            fl_bitmap_ &= ~(std::uint32_t(1u) << fl);
+    }
+    capacity_ -= block_size(block);
+}
+
+tlsf_block* tlsf_free_memory_list::find_free(std::size_t size) FOONATHAN_NOEXCEPT
+{
+    std::size_t fl, sl;
+    mapping_search(size, fl, sl);
+    if (fl >= fl_count)
+        return nullptr;
+
+    // first non-empty list in this first level, otherwise in the next non-empty one
+    auto sl_map = sl_bitmap_[fl] & mask_from(sl);
+    if (sl_map == 0u)
+    {
+        auto fl_map = fl_bitmap_ & mask_from(fl + 1u);
+        if (fl_map == 0u)
+            return nullptr;
+        fl = find_first_set(fl_map);
+        sl_map = sl_bitmap_[fl];
+    }
+    sl = find_first_set(sl_map);
+
+    auto block = free_[fl][sl];
+    FOONATHAN_MEMORY_ASSERT(block && block_size(block) >= size);
+    erase_free(block);
+    return block;
+}
+
+void tlsf_free_memory_list::trim(tlsf_block *block, std::size_t size) FOONATHAN_NOEXCEPT
+{
+    if (block_size(block) < size + min_split_size)
+        return;
+
+    // the next block is used, since free blocks are always coalesced
+    auto rest = ::new(static_cast<void*>(memory_of(block) + size)) tlsf_block;
+    rest->size = block_size(block) - size - header_size;
+    set_block_size(block, size);
+    set_free(rest, true);
+    insert_free(rest);
+}
@@ -16,7 +16,8 @@ using namespace foonathan::memory;
 
     namespace
     {
-        std::size_t init_counter = 0u, alloc_counter = 0u;
+        // constant initialized, so they are ready before any other static initializer runs
+        std::atomic<std::size_t> init_counter(0u), alloc_counter(0u);
 
         void on_alloc(std::size_t size) FOONATHAN_NOEXCEPT
         {
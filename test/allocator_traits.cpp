@@ -6,6 +6,7 @@
 
 #include <catch.hpp>
 
+#include <new>
 #include <type_traits>
 #include <memory/allocator_traits.hpp>
 
@@ -226,6 +227,66 @@ TEST_CASE("allocator_traits", "[core]")
         REQUIRE(!array4.alloc);
         REQUIRE(!array4.dealloc);
     }
+    SECTION("bulk")
+    {
+        struct counting_raw
+        {
+            std::size_t no_allocated = 0u, no_deallocated = 0u, fail_at = std::size_t(-1);
+            char memory[8];
+
+            void* allocate_node(std::size_t, std::size_t)
+            {
+                if (no_allocated == fail_at)
+                    throw std::bad_alloc();
+                return &memory[no_allocated++];
+            }
+
+            void deallocate_node(void*, std::size_t, std::size_t) FOONATHAN_NOEXCEPT
+            {
+                ++no_deallocated;
+            }
+        };
+
+        // fallback calls node functions
+        counting_raw counting;
+        void* ptrs[8];
+        allocator_traits<counting_raw>::allocate_node_bulk(counting, 8, 1, 1, ptrs);
+        REQUIRE(counting.no_allocated == 8u);
+        REQUIRE(ptrs[7] == &counting.memory[7]);
+        allocator_traits<counting_raw>::deallocate_node_bulk(counting, 8, 1, 1, ptrs);
+        REQUIRE(counting.no_deallocated == 8u);
+
+        // fallback deallocates on failure
+        counting_raw failing;
+        failing.fail_at = 3u;
+        REQUIRE_THROWS_AS(allocator_traits<counting_raw>::allocate_node_bulk(failing, 8, 1, 1, ptrs),
+                          std::bad_alloc);
+        REQUIRE(failing.no_deallocated == 3u);
+
+        struct bulk_raw : min_raw_allocator
+        {
+            bool alloc_bulk = false, dealloc_bulk = false;
+
+            void allocate_node_bulk(std::size_t, std::size_t, std::size_t, void**)
+            {
+                alloc_bulk = true;
+            }
+
+            void deallocate_node_bulk(std::size_t, std::size_t, std::size_t, void *const *) FOONATHAN_NOEXCEPT
+            {
+                dealloc_bulk = true;
+            }
+        };
+
+        // bulk is preferred over node
+        bulk_raw bulk;
+        allocator_traits<bulk_raw>::allocate_node_bulk(bulk, 8, 1, 1, ptrs);
+        allocator_traits<bulk_raw>::deallocate_node_bulk(bulk, 8, 1, 1, ptrs);
+        REQUIRE(bulk.alloc_bulk);
+        REQUIRE(bulk.dealloc_bulk);
+        REQUIRE(!bulk.alloc_node);
+        REQUIRE(!bulk.dealloc_node);
+    }
     SECTION("max getter")
     {
         min_raw_allocator min;
@@ -269,4 +330,20 @@ TEST_CASE("allocator_traits", "[core]")
         with_everything everything;
         test_max_getter(everything, detail::max_alignment * 2, 1, 2);
     }
+    SECTION("owns")
+    {
+        struct owning_raw : min_raw_allocator
+        {
+            char buffer[16];
+
+            bool owns(const void *ptr) const FOONATHAN_NOEXCEPT
+            {
+                return buffer <= ptr && ptr < buffer + 16;
+            }
+        };
+
+        owning_raw owning;
+        REQUIRE(allocator_traits<owning_raw>::owns(owning, owning.buffer + 4));
+        REQUIRE(!allocator_traits<owning_raw>::owns(owning, &owning + 1));
+    }
 }
@@ -0,0 +1,115 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "buddy_allocator.hpp"
+
+#include <algorithm>
+#include <catch.hpp>
+#include <random>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "std_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("buddy_allocator", "[buddy]")
+{
+    using allocator_type = buddy_allocator<allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        allocator_type buddy(64, 4096, 4 * 8192, alloc);
+        REQUIRE(buddy.min_block_size() == 64u);
+        REQUIRE(buddy.max_block_size() == 4096u);
+        REQUIRE(buddy.capacity() > 0u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        auto capacity = buddy.capacity();
+
+        SECTION("split and merge")
+        {
+            auto a = buddy.allocate_node(1, 1);
+            auto b = buddy.allocate_node(64, 1);
+            REQUIRE(a != b);
+            REQUIRE(buddy.capacity() == capacity - 128u);
+
+            buddy.deallocate_node(a, 1, 1);
+            buddy.deallocate_node(b, 64, 1);
+            REQUIRE(buddy.capacity() == capacity);
+
+            auto c = buddy.allocate_node(buddy.max_block_size(), 1);
+            REQUIRE(detail::is_aligned(c, buddy.max_block_size()));
+            REQUIRE(alloc.no_allocated() == 1u);
+            buddy.deallocate_node(c, buddy.max_block_size(), 1);
+        }
+        SECTION("alignment")
+        {
+            auto a = buddy.allocate_node(10, 1);
+            auto b = buddy.allocate_node(10, 256);
+            REQUIRE(detail::is_aligned(b, 256));
+            auto c = buddy.allocate_array(3, 100, 512);
+            REQUIRE(detail::is_aligned(c, 512));
+
+            buddy.deallocate_node(b, 10, 256);
+            buddy.deallocate_array(c, 3, 100, 512);
+            buddy.deallocate_node(a, 10, 1);
+            REQUIRE(buddy.capacity() == capacity);
+        }
+        SECTION("random sizes")
+        {
+            std::mt19937 rng;
+            std::uniform_int_distribution<std::size_t> dist(1u, buddy.max_block_size());
+
+            struct allocation
+            {
+                char *memory;
+                std::size_t size;
+            };
+            std::vector<allocation> allocations;
+            for (auto i = 0u; i != 100u; ++i)
+            {
+                auto size = dist(rng);
+                auto mem = static_cast<char*>(buddy.allocate_node(size, 1));
+                REQUIRE(buddy.owns(mem));
+                allocations.push_back({mem, size});
+            }
+
+            std::sort(allocations.begin(), allocations.end(),
+                      [](const allocation &a, const allocation &b) {return a.memory < b.memory;});
+            for (auto i = 1u; i < allocations.size(); ++i)
+                REQUIRE(allocations[i - 1].memory + allocations[i - 1].size <= allocations[i].memory);
+
+            std::shuffle(allocations.begin(), allocations.end(), rng);
+            for (auto &a : allocations)
+                buddy.deallocate_node(a.memory, a.size, 1);
+            REQUIRE(buddy.capacity() >= capacity);
+        }
+        SECTION("std_allocator")
+        {
+            std::vector<int, std_allocator<int, allocator_type>> vec(buddy);
+            for (auto i = 0; i != 100; ++i)
+                vec.push_back(i);
+            REQUIRE(vec.size() == 100u);
+            REQUIRE(buddy.owns(vec.data()));
+            vec.clear();
+            vec.shrink_to_fit();
+            REQUIRE(buddy.capacity() == capacity);
+        }
+        SECTION("move")
+        {
+            auto ptr = buddy.allocate_node(100, 1);
+            auto buddy2 = detail::move(buddy);
+            REQUIRE(buddy2.capacity() == capacity - 128u);
+            buddy2.deallocate_node(ptr, 100, 1);
+            REQUIRE(buddy2.capacity() == capacity);
+        }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        SECTION("too big")
+        {
+            REQUIRE_THROWS_AS(buddy.allocate_node(buddy.max_block_size() + 1u, 1), bad_allocation_size);
+        }
+#endif
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
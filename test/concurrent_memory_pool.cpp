@@ -0,0 +1,103 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "concurrent_memory_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("concurrent_memory_pool", "[pool]")
+{
+    using pool_type = concurrent_memory_pool<allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(4, 1000, alloc);
+        REQUIRE(pool.node_size() >= 4u);
+        REQUIRE(pool.next_capacity() >= 1000u);
+        REQUIRE(&pool.get_allocator().get_allocator() == &alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        SECTION("normal alloc/dealloc")
+        {
+            std::vector<void*> ptrs;
+            for (std::size_t i = 0u; i != 10u; ++i)
+                ptrs.push_back(pool.allocate_node());
+            REQUIRE(alloc.no_allocated() == 1u);
+
+            std::sort(ptrs.begin(), ptrs.end());
+            REQUIRE(std::adjacent_find(ptrs.begin(), ptrs.end()) == ptrs.end());
+
+            std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+
+            // nodes are reused
+            for (std::size_t i = 0u; i != 10u; ++i)
+                ptrs[i] = pool.allocate_node();
+            REQUIRE(alloc.no_allocated() == 1u);
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+        }
+        SECTION("multiple block alloc/dealloc")
+        {
+            std::vector<void*> ptrs;
+            for (std::size_t i = 0u; i != 1000u; ++i)
+                ptrs.push_back(pool.allocate_node());
+            REQUIRE(alloc.no_allocated() > 1u);
+
+            std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+            auto no_allocated = alloc.no_allocated();
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+            REQUIRE(alloc.no_allocated() == no_allocated);
+        }
+        SECTION("multithreaded alloc/dealloc")
+        {
+            const auto no_threads = 4u, no_nodes = 1000u;
+            std::atomic<bool> start(false);
+            std::vector<std::size_t> errors(no_threads, 0u);
+            std::vector<std::thread> threads;
+            for (auto t = 0u; t != no_threads; ++t)
+                threads.emplace_back([&, t]
+                {
+                    while (!start)
+                        std::this_thread::yield();
+
+                    std::vector<std::size_t*> ptrs;
+                    for (auto round = 0u; round != 10u; ++round)
+                    {
+                        for (auto i = 0u; i != no_nodes; ++i)
+                        {
+                            auto ptr = static_cast<std::size_t*>(pool.allocate_node());
+                            *ptr = t;
+                            ptrs.push_back(ptr);
+                        }
+                        // nobody else must have been given the same nodes
+                        for (auto ptr : ptrs)
+                            if (*ptr != t)
+                                ++errors[t];
+                        for (auto ptr : ptrs)
+                            pool.deallocate_node(ptr);
+                        ptrs.clear();
+                    }
+                });
+            start = true;
+            for (auto &thread : threads)
+                thread.join();
+
+            for (auto e : errors)
+                REQUIRE(e == 0u);
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
@@ -0,0 +1,139 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "concurrent_memory_stack.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("concurrent_memory_stack", "[stack]")
+{
+    test_allocator alloc;
+    concurrent_memory_stack<allocator_reference<test_allocator>> stack(1000, alloc);
+    REQUIRE(alloc.no_allocated() == 1u);
+    REQUIRE(stack.capacity() <= 1000u);
+    auto capacity = stack.capacity();
+
+    SECTION("empty unwind")
+    {
+        auto m = stack.top();
+        stack.unwind(m);
+        REQUIRE(stack.capacity() == capacity);
+        REQUIRE(alloc.no_allocated() == 1u);
+    }
+    SECTION("normal allocation/unwind")
+    {
+        stack.allocate(10, 1);
+        REQUIRE(stack.capacity() < capacity);
+        auto after_first = stack.capacity();
+
+        auto m = stack.top();
+
+        auto memory = stack.allocate(10, 16);
+        REQUIRE(detail::align_offset(memory, 16) == 0u);
+        auto over_aligned = stack.allocate(10, 64);
+        REQUIRE(detail::align_offset(over_aligned, 64) == 0u);
+
+        stack.unwind(m);
+        REQUIRE(stack.capacity() == after_first);
+
+        REQUIRE(stack.allocate(10, 16) == memory);
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(alloc.no_deallocated() == 0u);
+    }
+    SECTION("multiple block allocation/unwind")
+    {
+        stack.allocate(10, 1);
+        auto m = stack.top();
+
+        auto old_next = stack.next_capacity();
+        stack.allocate(capacity, 1);
+        REQUIRE(stack.next_capacity() > old_next);
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        auto m2 = stack.top();
+        stack.allocate(10, 1);
+        stack.unwind(m2);
+        stack.allocate(20, 1);
+
+        stack.unwind(m);
+        REQUIRE(alloc.no_allocated() == 2u);
+        REQUIRE(alloc.no_deallocated() == 0u);
+
+        stack.allocate(10, 1);
+
+        stack.shrink_to_fit();
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(alloc.no_deallocated() == 1u);
+    }
+    SECTION("allocation after unwind")
+    {
+        auto m = stack.top();
+        // each allocation only fits into a new block
+        auto second = stack.next_capacity() - 100u;
+        stack.allocate(second, 1);
+        auto third = stack.next_capacity() - 100u;
+        stack.allocate(third, 1);
+        REQUIRE(alloc.no_allocated() == 3u);
+
+        // the second block is cached on top of the third one
+        stack.unwind(m);
+        REQUIRE(alloc.no_allocated() == 3u);
+
+        // only fits into the third block, the second one stays cached
+        stack.allocate(third, 1);
+        REQUIRE(alloc.no_allocated() == 3u);
+        stack.allocate(second, 1);
+        REQUIRE(alloc.no_allocated() == 3u);
+
+        stack.unwind(m);
+    }
+    SECTION("multithreaded allocation")
+    {
+        const auto no_threads = 4u, no_allocations = 1000u;
+        auto m = stack.top();
+
+        std::atomic<bool> start(false);
+        std::vector<std::vector<char*>> allocated(no_threads);
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t != no_threads; ++t)
+            threads.emplace_back([&, t]
+            {
+                while (!start)
+                    std::this_thread::yield();
+                for (auto i = 0u; i != no_allocations; ++i)
+                {
+                    auto ptr = static_cast<char*>(stack.allocate(16, 8));
+                    std::fill(ptr, ptr + 16, char(t));
+                    allocated[t].push_back(ptr);
+                }
+            });
+        start = true;
+        for (auto &thread : threads)
+            thread.join();
+
+        // no allocations overlap
+        std::vector<char*> all;
+        for (auto t = 0u; t != no_threads; ++t)
+        {
+            for (auto ptr : allocated[t])
+                REQUIRE(std::count(ptr, ptr + 16, char(t)) == 16);
+            all.insert(all.end(), allocated[t].begin(), allocated[t].end());
+        }
+        std::sort(all.begin(), all.end());
+        for (auto i = 1u; i < all.size(); ++i)
+            REQUIRE(all[i] - all[i - 1] >= 16);
+
+        stack.unwind(m);
+        REQUIRE(stack.capacity() == capacity);
+    }
+}
@@ -0,0 +1,129 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "destructor_stack.hpp"
+
+#include <catch.hpp>
+#include <string>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // records the order of destruction
+    struct tracked
+    {
+        std::vector<int> &destroyed;
+        int id;
+
+        tracked(std::vector<int> &d, int i)
+        : destroyed(d), id(i) {}
+
+        ~tracked()
+        {
+            destroyed.push_back(id);
+        }
+    };
+}
+
+TEST_CASE("destructor_stack", "[stack]")
+{
+    test_allocator alloc;
+    std::vector<int> destroyed;
+    {
+        destructor_stack<allocator_reference<test_allocator>> stack(1024, alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        SECTION("unwind")
+        {
+            auto a = stack.create<tracked>(destroyed, 0);
+            REQUIRE(a->id == 0);
+            auto m = stack.top();
+            auto capacity = stack.capacity();
+
+            auto b = stack.create<tracked>(destroyed, 1);
+            auto c = stack.create<tracked>(destroyed, 2);
+            REQUIRE(b->id == 1);
+            REQUIRE(c->id == 2);
+            REQUIRE(stack.capacity() < capacity);
+
+            stack.unwind(m);
+            REQUIRE(destroyed == (std::vector<int>{2, 1}));
+            REQUIRE(stack.capacity() == capacity);
+        }
+        SECTION("mixed")
+        {
+            auto m = stack.top();
+            auto i = stack.create<int>(42);
+            auto s = stack.create<std::string>(100u, 'a');
+            auto d = stack.create<double>(3.14);
+            auto v = stack.create<std::vector<int>>(50u, 1);
+            REQUIRE(*i == 42);
+            REQUIRE(s->size() == 100u);
+            REQUIRE(*d == 3.14);
+            REQUIRE(v->size() == 50u);
+            REQUIRE(detail::is_aligned(d, FOONATHAN_ALIGNOF(double)));
+            REQUIRE(detail::is_aligned(v, FOONATHAN_ALIGNOF(std::vector<int>)));
+            // runs the destructors, the test allocator or sanitizers would catch leaks
+            stack.unwind(m);
+        }
+        SECTION("growth")
+        {
+            auto m = stack.top();
+            for (auto i = 0; i != 100; ++i)
+                stack.create<tracked>(destroyed, i);
+            REQUIRE(alloc.no_allocated() > 1u);
+
+            stack.unwind(m);
+            REQUIRE(destroyed.size() == 100u);
+            REQUIRE(destroyed.front() == 99);
+            REQUIRE(destroyed.back() == 0);
+        }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        SECTION("throwing constructor")
+        {
+            struct throwing
+            {
+                throwing()
+                {
+                    throw 0;
+                }
+
+                ~throwing() {}
+            };
+
+            auto m = stack.top();
+            stack.create<tracked>(destroyed, 0);
+            REQUIRE_THROWS(stack.create<throwing>());
+            stack.unwind(m);
+            REQUIRE(destroyed == (std::vector<int>{0}));
+        }
+#endif
+        SECTION("move")
+        {
+            stack.create<tracked>(destroyed, 0);
+            {
+                auto stack2 = detail::move(stack);
+                REQUIRE(destroyed.empty());
+            }
+            REQUIRE(destroyed == (std::vector<int>{0}));
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("destructor_stack destructor", "[stack]")
+{
+    std::vector<int> destroyed;
+    {
+        destructor_stack<> stack(1024);
+        stack.create<tracked>(destroyed, 0);
+        stack.create<tracked>(destroyed, 1);
+    }
+    REQUIRE(destroyed == (std::vector<int>{1, 0}));
+}
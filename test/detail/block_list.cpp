@@ -58,6 +58,14 @@ TEST_CASE("detail::block_list_impl", "[detail][core]")
     mem = c;
     list.push(mem, 1024);
 
+    SECTION("owns")
+    {
+        REQUIRE(list.owns(a + block_list_impl::impl_offset()));
+        REQUIRE(list.owns(b + 1023));
+        REQUIRE(list.owns(c + 512));
+        REQUIRE(!list.owns(a));
+        REQUIRE(!list.owns(c + 1024));
+    }
     SECTION("multiple pop")
     {
         auto block = list.pop();
@@ -0,0 +1,41 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "detail/block_map.hpp"
+
+#include <catch.hpp>
+
+using namespace foonathan::memory;
+using namespace detail;
+
+TEST_CASE("detail::block_map", "[detail][core]")
+{
+    char memory[1024];
+    block_map::entry entries[4];
+    block_map map(entries, 4u);
+    REQUIRE(map.find(memory) == block_map::no_owner);
+
+    // not inserted in address order
+    map.insert(memory + 512, 256, 2u);
+    map.insert(memory, 128, 0u);
+    map.insert(memory + 256, 256, 1u);
+
+    REQUIRE(map.find(memory) == 0u);
+    REQUIRE(map.find(memory + 127) == 0u);
+    REQUIRE(map.find(memory + 128) == block_map::no_owner);
+    REQUIRE(map.find(memory + 256) == 1u);
+    REQUIRE(map.find(memory + 511) == 1u);
+    REQUIRE(map.find(memory + 512) == 2u);
+    REQUIRE(map.find(memory + 767) == 2u);
+    REQUIRE(map.find(memory + 768) == block_map::no_owner);
+
+    map.erase(memory + 256);
+    REQUIRE(map.find(memory + 300) == block_map::no_owner);
+    REQUIRE(map.find(memory + 100) == 0u);
+    REQUIRE(map.find(memory + 600) == 2u);
+
+    map.erase(memory);
+    map.erase(memory + 512);
+    REQUIRE(map.find(memory + 600) == block_map::no_owner);
+}
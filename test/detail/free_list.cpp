@@ -3,6 +3,9 @@
 // found in the top-level directory of this distribution.
 
 #include "detail/free_list.hpp"
+#include "detail/bitmap_free_list.hpp"
+#include "detail/buddy_list.hpp"
+#include "detail/indexed_free_list.hpp"
 #include "detail/small_free_list.hpp"
 
 #include <algorithm>
@@ -127,7 +130,8 @@ TEST_CASE("free_memory_list", "[detail][pool]")
     check_move(list);
 }
 
-void use_list_array(ordered_free_memory_list &list)
+template <class FreeList>
+void use_list_array(FreeList &list)
 {
     // just hoping to catch segfaults
 
@@ -190,34 +194,262 @@ TEST_CASE("ordered_free_memory_list", "[detail][pool]")
     check_move(list);
 }
 
+TEST_CASE("indexed_free_memory_list", "[detail][pool]")
+{
+    indexed_free_memory_list list(4);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() >= 4);
+    REQUIRE(list.capacity() == 0u);
+
+    // runs are merged with their neighbours, so the memory must outlive the sections
+    alignas(max_alignment) char a[1024], b[100], c[1337];
+    SECTION("normal insert")
+    {
+        check_list(list, a, 1024);
+        use_list_array(list);
+    }
+    SECTION("uneven insert")
+    {
+        check_list(list, a, 1023); // not dividable
+        use_list_array(list);
+    }
+    SECTION("multiple insert")
+    {
+        check_list(list, a, 1024);
+        use_list_array(list);
+        check_list(list, b, 100);
+        check_list(list, c, 1337);
+        use_list_array(list);
+    }
+    SECTION("merging")
+    {
+        list.insert(a, 1024);
+        auto capacity = list.capacity();
+
+        std::vector<void*> nodes;
+        while (!list.empty())
+            nodes.push_back(list.allocate());
+        REQUIRE(!list.allocate(2 * list.node_size()));
+
+        // free every other node, no array fits
+        for (std::size_t i = 0u; i < nodes.size(); i += 2)
+            list.deallocate(nodes[i]);
+        REQUIRE(!list.allocate(2 * list.node_size()));
+
+        // free the rest, everything is one run again
+        for (std::size_t i = 1u; i < nodes.size(); i += 2)
+            list.deallocate(nodes[i]);
+        REQUIRE(list.capacity() == capacity);
+
+        auto array = list.allocate(capacity * list.node_size());
+        REQUIRE(array);
+        list.deallocate(array, capacity * list.node_size());
+        REQUIRE(list.capacity() == capacity);
+    }
+    check_move(list);
+}
+
 TEST_CASE("small_free_memory_list", "[detail][pool]")
 {
+    // chunks are reused after the sections, so the memory must outlive the list
+    alignas(max_alignment) char memory[4096], a[1024], b[100], c[1337];
+    std::vector<char> huge(65536 + max_alignment);
+
     small_free_memory_list list(4);
     REQUIRE(list.empty());
     REQUIRE(list.node_size() == 4);
     REQUIRE(list.capacity() == 0u);
 
+    SECTION("normal insert")
+    {
+        check_list(list, memory, 1024);
+    }
+    SECTION("uneven insert")
+    {
+        check_list(list, memory, 1023); // not dividable
+    }
+    SECTION("big insert")
+    {
+        check_list(list, memory, 4096); // should use multiple chunks
+    }
+    SECTION("huge insert")
+    {
+        // many chunks on the grid, nodes are deallocated in random order
+        auto offset = align_offset(huge.data(), max_alignment);
+        check_list(list, huge.data() + offset, huge.size() - offset);
+    }
+    SECTION("narrow index")
+    {
+        // nodes too big for the 16 bit indices of small nodes
+        small_free_memory_list narrow(16);
+        auto offset = align_offset(huge.data(), max_alignment);
+        check_list(narrow, huge.data() + offset, huge.size() - offset);
+    }
+    SECTION("reuse")
+    {
+        // full, partial and empty chunks must all be found again
+        auto offset = align_offset(huge.data(), max_alignment);
+        list.insert(huge.data() + offset, huge.size() - offset);
+        auto capacity = list.capacity();
+
+        std::vector<void*> ptrs;
+        while (!list.empty())
+            ptrs.push_back(list.allocate());
+        std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+
+        auto half = ptrs.size() / 2;
+        for (auto i = half; i != ptrs.size(); ++i)
+            list.deallocate(ptrs[i]);
+        REQUIRE(list.capacity() == ptrs.size() - half);
+
+        for (auto i = half; i != ptrs.size(); ++i)
+            ptrs[i] = list.allocate();
+        REQUIRE(list.empty());
+
+        for (auto ptr : ptrs)
+            list.deallocate(ptr);
+        REQUIRE(list.capacity() == capacity);
+        use_list_node(list);
+    }
+    SECTION("multiple insert")
+    {
+        check_list(list, a, 1024);
+        check_list(list, b, 100);
+        check_list(list, c, 1337);
+    }
+    SECTION("adjacent insert")
+    {
+        // memory inserted piece by piece gives the same nodes as inserting it at once
+        const std::size_t piece = 272u;
+        auto offset = align_offset(huge.data(), max_alignment);
+        auto begin = huge.data() + offset;
+        auto size = (huge.size() - offset) / piece * piece;
+
+        std::size_t capacity;
+        {
+            // only calculates the capacity, doesn't touch the memory
+            small_free_memory_list whole(4);
+            whole.insert(begin, size);
+            capacity = whole.capacity();
+        }
+
+        // allocate everything in between, so the previous memory is carved already
+        std::vector<void*> ptrs;
+        for (auto cur = begin; cur != begin + size; cur += piece)
+        {
+            list.insert(cur, piece);
+            while (!list.empty())
+                ptrs.push_back(list.allocate());
+        }
+        REQUIRE(ptrs.size() == capacity);
+
+        std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+        for (auto ptr : ptrs)
+            list.deallocate(ptr);
+        REQUIRE(list.capacity() == capacity);
+        use_list_node(list);
+    }
+    check_move(list);
+}
+
+TEST_CASE("bitmap_free_memory_list", "[detail][pool]")
+{
+    bitmap_free_memory_list list(4);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() == 4);
+    REQUIRE(list.capacity() == 0u);
+
     SECTION("normal insert")
     {
         alignas(max_alignment) char memory[1024];
         check_list(list, memory, 1024);
+        use_list_array(list);
     }
     SECTION("uneven insert")
     {
         alignas(max_alignment) char memory[1023]; // not dividable
         check_list(list, memory, 1023);
+        use_list_array(list);
     }
     SECTION("big insert")
     {
-        alignas(max_alignment) char memory[4096]; // should use multiple chunks
+        alignas(max_alignment) char memory[4096]; // bitmap needs multiple words
         check_list(list, memory, 4096);
+        use_list_array(list);
     }
     SECTION("multiple insert")
     {
         alignas(max_alignment) char a[1024], b[100], c[1337];
         check_list(list, a, 1024);
+        use_list_array(list);
         check_list(list, b, 100);
         check_list(list, c, 1337);
+        use_list_array(list);
     }
     check_move(list);
 }
+
+TEST_CASE("buddy_free_memory_list", "[detail][buddy]")
+{
+    buddy_free_memory_list list(16, 1024);
+    REQUIRE(list.empty());
+    REQUIRE(list.min_block_size() == 16u);
+    REQUIRE(list.max_block_size() == 1024u);
+    REQUIRE(list.tree_size() == 2048u);
+
+    std::vector<char> memory(2 * list.tree_size());
+    auto offset = align_offset(memory.data(), list.tree_size());
+    list.insert_tree(memory.data() + offset);
+    REQUIRE(!list.empty());
+    auto capacity = list.capacity();
+    // the order table takes one byte for each minimum block
+    REQUIRE(capacity == list.tree_size() - list.tree_size() / list.min_block_size());
+
+    SECTION("split and merge")
+    {
+        std::vector<void*> ptrs;
+        while (auto ptr = list.allocate(1, 1))
+        {
+            REQUIRE(is_aligned(ptr, list.min_block_size()));
+            ptrs.push_back(ptr);
+        }
+        REQUIRE(list.empty());
+        REQUIRE(ptrs.size() == capacity / list.min_block_size());
+
+        std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+        for (auto ptr : ptrs)
+            list.deallocate(ptr, 1, 1);
+        REQUIRE(list.capacity() == capacity);
+
+        // the upper half of the tree is a single block again
+        auto ptr = list.allocate(list.max_block_size(), 1);
+        REQUIRE(ptr == memory.data() + offset + list.max_block_size());
+        REQUIRE(!list.allocate(list.max_block_size(), 1));
+        list.deallocate(ptr, list.max_block_size(), 1);
+    }
+    SECTION("sizes")
+    {
+        auto a = list.allocate(17, 1);
+        REQUIRE(list.capacity() == capacity - 32u);
+        auto b = list.allocate(1, 256);
+        REQUIRE(is_aligned(b, 256u));
+        REQUIRE(list.capacity() == capacity - 32u - 256u);
+        REQUIRE(!list.allocate(2048, 1));
+
+        list.deallocate(b, 1, 256);
+        list.deallocate(a, 17, 1);
+        REQUIRE(list.capacity() == capacity);
+    }
+    SECTION("move")
+    {
+        auto ptr = list.allocate(100, 1);
+        auto list2 = detail::move(list);
+        REQUIRE(list.empty());
+        REQUIRE(list2.capacity() == capacity - 128u);
+        list2.deallocate(ptr, 100, 1);
+        REQUIRE(list2.capacity() == capacity);
+
+        list = detail::move(list2);
+        REQUIRE(list.capacity() == capacity);
+    }
+}
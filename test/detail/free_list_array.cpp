@@ -30,6 +30,65 @@ TEST_CASE("detail::log2_access_policy", "[detail][pool]")
     REQUIRE(ap::size_from_index(3) == 8u);
 }
 
+TEST_CASE("detail::size_class_access_policy", "[detail][pool]")
+{
+    using ap = detail::size_class_access_policy;
+    REQUIRE(ap::index_from_size(1) == 1u);
+    REQUIRE(ap::index_from_size(8) == 8u);
+    REQUIRE(ap::index_from_size(9) == 9u);
+    REQUIRE(ap::index_from_size(10) == 9u);
+    REQUIRE(ap::index_from_size(11) == 10u);
+    REQUIRE(ap::index_from_size(16) == 12u);
+    REQUIRE(ap::index_from_size(17) == 13u);
+    REQUIRE(ap::index_from_size(33) == 17u);
+    REQUIRE(ap::index_from_size(40) == 17u);
+    REQUIRE(ap::index_from_size(41) == 18u);
+
+    REQUIRE(ap::size_from_index(1) == 1u);
+    REQUIRE(ap::size_from_index(8) == 8u);
+    REQUIRE(ap::size_from_index(9) == 10u);
+    REQUIRE(ap::size_from_index(12) == 16u);
+    REQUIRE(ap::size_from_index(13) == 20u);
+    REQUIRE(ap::size_from_index(17) == 40u);
+
+    for (std::size_t size = 1u; size != 4096u; ++size)
+    {
+        auto index = ap::index_from_size(size);
+        auto class_size = ap::size_from_index(index);
+        REQUIRE(class_size >= size);
+        REQUIRE((class_size - size) * 4u < class_size);
+        REQUIRE(ap::index_from_size(class_size) == index);
+        REQUIRE(ap::size_from_index(index - 1u) < size);
+    }
+}
+
+TEST_CASE("detail::static_access_policy", "[detail][pool]")
+{
+    using ap = detail::static_access_policy<8, 16, 24, 48, 96>;
+    REQUIRE(ap::index_from_size(1) == 0u);
+    REQUIRE(ap::index_from_size(8) == 0u);
+    REQUIRE(ap::index_from_size(9) == 1u);
+    REQUIRE(ap::index_from_size(16) == 1u);
+    REQUIRE(ap::index_from_size(17) == 2u);
+    REQUIRE(ap::index_from_size(24) == 2u);
+    REQUIRE(ap::index_from_size(25) == 3u);
+    REQUIRE(ap::index_from_size(48) == 3u);
+    REQUIRE(ap::index_from_size(49) == 4u);
+    REQUIRE(ap::index_from_size(96) == 4u);
+
+    REQUIRE(ap::size_from_index(0) == 8u);
+    REQUIRE(ap::size_from_index(2) == 24u);
+    REQUIRE(ap::size_from_index(4) == 96u);
+
+    using odd = detail::static_access_policy<3, 5, 12>;
+    for (std::size_t size = 1u; size <= 12u; ++size)
+    {
+        auto index = odd::index_from_size(size);
+        REQUIRE(odd::size_from_index(index) >= size);
+        REQUIRE((index == 0u || odd::size_from_index(index - 1u) < size));
+    }
+}
+
 TEST_CASE("detail::free_list_array", "[detail][pool]")
 {
     alignas(max_alignment) char memory[1024];
@@ -79,4 +138,31 @@ TEST_CASE("detail::free_list_array", "[detail][pool]")
         REQUIRE(arr.get(9u).node_size() == 16u);
         REQUIRE(arr.get(15u).node_size() == 16u);
     }
+    SECTION("size classes, normal list")
+    {
+        using array = detail::free_list_array<detail::free_memory_list,
+                                        detail::size_class_access_policy>;
+        array arr(stack, 33);
+        REQUIRE(arr.max_node_size() == 40u);
+        REQUIRE(arr.size() <= 17u);
+
+        REQUIRE(arr.get(1u).node_size() == detail::free_memory_list::min_element_size);
+        REQUIRE(arr.get(17u).node_size() == 20u);
+        REQUIRE(arr.get(25u).node_size() == 28u);
+        REQUIRE(arr.get(33u).node_size() == 40u);
+    }
+    SECTION("static sizes, normal list")
+    {
+        using array = detail::free_list_array<detail::free_memory_list,
+                                        detail::static_access_policy<8, 16, 24, 48, 96>>;
+        array arr(stack, 50);
+        REQUIRE(arr.max_node_size() == 96u);
+        REQUIRE(arr.size() == 5u);
+
+        REQUIRE(arr.get(1u).node_size() == 8u);
+        REQUIRE(arr.get(12u).node_size() == 16u);
+        REQUIRE(arr.get(24u).node_size() == 24u);
+        REQUIRE(arr.get(40u).node_size() == 48u);
+        REQUIRE(arr.get(50u).node_size() == 96u);
+    }
 }
@@ -0,0 +1,84 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "double_ended_stack.hpp"
+
+#include <catch.hpp>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("double_ended_stack", "[stack]")
+{
+    test_allocator alloc;
+    {
+        double_ended_stack<allocator_reference<test_allocator>> stack(1024, alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(stack.capacity() == 1024 - detail::block_list_impl::impl_offset());
+        auto capacity = stack.capacity();
+
+        SECTION("both ends")
+        {
+            auto a = static_cast<char*>(stack.allocate_front(10, 1));
+            auto b = static_cast<char*>(stack.allocate_back(10, 1));
+            REQUIRE(a + 10 <= b);
+            REQUIRE(stack.capacity() == capacity - 20 - 4 * detail::debug_fence_size);
+
+            auto c = stack.allocate_back(10, 16);
+            REQUIRE(detail::is_aligned(c, 16));
+            REQUIRE(static_cast<char*>(c) + 10 <= b);
+            auto d = stack.allocate_front(10, 16);
+            REQUIRE(detail::is_aligned(d, 16));
+            REQUIRE(static_cast<char*>(d) + 10 <= c);
+        }
+        SECTION("independent unwind")
+        {
+            stack.allocate_front(10, 1);
+            auto front = stack.top_front();
+            auto result = stack.allocate_front(100, 8);
+
+            stack.allocate_back(10, 1);
+            auto back = stack.top_back();
+            auto temp = stack.allocate_back(100, 8);
+            auto temp_capacity = stack.capacity();
+
+            // releasing the temporaries does not touch the results
+            stack.unwind(back);
+            REQUIRE(stack.capacity() > temp_capacity);
+            REQUIRE(stack.allocate_back(100, 8) == temp);
+            stack.unwind(back);
+
+            stack.unwind(front);
+            REQUIRE(stack.allocate_front(100, 8) == result);
+        }
+        SECTION("full")
+        {
+            auto back = stack.top_back();
+            auto front = stack.top_front();
+            stack.allocate_back(capacity / 2, 1);
+            stack.allocate_front(capacity / 4, 1);
+            REQUIRE(stack.capacity() <= capacity / 4);
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+            auto handler = out_of_memory::set_handler([](const allocator_info &, std::size_t) {});
+            REQUIRE_THROWS_AS(stack.allocate_front(capacity / 4 + 1, 1), out_of_memory);
+            REQUIRE_THROWS_AS(stack.allocate_back(capacity / 4 + 1, 1), out_of_memory);
+            out_of_memory::set_handler(handler);
+#endif
+            stack.unwind(back);
+            stack.allocate_front(capacity / 2, 1);
+            stack.unwind(front);
+            REQUIRE(stack.capacity() == capacity);
+        }
+        SECTION("move")
+        {
+            auto a = stack.allocate_back(10, 1);
+            auto stack2 = detail::move(stack);
+            REQUIRE(stack2.capacity() < capacity);
+            REQUIRE(static_cast<char*>(stack2.allocate_back(10, 1)) < a);
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
@@ -0,0 +1,71 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "fallback_allocator.hpp"
+
+#include <catch.hpp>
+
+#include "allocator_storage.hpp"
+#include "double_ended_stack.hpp"
+#include "memory_pool.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("fallback_allocator", "[adapter]")
+{
+    test_allocator fallback;
+    SECTION("out of memory")
+    {
+        double_ended_stack<> stack(1024);
+        fallback_allocator<allocator_reference<double_ended_stack<>>, allocator_reference<test_allocator>>
+            alloc(stack, fallback);
+        auto capacity = stack.capacity();
+
+        auto a = alloc.allocate_node(capacity / 2, 1);
+        REQUIRE(stack.owns(a));
+        REQUIRE(fallback.no_allocated() == 0u);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        // the stack is full, so it falls back
+        auto handler = out_of_memory::set_handler([](const allocator_info &, std::size_t) {});
+        auto b = alloc.allocate_node(capacity, 1);
+        out_of_memory::set_handler(handler);
+        REQUIRE(!stack.owns(b));
+        REQUIRE(fallback.no_allocated() == 1u);
+
+        alloc.deallocate_node(b, capacity, 1);
+        REQUIRE(fallback.no_allocated() == 0u);
+        REQUIRE(fallback.last_deallocation_valid());
+#endif
+
+        // deallocation on the stack does nothing and must not reach the fallback
+        alloc.deallocate_node(a, capacity / 2, 1);
+        REQUIRE(fallback.no_deallocated() == (FOONATHAN_HAS_EXCEPTION_SUPPORT ? 1u : 0u));
+    }
+    SECTION("too big")
+    {
+        memory_pool<> pool(16, 1024);
+        fallback_allocator<allocator_reference<memory_pool<>>, allocator_reference<test_allocator>>
+            alloc(pool, fallback);
+        REQUIRE(alloc.max_node_size() == std::size_t(-1));
+        auto capacity = pool.capacity();
+
+        auto a = alloc.allocate_node(16, 1);
+        REQUIRE(pool.owns(a));
+        auto b = alloc.allocate_node(17, 1);
+        REQUIRE(!pool.owns(b));
+        REQUIRE(fallback.no_allocated() == 1u);
+        auto c = alloc.allocate_node(8, 32);
+        REQUIRE(!pool.owns(c));
+        REQUIRE(fallback.no_allocated() == 2u);
+
+        alloc.deallocate_node(c, 8, 32);
+        alloc.deallocate_node(b, 17, 1);
+        alloc.deallocate_node(a, 16, 1);
+        REQUIRE(fallback.no_allocated() == 0u);
+        REQUIRE(fallback.last_deallocation_valid());
+        REQUIRE(pool.capacity() == capacity);
+    }
+}
@@ -0,0 +1,137 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "frame_allocator.hpp"
+
+#include <catch.hpp>
+#include <cstring>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "std_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("frame_allocator", "[stack]")
+{
+    using allocator_type = frame_allocator<3, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        allocator_type frames(1024, alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(frames.frame_size() == 0u);
+        auto capacity = frames.capacity();
+
+        SECTION("generations")
+        {
+            auto a = static_cast<char*>(frames.allocate_node(10, 1));
+            std::strcpy(a, "frame 0");
+            REQUIRE(frames.frame_size() >= 10u);
+            REQUIRE(frames.capacity() <= capacity - 10u);
+
+            frames.next_frame();
+            REQUIRE(frames.frame_size() == 0u);
+            REQUIRE(frames.frame_size(1) >= 10u);
+            auto b = static_cast<char*>(frames.allocate_node(10, 1));
+            std::strcpy(b, "frame 1");
+
+            frames.next_frame();
+            frames.allocate_node(10, 1);
+            // data of the last two frames is still valid
+            REQUIRE(std::strcmp(a, "frame 0") == 0);
+            REQUIRE(std::strcmp(b, "frame 1") == 0);
+            REQUIRE(frames.owns(a));
+            REQUIRE(frames.owns(b));
+            auto no_allocated = alloc.no_allocated();
+
+            // frame 0 is unwound now
+            frames.next_frame();
+            REQUIRE(frames.frame_size() == 0u);
+            REQUIRE(!frames.owns(a));
+            REQUIRE(std::strcmp(b, "frame 1") == 0);
+
+            // and its block reused
+            frames.allocate_node(10, 1);
+            REQUIRE(alloc.no_allocated() == no_allocated);
+        }
+        SECTION("high water mark")
+        {
+            frames.allocate_node(100, 1);
+            frames.allocate_node(100, 1);
+            auto first = frames.frame_size();
+            REQUIRE(first >= 200u);
+            REQUIRE(frames.high_water_mark() == first);
+
+            frames.next_frame();
+            frames.allocate_node(50, 1);
+            REQUIRE(frames.frame_size() < first);
+            REQUIRE(frames.high_water_mark() == first);
+
+            for (auto i = 0u; i != 3u; ++i)
+                frames.next_frame();
+            REQUIRE(frames.frame_size(0) == 0u);
+            REQUIRE(frames.frame_size(1) == 0u);
+            REQUIRE(frames.frame_size(2) == 0u);
+            REQUIRE(frames.high_water_mark() == first);
+        }
+        SECTION("growth")
+        {
+            for (auto i = 0u; i != 20u; ++i)
+                REQUIRE(frames.owns(frames.allocate_node(100, 1)));
+            REQUIRE(alloc.no_allocated() > 1u);
+            REQUIRE(frames.frame_size() >= 2000u);
+
+            // the other generations need blocks, too
+            for (auto frame = 0u; frame != 2u; ++frame)
+            {
+                frames.next_frame();
+                frames.allocate_node(100, 1);
+            }
+            auto no_allocated = alloc.no_allocated();
+
+            // blocks of the first frame are reused by the other generations
+            for (auto frame = 0u; frame != 6u; ++frame)
+            {
+                frames.next_frame();
+                frames.allocate_node(100, 1);
+            }
+            REQUIRE(alloc.no_allocated() == no_allocated);
+
+            // each generation needs only one block now
+            frames.shrink_to_fit();
+            REQUIRE(alloc.no_allocated() == 3u);
+        }
+        SECTION("alignment")
+        {
+            frames.allocate_node(1, 1);
+            auto ptr = frames.allocate_node(8, 64);
+            REQUIRE(detail::is_aligned(ptr, 64));
+            frames.next_frame();
+            ptr = frames.allocate_array(3, 10, 16);
+            REQUIRE(detail::is_aligned(ptr, 16));
+        }
+        SECTION("std_allocator")
+        {
+            std::vector<int, std_allocator<int, allocator_type>> vec(frames);
+            for (auto i = 0; i != 10; ++i)
+                vec.push_back(i);
+            REQUIRE(frames.owns(vec.data()));
+        }
+        SECTION("move")
+        {
+            auto ptr = frames.allocate_node(100, 1);
+            auto frames2 = detail::move(frames);
+            REQUIRE(frames2.owns(ptr));
+            frames2.next_frame();
+            frames2.allocate_node(100, 1);
+
+            allocator_type frames3(1024, alloc);
+            frames3 = detail::move(frames2);
+            REQUIRE(frames3.owns(ptr));
+            REQUIRE(frames3.frame_size(1) >= 100u);
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
@@ -62,6 +62,82 @@ TEST_CASE("memory_pool", "[pool]")
             REQUIRE(pool.capacity() >= capacity);
             REQUIRE(alloc.no_allocated() == 2u);
         }
+        SECTION("clear")
+        {
+            auto capacity = pool.capacity();
+            auto no_nodes = capacity / pool.node_size() + 1u;
+            for (std::size_t i = 0u; i != no_nodes; ++i)
+                pool.allocate_node();
+            REQUIRE(alloc.no_allocated() == 2u);
+
+            pool.clear();
+            REQUIRE(pool.capacity() == capacity);
+            REQUIRE(alloc.no_allocated() == 2u);
+            REQUIRE(alloc.no_deallocated() == 0u);
+
+            // cached block is reused
+            for (std::size_t i = 0u; i != no_nodes; ++i)
+                pool.allocate_node();
+            REQUIRE(alloc.no_allocated() == 2u);
+            pool.clear();
+        }
+        SECTION("bulk alloc/dealloc")
+        {
+            auto no_nodes = pool.capacity() / pool.node_size() + 1u;
+            std::vector<void*> ptrs(no_nodes);
+            allocator_traits<pool_type>::allocate_node_bulk(pool, no_nodes, 4, 1, ptrs.data());
+            REQUIRE(alloc.no_allocated() == 2u);
+
+            auto sorted = ptrs;
+            std::sort(sorted.begin(), sorted.end());
+            REQUIRE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+            // through a storage, which locks only once
+            auto capacity = pool.capacity();
+            allocator_reference<pool_type> ref(pool);
+            ref.deallocate_node_bulk(no_nodes, 4, 1, ptrs.data());
+            REQUIRE(pool.capacity() == capacity + no_nodes * pool.node_size());
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("memory_pool shrink_to_fit", "[pool]")
+{
+    using pool_type = memory_pool<small_node_pool, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(4, 1024, alloc);
+        auto capacity = pool.capacity();
+
+        // grow the pool to four blocks
+        std::vector<void*> ptrs;
+        while (alloc.no_allocated() != 4u)
+            ptrs.push_back(pool.allocate_node());
+        // the last node is in the last block
+        auto last = ptrs.back();
+        ptrs.pop_back();
+
+        std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+        for (auto ptr : ptrs)
+            pool.deallocate_node(ptr);
+
+        pool.shrink_to_fit();
+        REQUIRE(alloc.no_allocated() == 2u);
+        REQUIRE(pool.owns(last));
+
+        pool.deallocate_node(last);
+        pool.shrink_to_fit();
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(pool.capacity() == capacity);
+
+        // the remaining block is still used
+        ptrs.clear();
+        for (std::size_t i = 0u; i != capacity / pool.node_size(); ++i)
+            ptrs.push_back(pool.allocate_node());
+        REQUIRE(alloc.no_allocated() == 1u);
+        for (auto ptr : ptrs)
+            pool.deallocate_node(ptr);
     }
     REQUIRE(alloc.no_allocated() == 0u);
 }
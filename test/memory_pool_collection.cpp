@@ -42,6 +42,9 @@ TEST_CASE("memory_pool_collection", "[pool]")
             }
             REQUIRE(alloc.no_allocated() == 1u);
             REQUIRE(pool.capacity() <= 1000u);
+            REQUIRE(pool.owns(a.front()));
+            REQUIRE(pool.owns(b.back()));
+            REQUIRE(!pool.owns(&a));
 
             std::shuffle(a.begin(), a.end(), std::mt19937{});
             std::shuffle(b.begin(), b.end(), std::mt19937{});
@@ -69,6 +72,48 @@ TEST_CASE("memory_pool_collection", "[pool]")
             for (auto ptr : b)
                 pool.deallocate_node(ptr, 5);
         }
+        SECTION("clear")
+        {
+            for (auto i = 0u; i != 1000u; ++i)
+            {
+                pool.allocate_node(1);
+                pool.allocate_node(5);
+            }
+            auto no_allocated = alloc.no_allocated();
+            REQUIRE(no_allocated > 1u);
+
+            pool.clear();
+            REQUIRE(pool.max_node_size() == max_size);
+            REQUIRE(pool.pool_capacity(1) == 0u);
+            REQUIRE(pool.pool_capacity(5) == 0u);
+            REQUIRE(alloc.no_allocated() == no_allocated);
+            REQUIRE(alloc.no_deallocated() == 0u);
+
+            // cached blocks are reused
+            for (auto i = 0u; i != 1000u; ++i)
+            {
+                pool.allocate_node(1);
+                pool.allocate_node(5);
+            }
+            REQUIRE(alloc.no_allocated() == no_allocated);
+            pool.clear();
+        }
+        SECTION("bulk alloc/dealloc")
+        {
+            std::vector<void*> ptrs(500u);
+            allocator_traits<pools>::allocate_node_bulk(pool, ptrs.size(), 5, 1, ptrs.data());
+            REQUIRE(alloc.no_allocated() > 1u);
+            REQUIRE(pool.owns(ptrs.front()));
+            REQUIRE(pool.owns(ptrs.back()));
+
+            auto sorted = ptrs;
+            std::sort(sorted.begin(), sorted.end());
+            REQUIRE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+            auto capacity = pool.pool_capacity(5);
+            allocator_traits<pools>::deallocate_node_bulk(pool, ptrs.size(), 5, 1, ptrs.data());
+            REQUIRE(pool.pool_capacity(5) > capacity);
+        }
     }
     REQUIRE(alloc.no_allocated() == 0u);
 }
@@ -75,5 +75,20 @@ TEST_CASE("memory_stack", "[stack]")
         REQUIRE(alloc.no_allocated() == 1u);
         REQUIRE(alloc.no_deallocated() == 1u);
     }
+    SECTION("bulk allocation")
+    {
+        using traits = allocator_traits<memory_stack<allocator_reference<test_allocator>>>;
+
+        void* ptrs[8];
+        traits::allocate_node_bulk(stack, 8, 16, 8, ptrs);
+        REQUIRE(alloc.no_allocated() > 1u);
+        for (auto i = 0u; i != 8u; ++i)
+        {
+            REQUIRE(detail::align_offset(ptrs[i], 8) == 0u);
+            for (auto j = 0u; j != i; ++j)
+                REQUIRE(ptrs[i] != ptrs[j]);
+        }
+        traits::deallocate_node_bulk(stack, 8, 16, 8, ptrs);
+    }
 }
 
@@ -0,0 +1,145 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "object_pool.hpp"
+
+#include <catch.hpp>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct buffer
+    {
+        static int constructed, destroyed;
+
+        std::vector<int> data;
+        int id;
+
+        buffer(int i = 0)
+        : data(100), id(i)
+        {
+            ++constructed;
+        }
+
+        ~buffer()
+        {
+            ++destroyed;
+        }
+    };
+
+    int buffer::constructed = 0;
+    int buffer::destroyed = 0;
+
+    struct buffer_reset
+    {
+        int calls = 0;
+
+        void operator()(buffer &b, int i = 0)
+        {
+            ++calls;
+            b.id = i;
+        }
+    };
+}
+
+TEST_CASE("object_pool", "[pool]")
+{
+    test_allocator alloc;
+    buffer::constructed = buffer::destroyed = 0;
+    {
+        object_pool<buffer, buffer_reset, allocator_reference<test_allocator>> pool(4096, alloc);
+        REQUIRE(pool.cached() == 0u);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        SECTION("caching")
+        {
+            auto a = pool.acquire(1);
+            REQUIRE(a->id == 1);
+            REQUIRE(buffer::constructed == 1);
+            auto data = a->data.data();
+
+            pool.release(a);
+            REQUIRE(pool.cached() == 1u);
+            REQUIRE(buffer::destroyed == 0);
+
+            auto b = pool.acquire(2);
+            REQUIRE(b == a);
+            REQUIRE(b->id == 2);
+            REQUIRE(b->data.data() == data);
+            REQUIRE(buffer::constructed == 1);
+            REQUIRE(pool.reset_hook().calls == 1);
+            REQUIRE(pool.cached() == 0u);
+
+            auto c = pool.acquire();
+            REQUIRE(c != b);
+            REQUIRE(buffer::constructed == 2);
+
+            pool.release(b);
+            pool.destroy(c);
+            REQUIRE(buffer::destroyed == 1);
+            REQUIRE(pool.cached() == 1u);
+        }
+        SECTION("shrink")
+        {
+            std::vector<buffer*> buffers;
+            for (auto i = 0; i != 10; ++i)
+                buffers.push_back(pool.acquire(i));
+            for (auto b : buffers)
+                pool.release(b);
+            REQUIRE(pool.cached() == 10u);
+            auto capacity = pool.capacity();
+
+            pool.shrink();
+            REQUIRE(pool.cached() == 0u);
+            REQUIRE(buffer::destroyed == 10);
+            REQUIRE(pool.capacity() > capacity);
+        }
+        SECTION("unique_ptr")
+        {
+            buffer *ptr;
+            {
+                auto a = acquire_unique(pool, 5);
+                REQUIRE(a->id == 5);
+                ptr = a.get();
+            }
+            REQUIRE(pool.cached() == 1u);
+            auto b = acquire_unique(pool);
+            REQUIRE(b.get() == ptr);
+            REQUIRE(b->id == 0);
+        }
+        SECTION("move")
+        {
+            pool.release(pool.acquire());
+            auto pool2 = detail::move(pool);
+            REQUIRE(pool.cached() == 0u);
+            REQUIRE(pool2.cached() == 1u);
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(buffer::constructed == buffer::destroyed);
+}
+
+TEST_CASE("object_pool default reset", "[pool]")
+{
+    object_pool<int> pool(1024);
+    auto a = pool.acquire(42);
+    pool.release(a);
+
+    // no arguments keep the state
+    auto b = pool.acquire();
+    REQUIRE(b == a);
+    REQUIRE(*b == 42);
+    pool.release(b);
+
+    // arguments assign a new object
+    auto c = pool.acquire(11);
+    REQUIRE(c == a);
+    REQUIRE(*c == 11);
+    pool.release(c);
+}
@@ -0,0 +1,91 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "owner_memory_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("owner_memory_pool", "[pool]")
+{
+    using pool_type = owner_memory_pool<node_pool, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(4, 1000, alloc);
+        REQUIRE(pool.node_size() >= sizeof(char*));
+        REQUIRE(pool.capacity() <= 1000u);
+        REQUIRE(pool.owner() == std::this_thread::get_id());
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        SECTION("owner alloc/dealloc")
+        {
+            std::vector<void*> ptrs;
+            auto capacity = pool.capacity();
+            for (std::size_t i = 0u; i != capacity / pool.node_size(); ++i)
+                ptrs.push_back(pool.allocate_node());
+            REQUIRE(pool.capacity() == 0u);
+
+            std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+            REQUIRE(pool.capacity() == capacity);
+            REQUIRE(alloc.no_allocated() == 1u);
+        }
+        SECTION("remote dealloc")
+        {
+            std::vector<void*> ptrs;
+            auto capacity = pool.capacity();
+            for (std::size_t i = 0u; i != capacity / pool.node_size(); ++i)
+                ptrs.push_back(pool.allocate_node());
+            REQUIRE(pool.capacity() == 0u);
+
+            std::thread consumer([&]
+            {
+                for (auto ptr : ptrs)
+                    pool.deallocate_node(ptr);
+            });
+            consumer.join();
+            // remote frees are not on the free list yet
+            REQUIRE(pool.capacity() == 0u);
+
+            // but are reclaimed instead of allocating a new block
+            auto ptr = pool.allocate_node();
+            REQUIRE(alloc.no_allocated() == 1u);
+            REQUIRE(pool.capacity() == capacity - pool.node_size());
+            pool.deallocate_node(ptr);
+        }
+        SECTION("producer/consumer")
+        {
+            const auto no_nodes = 10000u;
+            std::vector<void*> ptrs(no_nodes, nullptr);
+            std::atomic<std::size_t> produced(0u);
+
+            std::thread consumer([&]
+            {
+                for (auto i = 0u; i != no_nodes; ++i)
+                {
+                    while (produced.load(std::memory_order_acquire) <= i)
+                        std::this_thread::yield();
+                    pool.deallocate_node(ptrs[i]);
+                }
+            });
+            for (auto i = 0u; i != no_nodes; ++i)
+            {
+                ptrs[i] = pool.allocate_node();
+                produced.store(i + 1, std::memory_order_release);
+            }
+            consumer.join();
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
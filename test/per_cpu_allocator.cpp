@@ -0,0 +1,118 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "per_cpu_allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "memory_pool.hpp"
+#include "memory_pool_collection.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("per_cpu_allocator", "[pool]")
+{
+    SECTION("memory_pool")
+    {
+        per_cpu_allocator<memory_pool<>> alloc(16, 1000);
+        REQUIRE(alloc.arena_count() >= 1u);
+        REQUIRE(alloc.local_arena_index() < alloc.arena_count());
+        REQUIRE(alloc.max_node_size() == alloc.get_arena(0).node_size());
+
+        allocator_reference<per_cpu_allocator<memory_pool<>>, no_mutex> ref(alloc);
+        std::vector<void*> ptrs;
+        for (auto i = 0u; i != 20u; ++i)
+            ptrs.push_back(ref.allocate_node(16, 1));
+        std::sort(ptrs.begin(), ptrs.end());
+        REQUIRE(std::adjacent_find(ptrs.begin(), ptrs.end()) == ptrs.end());
+
+        for (auto ptr : ptrs)
+            ref.deallocate_node(ptr, 16, 1);
+    }
+    SECTION("fast path")
+    {
+        test_allocator impl;
+        {
+            using pool = memory_pool<node_pool, allocator_reference<test_allocator>>;
+            per_cpu_allocator<pool> alloc(16, 1000, allocator_reference<test_allocator>(impl));
+            if (alloc.has_fast_path())
+            {
+                // a node is cached on deallocation and returned by the next allocation on the same processor
+                // unless the thread has been migrated in between
+                auto cpu = alloc.local_arena_index();
+                auto ptr = alloc.allocate_node(8, 1);
+                alloc.deallocate_node(ptr, 8, 1);
+                auto other = alloc.allocate_node(16, 8);
+                if (alloc.local_arena_index() == cpu)
+                    REQUIRE(other == ptr);
+                alloc.deallocate_node(other, 16, 8);
+            }
+
+            // arrays are never cached
+            auto array = alloc.allocate_array(4, 16, 1);
+            alloc.deallocate_array(array, 4, 16, 1);
+        }
+        // the destructor returns the cached nodes before destroying the arenas
+        REQUIRE(impl.no_allocated() == 0u);
+    }
+    SECTION("memory_pool_collection multithreaded")
+    {
+        using collection = memory_pool_collection<node_pool, identity_buckets>;
+        per_cpu_allocator<collection> alloc(16, 4000);
+        REQUIRE(alloc.max_node_size() == 16u);
+
+        const auto no_threads = 4u, no_nodes = 500u;
+        std::atomic<bool> start(false);
+        std::vector<std::size_t> errors(no_threads, 0u);
+        std::vector<std::size_t*> shared(no_threads * no_nodes, nullptr);
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t != no_threads; ++t)
+            threads.emplace_back([&, t]
+            {
+                allocator_reference<per_cpu_allocator<collection>, no_mutex> ref(alloc);
+                while (!start)
+                    std::this_thread::yield();
+
+                std::vector<std::size_t*> ptrs;
+                for (auto round = 0u; round != 10u; ++round)
+                {
+                    for (auto i = 0u; i != no_nodes; ++i)
+                    {
+                        auto ptr = static_cast<std::size_t*>(ref.allocate_node(8 + i % 9, 1));
+                        *ptr = t;
+                        ptrs.push_back(ptr);
+                        std::this_thread::yield(); // encourage migration
+                    }
+                    for (auto ptr : ptrs)
+                        if (*ptr != t)
+                            ++errors[t];
+                    for (auto i = 0u; i != no_nodes; ++i)
+                        ref.deallocate_node(ptrs[i], 8 + i % 9, 1);
+                    ptrs.clear();
+                }
+
+                // leave some nodes to be freed by another thread
+                for (auto i = 0u; i != no_nodes; ++i)
+                    shared[t * no_nodes + i] = static_cast<std::size_t*>(ref.allocate_node(8, 1));
+            });
+        start = true;
+        for (auto &thread : threads)
+            thread.join();
+
+        for (auto e : errors)
+            REQUIRE(e == 0u);
+
+        std::thread([&]
+        {
+            for (auto ptr : shared)
+                alloc.deallocate_node(ptr, 8, 1);
+        }).join();
+    }
+}
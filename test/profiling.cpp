@@ -6,16 +6,28 @@
 
 #include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <random>
+#include <thread>
 #include <vector>
 
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+
 #include "allocator_storage.hpp"
+#include "buddy_allocator.hpp"
+#include "concurrent_memory_pool.hpp"
+#include "sharded_pool_collection.hpp"
 #include "heap_allocator.hpp"
 #include "new_allocator.hpp"
 #include "memory_pool.hpp"
+#include "memory_pool_collection.hpp"
 #include "memory_stack.hpp"
+#include "tlsf_allocator.hpp"
 
 namespace memory = foonathan::memory;
 
@@ -180,7 +192,7 @@ void benchmark_node(std::initializer_list<std::size_t> counts,
                     std::initializer_list<std::size_t> node_sizes)
 {
     using namespace foonathan::memory;
-    std::cout << Func::name() << "\n\t\tHeap\tNew\tSmall\tNode\tArray\tStack\n";
+    std::cout << Func::name() << "\n\t\tHeap\tNew\tSmall\tNode\tArray\tBitmap\tStack\n";
     for (auto count : counts)
         for (auto size : node_sizes)
         {
@@ -192,13 +204,15 @@ void benchmark_node(std::initializer_list<std::size_t> counts,
                     memory_pool<node_pool>{size, count * size * 2});
             auto array_alloc = make_allocator_adapter(
                     memory_pool<array_pool>{size, count * size * 2});
+            auto bitmap_alloc = make_allocator_adapter(
+                    memory_pool<bitmap_pool>{size, count * size * 2});
             auto stack_alloc = make_allocator_adapter(
                     memory_stack<>{count * size * 2});
 
             std::cout << count << '*' << std::setw(2) << size << ": \t";
             benchmark_node<Func>(count, size, heap_alloc, new_alloc,
                                  small_alloc, node_alloc, array_alloc,
-                                 stack_alloc);
+                                 bitmap_alloc, stack_alloc);
         }
     std::cout << '\n';
 }
@@ -227,7 +241,7 @@ void benchmark_array(std::initializer_list<std::size_t> counts,
                      std::initializer_list<std::size_t> array_sizes)
 {
     using namespace foonathan::memory;
-    std::cout << Func::name() << "\n\t\tHeap\tNew\tNode\tArray\tStack\n";
+    std::cout << Func::name() << "\n\t\tHeap\tNew\tNode\tArray\tIndexed\tBitmap\tStack\n";
     for (auto count : counts)
         for (auto node_size : node_sizes)
             for (auto array_size : array_sizes)
@@ -238,12 +252,15 @@ void benchmark_array(std::initializer_list<std::size_t> counts,
                 auto new_alloc = make_allocator_adapter(new_allocator{});
                 auto node_alloc = make_allocator_adapter(memory_pool<node_pool>{node_size, mem_needed});
                 auto array_alloc = make_allocator_adapter(memory_pool<array_pool>{node_size, mem_needed});
+                auto indexed_alloc = make_allocator_adapter(memory_pool<indexed_array_pool>{node_size, mem_needed});
+                auto bitmap_alloc = make_allocator_adapter(memory_pool<bitmap_pool>{node_size, mem_needed});
                 auto stack_alloc = make_allocator_adapter(memory_stack<>{mem_needed});
 
                 std::cout << count << '*' << std::setw(3) << node_size
                           << '*' << std::setw(3) << array_size<< ": \t";
                 benchmark_array<Func>(count , array_size, node_size,
-                                      heap_alloc, new_alloc, node_alloc, array_alloc, stack_alloc);
+                                      heap_alloc, new_alloc, node_alloc, array_alloc, indexed_alloc,
+                                      bitmap_alloc, stack_alloc);
             }
     std::cout << '\n';
 }
@@ -257,13 +274,265 @@ void benchmark_array(std::initializer_list<std::size_t> counts,
     benchmark_array<Second, Tail...>(counts, node_sizes, array_sizes);
 }
 
+// allocates and deallocates count nodes in no_threads threads concurrently
+// returns the time until all threads have finished
+struct threaded
+{
+    std::size_t count, no_threads;
+
+    threaded(std::size_t c, std::size_t t)
+    : count(c), no_threads(t) {}
+
+    template <class RawAllocator>
+    std::size_t operator()(RawAllocator &alloc, std::size_t size)
+    {
+        return measure([&]()
+                       {
+                           std::vector<std::thread> threads;
+                           for (std::size_t t = 0u; t != no_threads; ++t)
+                               threads.emplace_back([&]()
+                               {
+                                   std::vector<void*> ptrs;
+                                   ptrs.reserve(count);
+                                   for (std::size_t i = 0u; i != count; ++i)
+                                       ptrs.push_back(alloc.allocate_node(size, 1));
+                                   for (auto ptr : ptrs)
+                                       alloc.deallocate_node(ptr, size, 1);
+                               });
+                           for (auto &thread : threads)
+                               thread.join();
+                       });
+    }
+
+    static const char* name() {return "threaded";}
+};
+
+// starting threads is expensive, so use less samples
+const std::size_t threaded_sample_size = 16u;
+
+template <class RawAllocator>
+std::size_t benchmark_threaded(threaded func, RawAllocator &alloc, std::size_t size)
+{
+    auto min_time = std::size_t(-1);
+    for (std::size_t i = 0u; i != threaded_sample_size; ++i)
+    {
+        auto time = func(alloc, size);
+        if (time < min_time)
+            min_time = time;
+    }
+    return min_time;
+}
+
+template <class ... Allocators>
+void benchmark_threaded(std::size_t no_threads, std::size_t count, std::size_t size,
+                        Allocators&... allocators)
+{
+    int dummy[] = {(std::cout << benchmark_threaded(threaded{count, no_threads}, allocators, size)
+                              << '\t', 0)...};
+    (void)dummy;
+    std::cout << '\n';
+}
+
+void benchmark_threaded(std::initializer_list<std::size_t> thread_counts,
+                        std::initializer_list<std::size_t> counts,
+                        std::initializer_list<std::size_t> node_sizes)
+{
+    using namespace foonathan::memory;
+    std::cout << threaded::name() << "\n\t\t\tLocked\tSpin\tAdapt.\tConcurrent\tSharded\n";
+    for (auto no_threads : thread_counts)
+        for (auto count : counts)
+            for (auto size : node_sizes)
+            {
+                auto mem_needed = count * size * no_threads * 2;
+
+                auto locked_alloc = make_thread_safe_allocator(
+                        memory_pool<node_pool>{size, mem_needed});
+                auto spin_alloc = make_thread_safe_allocator<spin_mutex>(
+                        memory_pool<node_pool>{size, mem_needed});
+                auto adaptive_alloc = make_thread_safe_allocator<adaptive_mutex>(
+                        memory_pool<node_pool>{size, mem_needed});
+                concurrent_memory_pool<> concurrent_pool(size, mem_needed);
+                allocator_reference<concurrent_memory_pool<>, no_mutex> concurrent_alloc(concurrent_pool);
+                sharded_pool_collection<node_pool, identity_buckets> sharded_pool(size, mem_needed);
+                allocator_reference<decltype(sharded_pool), no_mutex> sharded_alloc(sharded_pool);
+
+                std::cout << no_threads << '*' << count << '*' << std::setw(2) << size << ": \t";
+                benchmark_threaded(no_threads, count, size, locked_alloc,
+                                   spin_alloc, adaptive_alloc, concurrent_alloc, sharded_alloc);
+            }
+    std::cout << '\n';
+}
+
+// allocates count nodes of random sizes up to max_size and deallocates them in random order
+// prints the time needed and how much of the allocated memory is wasted by rounding up to the bucket size
+template <class BucketDistribution>
+void benchmark_buckets(std::size_t count, std::size_t max_size)
+{
+    using namespace foonathan::memory;
+    using policy = typename BucketDistribution::type;
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<std::size_t> dist(1u, max_size);
+    std::vector<std::size_t> sizes(count);
+    std::size_t requested = 0u, used = 0u;
+    for (auto &size : sizes)
+    {
+        size = dist(rng);
+        auto bucket_size = policy::size_from_index(policy::index_from_size(size));
+        requested += size;
+        used += std::max(bucket_size, node_pool::type::min_element_size);
+    }
+
+    memory_pool_collection<node_pool, BucketDistribution> pools(max_size, count * max_size * 2);
+    std::vector<void*> ptrs(count);
+    std::vector<std::size_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    auto time = benchmark([&]()
+    {
+        auto alloc_t = measure([&]()
+                               {
+                                   for (std::size_t i = 0u; i != count; ++i)
+                                       ptrs[i] = pools.allocate_node(sizes[i]);
+                               });
+        std::shuffle(order.begin(), order.end(), rng);
+        auto dealloc_t = measure([&]()
+                                 {
+                                     for (auto i : order)
+                                         pools.deallocate_node(ptrs[i], sizes[i]);
+                                 });
+        return alloc_t + dealloc_t;
+    });
+    std::cout << time << '/' << (used - requested) * 100u / used << "%\t";
+}
+
+void benchmark_buckets(std::initializer_list<std::size_t> counts,
+                       std::initializer_list<std::size_t> max_sizes)
+{
+    using namespace foonathan::memory;
+    std::cout << "buckets (time/wasted memory)\n\t\tIdentity\tLog2\tSizeClass\n";
+    for (auto count : counts)
+        for (auto max_size : max_sizes)
+        {
+            std::cout << count << '*' << std::setw(3) << max_size << ": \t";
+            benchmark_buckets<identity_buckets>(count, max_size);
+            benchmark_buckets<log2_buckets>(count, max_size);
+            benchmark_buckets<size_class_buckets>(count, max_size);
+            std::cout << '\n';
+        }
+    std::cout << '\n';
+}
+
+// allocates count buffers of random sizes between min_size and max_size and deallocates them in random order
+template <class RawAllocator>
+std::size_t benchmark_medium(RawAllocator &alloc, std::size_t count,
+                             std::size_t min_size, std::size_t max_size)
+{
+    std::mt19937 rng;
+    std::uniform_int_distribution<std::size_t> dist(min_size, max_size);
+    std::vector<std::size_t> sizes(count);
+    for (auto &size : sizes)
+        size = dist(rng);
+    std::vector<void*> ptrs(count);
+    std::vector<std::size_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+
+    return benchmark([&]()
+    {
+        auto alloc_t = measure([&]()
+                               {
+                                   for (std::size_t i = 0u; i != count; ++i)
+                                       ptrs[i] = alloc.allocate_node(sizes[i], 1);
+                               });
+        std::shuffle(order.begin(), order.end(), rng);
+        auto dealloc_t = measure([&]()
+                                 {
+                                     for (auto i : order)
+                                         alloc.deallocate_node(ptrs[i], sizes[i], 1);
+                                 });
+        return alloc_t + dealloc_t;
+    });
+}
+
+void benchmark_medium(std::initializer_list<std::size_t> counts)
+{
+    using namespace foonathan::memory;
+    const std::size_t min_size = 4096u, max_size = 1024u * 1024u;
+    std::cout << "medium (4KiB - 1MiB)\n\t\tHeap\tBuddy\tTLSF\n";
+    for (auto count : counts)
+    {
+        auto heap_alloc = make_allocator_adapter(heap_allocator{});
+        buddy_allocator<> buddy(min_size, max_size, count * max_size * 2);
+        tlsf_allocator<> tlsf(count * max_size * 2);
+
+        std::cout << count << ": \t\t";
+        std::cout << benchmark_medium(heap_alloc, count, min_size, max_size) << '\t';
+        std::cout << benchmark_medium(buddy, count, min_size, max_size) << '\t';
+        std::cout << benchmark_medium(tlsf, count, min_size, max_size) << '\n';
+    }
+    std::cout << '\n';
+}
+
+// returns the resident set size of the process in KiB or 0 if unknown
+std::size_t resident_size()
+{
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size, resident;
+    if (statm >> size >> resident)
+        return resident * std::size_t(sysconf(_SC_PAGESIZE)) / 1024u;
+#endif
+    return 0u;
+}
+
+// constructs a pool with a single big block
+// prints the time needed and how much of the block has been touched
+template <class PoolType>
+void benchmark_construction(std::size_t node_size, std::size_t block_size)
+{
+    auto rss = resident_size();
+    auto start = std::chrono::system_clock::now();
+    memory::memory_pool<PoolType> pool(node_size, block_size);
+    auto duration = std::chrono::duration_cast<unit>(std::chrono::system_clock::now() - start);
+    std::cout << duration.count() << '/' << resident_size() - rss << "\t";
+}
+
+void benchmark_construction(std::initializer_list<std::size_t> block_sizes,
+                            std::initializer_list<std::size_t> node_sizes)
+{
+    using namespace foonathan::memory;
+    std::cout << "construction (time/RSS growth in KiB)\n\t\tSmall\tNode\tArray\tBitmap\n";
+    for (auto block_size : block_sizes)
+        for (auto size : node_sizes)
+        {
+            std::cout << (block_size >> 20) << "MiB*" << std::setw(2) << size << ": \t";
+            benchmark_construction<small_node_pool>(size, block_size);
+            benchmark_construction<node_pool>(size, block_size);
+            benchmark_construction<array_pool>(size, block_size);
+            benchmark_construction<bitmap_pool>(size, block_size);
+            std::cout << '\n';
+        }
+    std::cout << '\n';
+}
+
 int main()
 {
     using namespace foonathan::memory;
 
     std::cout << "Node\n\n";
-    benchmark_node<single, bulk, bulk_reversed, butterfly>({256, 512, 1024}, {1, 4, 8, 256});
+    benchmark_node<single, bulk, bulk_reversed, butterfly>({256, 512, 1024}, {1, 2, 4, 8, 256});
 
     std::cout << "Array\n\n";
     benchmark_array<single, bulk, bulk_reversed, butterfly>({256, 512}, {1, 4, 8}, {1, 4, 8});
+
+    std::cout << "Threaded\n\n";
+    benchmark_threaded({1, 2, 4, 8}, {1024, 4096}, {8, 64});
+
+    std::cout << "Buckets\n\n";
+    benchmark_buckets({256, 1024}, {64, 256, 1024});
+
+    std::cout << "Medium\n\n";
+    benchmark_medium({16, 64});
+
+    std::cout << "Construction\n\n";
+    benchmark_construction({1u << 20, 16u << 20, 64u << 20}, {1, 8});
 }
@@ -0,0 +1,160 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "ring_allocator.hpp"
+
+#include <catch.hpp>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "std_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("ring_allocator", "[ring]")
+{
+    using allocator_type = ring_allocator<allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        allocator_type ring(1024, alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+        auto capacity = ring.capacity();
+        REQUIRE(capacity > 0u);
+        REQUIRE(capacity < 1024u);
+
+        SECTION("fifo")
+        {
+            auto a = static_cast<char*>(ring.allocate_node(100, 1));
+            auto b = static_cast<char*>(ring.allocate_node(100, 1));
+            REQUIRE(a + 100 <= b);
+            auto remaining = ring.capacity();
+            REQUIRE(remaining < capacity - 200u);
+
+            // tail is reclaimed
+            ring.deallocate_node(a, 100, 1);
+            REQUIRE(ring.capacity() > remaining);
+            ring.deallocate_node(b, 100, 1);
+            REQUIRE(ring.capacity() == capacity);
+        }
+        SECTION("out of order")
+        {
+            auto a = ring.allocate_node(100, 1);
+            auto b = ring.allocate_node(100, 1);
+            auto c = ring.allocate_node(100, 1);
+            auto remaining = ring.capacity();
+
+            // b is not at the tail, nothing is reclaimed
+            ring.deallocate_node(b, 100, 1);
+            REQUIRE(ring.capacity() == remaining);
+
+            // now both a and b are
+            ring.deallocate_node(a, 100, 1);
+            auto reclaimed = ring.capacity();
+            REQUIRE(reclaimed >= remaining + 200u);
+
+            ring.deallocate_node(c, 100, 1);
+            REQUIRE(ring.capacity() == capacity);
+        }
+        SECTION("wrap around")
+        {
+            std::deque<void*> frames;
+            for (auto i = 0u; i != 100u; ++i)
+            {
+                frames.push_back(ring.allocate_node(200, 1));
+                if (frames.size() == 3u)
+                {
+                    ring.deallocate_node(frames.front(), 200, 1);
+                    frames.pop_front();
+                }
+            }
+            // three frames always fit into one ring
+            REQUIRE(alloc.no_allocated() == 1u);
+            for (auto ptr : frames)
+                ring.deallocate_node(ptr, 200, 1);
+            REQUIRE(ring.capacity() == capacity);
+        }
+        SECTION("alignment")
+        {
+            auto a = ring.allocate_node(10, 1);
+            auto b = ring.allocate_node(10, 64);
+            REQUIRE(detail::is_aligned(b, 64));
+            auto c = ring.allocate_array(3, 10, 128);
+            REQUIRE(detail::is_aligned(c, 128));
+
+            ring.deallocate_node(a, 10, 1);
+            ring.deallocate_array(c, 3, 10, 128);
+            ring.deallocate_node(b, 10, 64);
+            REQUIRE(ring.capacity() == capacity);
+        }
+        SECTION("growth")
+        {
+            std::vector<void*> frames;
+            for (auto i = 0u; i != 20u; ++i)
+            {
+                auto ptr = ring.allocate_node(100, 1);
+                REQUIRE(ring.owns(ptr));
+                frames.push_back(ptr);
+            }
+            REQUIRE(alloc.no_allocated() > 1u);
+            auto no_allocated = alloc.no_allocated();
+
+            for (auto ptr : frames)
+                ring.deallocate_node(ptr, 100, 1);
+
+            // the old rings are reused
+            for (auto i = 0u; i != 20u; ++i)
+                frames[i] = ring.allocate_node(100, 1);
+            REQUIRE(alloc.no_allocated() == no_allocated);
+            for (auto ptr : frames)
+                ring.deallocate_node(ptr, 100, 1);
+        }
+        SECTION("random")
+        {
+            std::mt19937 rng;
+            std::uniform_int_distribution<std::size_t> dist(1u, 300u);
+            std::deque<std::pair<void*, std::size_t>> frames;
+            for (auto i = 0u; i != 1000u; ++i)
+            {
+                auto size = dist(rng);
+                frames.emplace_back(ring.allocate_node(size, 1), size);
+                // frees roughly in order
+                if (frames.size() > 4u)
+                {
+                    auto index = std::uniform_int_distribution<std::size_t>(0u, 2u)(rng);
+                    ring.deallocate_node(frames[index].first, frames[index].second, 1);
+                    frames.erase(frames.begin() + std::ptrdiff_t(index));
+                }
+            }
+            for (auto &f : frames)
+                ring.deallocate_node(f.first, f.second, 1);
+        }
+        SECTION("std_allocator")
+        {
+            std::vector<int, std_allocator<int, allocator_type>> vec(ring);
+            for (auto i = 0; i != 10; ++i)
+                vec.push_back(i);
+            REQUIRE(ring.owns(vec.data()));
+        }
+        SECTION("move")
+        {
+            auto ptr = ring.allocate_node(100, 1);
+            auto ring2 = detail::move(ring);
+            ring2.deallocate_node(ptr, 100, 1);
+            REQUIRE(ring2.capacity() == capacity);
+        }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        SECTION("too big")
+        {
+            REQUIRE(ring.max_node_size() == ring.next_capacity());
+            REQUIRE_THROWS_AS(ring.allocate_node(std::size_t(-1) - 8u, 1), bad_allocation_size);
+            REQUIRE_THROWS_AS(ring.allocate_node(ring.max_node_size() + 1u, 1), bad_allocation_size);
+            REQUIRE(alloc.no_allocated() == 1u);
+        }
+#endif
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
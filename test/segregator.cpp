@@ -0,0 +1,78 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "segregator.hpp"
+
+#include <catch.hpp>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "heap_allocator.hpp"
+#include "memory_pool_collection.hpp"
+#include "new_allocator.hpp"
+#include "std_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("segregator", "[adapter]")
+{
+    SECTION("dispatch")
+    {
+        test_allocator small, large;
+        segregator<32, allocator_reference<test_allocator>, allocator_reference<test_allocator>>
+            alloc(small, large);
+
+        auto a = alloc.allocate_node(16, 1);
+        auto b = alloc.allocate_node(32, 1);
+        REQUIRE(small.no_allocated() == 2u);
+        REQUIRE(large.no_allocated() == 0u);
+
+        auto c = alloc.allocate_node(33, 1);
+        REQUIRE(large.no_allocated() == 1u);
+
+        // arrays use the total size
+        auto d = alloc.allocate_array(2, 16, 1);
+        auto e = alloc.allocate_array(4, 10, 1);
+        REQUIRE(small.no_allocated() == 3u);
+        REQUIRE(large.no_allocated() == 2u);
+
+        alloc.deallocate_array(e, 4, 10, 1);
+        alloc.deallocate_array(d, 2, 16, 1);
+        alloc.deallocate_node(c, 33, 1);
+        alloc.deallocate_node(b, 32, 1);
+        alloc.deallocate_node(a, 16, 1);
+        REQUIRE(small.no_allocated() == 0u);
+        REQUIRE(small.last_deallocation_valid());
+        REQUIRE(large.no_allocated() == 0u);
+        REQUIRE(large.last_deallocation_valid());
+    }
+    SECTION("stateless")
+    {
+        using stateless = segregator<64, heap_allocator, new_allocator>;
+        REQUIRE(!allocator_traits<stateless>::is_stateful::value);
+        REQUIRE(std::is_empty<stateless>::value);
+
+        stateless alloc;
+        auto ptr = allocator_traits<stateless>::allocate_node(alloc, 128, 8);
+        allocator_traits<stateless>::deallocate_node(alloc, ptr, 128, 8);
+    }
+    SECTION("std_allocator")
+    {
+        using pools = memory_pool_collection<node_pool, identity_buckets>;
+        using allocator_type = segregator<16, pools, heap_allocator>;
+        allocator_type alloc(pools(16, 4000));
+        REQUIRE(allocator_traits<allocator_type>::is_stateful::value);
+
+        {
+            std::vector<int, std_allocator<int, allocator_type>> vec(alloc);
+            vec.push_back(0);
+            REQUIRE(alloc.get_small_allocator().owns(vec.data()));
+            for (auto i = 1; i != 100; ++i)
+                vec.push_back(i);
+            REQUIRE(!alloc.get_small_allocator().owns(vec.data()));
+        }
+        REQUIRE(alloc.get_small_allocator().capacity() > 0u);
+    }
+}
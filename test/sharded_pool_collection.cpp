@@ -0,0 +1,97 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "sharded_pool_collection.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+
+using namespace foonathan::memory;
+
+TEST_CASE("sharded_pool_collection", "[pool]")
+{
+    using pools = sharded_pool_collection<node_pool, identity_buckets, 4u>;
+    pools pool(16, 1000);
+    REQUIRE(pool.shard_count() == 4u);
+    REQUIRE(pool.max_node_size() == 16u);
+    REQUIRE(pool.next_capacity() >= 1000u);
+    REQUIRE(pool.local_shard_index() < 4u);
+
+    SECTION("single threaded alloc/dealloc")
+    {
+        std::vector<void*> a, b;
+        for (auto i = 0u; i != 1000u; ++i)
+        {
+            a.push_back(pool.allocate_node(1));
+            b.push_back(pool.allocate_node(5));
+        }
+        for (auto ptr : a)
+            pool.deallocate_node(ptr, 1);
+        for (auto ptr : b)
+            pool.deallocate_node(ptr, 5);
+    }
+    SECTION("cross shard deallocation")
+    {
+        std::vector<void*> ptrs;
+        std::size_t other_index = 0u;
+        std::thread t([&]
+        {
+            other_index = pool.local_shard_index();
+            for (auto i = 0u; i != 100u; ++i)
+                ptrs.push_back(pool.allocate_node(8));
+        });
+        t.join();
+        REQUIRE(other_index != pool.local_shard_index());
+
+        // deallocated by a thread using another shard
+        for (auto ptr : ptrs)
+            pool.deallocate_node(ptr, 8);
+    }
+    SECTION("multithreaded")
+    {
+        const auto no_threads = 8u, no_nodes = 500u;
+        std::atomic<bool> start(false);
+        std::vector<std::size_t> errors(no_threads, 0u);
+        std::vector<std::vector<void*>> allocated(no_threads);
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t != no_threads; ++t)
+            threads.emplace_back([&, t]
+            {
+                while (!start)
+                    std::this_thread::yield();
+
+                auto &ptrs = allocated[t];
+                for (auto i = 0u; i != no_nodes; ++i)
+                {
+                    auto ptr = static_cast<std::size_t*>(pool.allocate_node(8 + i % 9));
+                    *ptr = t;
+                    ptrs.push_back(ptr);
+                }
+                for (auto ptr : ptrs)
+                    if (*static_cast<std::size_t*>(ptr) != t)
+                        ++errors[t];
+            });
+        start = true;
+        for (auto &thread : threads)
+            thread.join();
+        for (auto e : errors)
+            REQUIRE(e == 0u);
+
+        // deallocate everything from other threads
+        threads.clear();
+        for (auto t = 0u; t != no_threads; ++t)
+            threads.emplace_back([&, t]
+            {
+                auto &ptrs = allocated[(t + 1) % no_threads];
+                for (auto i = 0u; i != no_nodes; ++i)
+                    pool.deallocate_node(ptrs[i], 8 + i % 9);
+            });
+        for (auto &thread : threads)
+            thread.join();
+    }
+}
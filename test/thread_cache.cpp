@@ -0,0 +1,111 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "thread_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+using namespace foonathan::memory;
+
+template <class BucketDistribution>
+void test_thread_cache()
+{
+    using cache_type = thread_cache<node_pool, BucketDistribution>;
+    typename cache_type::depot_type depot(memory_pool_collection<node_pool, BucketDistribution>(16, 4000));
+    auto &collection = depot.get_allocator();
+
+    SECTION("magazine fill/drain")
+    {
+        cache_type cache(depot, 8u);
+        REQUIRE(cache.magazine_size() == 8u);
+        REQUIRE(cache.max_node_size() == collection.max_node_size());
+        REQUIRE(cache.cached(1) == 0u);
+
+        auto ptr = cache.allocate_node(1);
+        REQUIRE(ptr);
+        // filled with half of the magazine
+        REQUIRE(cache.cached(1) == 3u);
+
+        cache.deallocate_node(ptr, 1);
+        REQUIRE(cache.cached(1) == 4u);
+
+        std::vector<void*> ptrs;
+        for (auto i = 0u; i != 10u; ++i)
+            ptrs.push_back(cache.allocate_node(16));
+        std::sort(ptrs.begin(), ptrs.end());
+        REQUIRE(std::adjacent_find(ptrs.begin(), ptrs.end()) == ptrs.end());
+
+        for (auto p : ptrs)
+        {
+            cache.deallocate_node(p, 16);
+            REQUIRE(cache.cached(16) <= 8u);
+        }
+
+        auto capacity = collection.pool_capacity(16);
+        cache.flush();
+        REQUIRE(cache.cached(1) == 0u);
+        REQUIRE(cache.cached(16) == 0u);
+        REQUIRE(collection.pool_capacity(16) > capacity);
+    }
+    SECTION("cross cache deallocation")
+    {
+        cache_type a(depot), b(depot);
+        auto ptr = a.allocate_node(8);
+        b.deallocate_node(ptr, 8);
+        REQUIRE(b.cached(8) == 1u);
+    }
+    SECTION("multithreaded")
+    {
+        const auto no_threads = 4u, no_nodes = 500u;
+        std::atomic<bool> start(false);
+        std::vector<std::size_t> errors(no_threads, 0u);
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t != no_threads; ++t)
+            threads.emplace_back([&, t]
+            {
+                cache_type cache(depot, 16u);
+                while (!start)
+                    std::this_thread::yield();
+
+                std::vector<std::size_t*> ptrs;
+                for (auto round = 0u; round != 10u; ++round)
+                {
+                    for (auto i = 0u; i != no_nodes; ++i)
+                    {
+                        auto ptr = static_cast<std::size_t*>(cache.allocate_node(8 + i % 9));
+                        *ptr = t;
+                        ptrs.push_back(ptr);
+                    }
+                    for (auto ptr : ptrs)
+                        if (*ptr != t)
+                            ++errors[t];
+                    for (auto i = 0u; i != no_nodes; ++i)
+                        cache.deallocate_node(ptrs[i], 8 + i % 9);
+                    ptrs.clear();
+                }
+            });
+        start = true;
+        for (auto &thread : threads)
+            thread.join();
+
+        for (auto e : errors)
+            REQUIRE(e == 0u);
+    }
+}
+
+TEST_CASE("thread_cache", "[pool]")
+{
+    SECTION("identity_buckets")
+        test_thread_cache<identity_buckets>();
+    SECTION("log2_buckets")
+        test_thread_cache<log2_buckets>();
+    SECTION("size_class_buckets")
+        test_thread_cache<size_class_buckets>();
+    SECTION("static_buckets")
+        test_thread_cache<static_buckets<8, 12, 16>>();
+}
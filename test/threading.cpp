@@ -0,0 +1,100 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "threading.hpp"
+
+#include <catch.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "memory_pool.hpp"
+
+using namespace foonathan::memory;
+
+template <class Mutex>
+void test_mutex()
+{
+    Mutex mutex;
+    REQUIRE(mutex.try_lock());
+    // calling try_lock() on a std::mutex the thread already owns is undefined,
+    // so try it from another thread
+    auto try_lock_other = [&]
+    {
+        auto locked = false;
+        std::thread([&]
+        {
+            locked = mutex.try_lock();
+            if (locked)
+                mutex.unlock();
+        }).join();
+        return locked;
+    };
+    REQUIRE(!try_lock_other());
+    mutex.unlock();
+    REQUIRE(try_lock_other());
+
+    const auto no_threads = 4u, no_iterations = 10000u;
+    std::size_t counter = 0u;
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t != no_threads; ++t)
+        threads.emplace_back([&]
+        {
+            for (auto i = 0u; i != no_iterations; ++i)
+            {
+                std::lock_guard<Mutex> lock(mutex);
+                ++counter;
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+    REQUIRE(counter == no_threads * no_iterations);
+}
+
+template <class Mutex>
+void test_allocator_mutex()
+{
+    thread_safe_allocator<memory_pool<>, Mutex> alloc(memory_pool<>(16, 4096));
+
+    const auto no_threads = 4u, no_nodes = 1000u;
+    std::vector<std::size_t> errors(no_threads, 0u);
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t != no_threads; ++t)
+        threads.emplace_back([&, t]
+        {
+            std::vector<std::size_t*> ptrs;
+            for (auto i = 0u; i != no_nodes; ++i)
+            {
+                auto ptr = static_cast<std::size_t*>(alloc.allocate_node(16, 1));
+                *ptr = t;
+                ptrs.push_back(ptr);
+            }
+            for (auto ptr : ptrs)
+                if (*ptr != t)
+                    ++errors[t];
+            for (auto ptr : ptrs)
+                alloc.deallocate_node(ptr, 16, 1);
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    for (auto e : errors)
+        REQUIRE(e == 0u);
+
+    auto locked = alloc.lock();
+    REQUIRE(locked->capacity() >= 16u);
+}
+
+TEST_CASE("spin_mutex", "[threading]")
+{
+    test_mutex<spin_mutex>();
+    test_allocator_mutex<spin_mutex>();
+}
+
+TEST_CASE("adaptive_mutex", "[threading]")
+{
+    test_mutex<adaptive_mutex>();
+    test_allocator_mutex<adaptive_mutex>();
+}
@@ -0,0 +1,167 @@
+// Copyright (C) 2015 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <catch.hpp>
+#include <random>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "std_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("tlsf_allocator", "[tlsf]")
+{
+    using allocator_type = tlsf_allocator<allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        allocator_type tlsf(4096, alloc);
+        REQUIRE(tlsf.capacity() > 0u);
+        REQUIRE(tlsf.capacity() < 4096u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        auto capacity = tlsf.capacity();
+
+        SECTION("coalescing")
+        {
+            auto a = static_cast<char*>(tlsf.allocate_node(100, 1));
+            auto b = static_cast<char*>(tlsf.allocate_node(200, 1));
+            auto c = static_cast<char*>(tlsf.allocate_node(300, 1));
+            REQUIRE(a + 100 <= b);
+            REQUIRE(b + 200 <= c);
+            REQUIRE(tlsf.capacity() < capacity - 600u);
+
+            // middle first, so both neighbours have to be merged
+            tlsf.deallocate_node(b, 200, 1);
+            tlsf.deallocate_node(a, 100, 1);
+            tlsf.deallocate_node(c, 300, 1);
+            REQUIRE(tlsf.capacity() == capacity);
+
+            // everything is a single block again,
+            // the search rounds up to the next size class, so do not ask for all of it
+            auto d = tlsf.allocate_node(capacity - 256u, 1);
+            REQUIRE(d == a);
+            REQUIRE(alloc.no_allocated() == 1u);
+            tlsf.deallocate_node(d, capacity - 256u, 1);
+            REQUIRE(tlsf.capacity() == capacity);
+        }
+        SECTION("alignment")
+        {
+            auto a = tlsf.allocate_node(10, 1);
+            auto b = tlsf.allocate_node(10, 256);
+            REQUIRE(detail::is_aligned(b, 256));
+            auto c = tlsf.allocate_array(3, 100, 512);
+            REQUIRE(detail::is_aligned(c, 512));
+            auto d = tlsf.allocate_node(1, detail::max_alignment);
+            REQUIRE(detail::is_aligned(d, detail::max_alignment));
+
+            tlsf.deallocate_node(b, 10, 256);
+            tlsf.deallocate_array(c, 3, 100, 512);
+            tlsf.deallocate_node(a, 10, 1);
+            tlsf.deallocate_node(d, 1, detail::max_alignment);
+            REQUIRE(tlsf.capacity() == capacity);
+        }
+        SECTION("growth")
+        {
+            auto a = tlsf.allocate_node(capacity - 256u, 1);
+            REQUIRE(tlsf.capacity() < 1000u);
+            auto b = tlsf.allocate_node(1000, 1);
+            REQUIRE(alloc.no_allocated() == 2u);
+            REQUIRE(tlsf.owns(a));
+            REQUIRE(tlsf.owns(b));
+
+            tlsf.deallocate_node(b, 1000, 1);
+            tlsf.deallocate_node(a, capacity - 256u, 1);
+            REQUIRE(tlsf.capacity() > capacity);
+        }
+        SECTION("random sizes")
+        {
+            std::mt19937 rng;
+            std::uniform_int_distribution<std::size_t> dist(1u, 2000u);
+
+            struct allocation
+            {
+                char *memory;
+                std::size_t size;
+            };
+            std::vector<allocation> allocations;
+            for (auto i = 0u; i != 100u; ++i)
+            {
+                auto size = dist(rng);
+                auto mem = static_cast<char*>(tlsf.allocate_node(size, 1));
+                REQUIRE(tlsf.owns(mem));
+                allocations.push_back({mem, size});
+
+                // free some of them to get holes
+                if (i % 3u == 2u)
+                {
+                    auto index = std::uniform_int_distribution<std::size_t>(0u, allocations.size() - 1u)(rng);
+                    tlsf.deallocate_node(allocations[index].memory, allocations[index].size, 1);
+                    allocations.erase(allocations.begin() + index);
+                }
+            }
+
+            std::sort(allocations.begin(), allocations.end(),
+                      [](const allocation &a, const allocation &b) {return a.memory < b.memory;});
+            for (auto i = 1u; i < allocations.size(); ++i)
+                REQUIRE(allocations[i - 1].memory + allocations[i - 1].size <= allocations[i].memory);
+
+            std::shuffle(allocations.begin(), allocations.end(), rng);
+            for (auto &a : allocations)
+                tlsf.deallocate_node(a.memory, a.size, 1);
+            REQUIRE(tlsf.capacity() >= capacity);
+        }
+        SECTION("std_allocator")
+        {
+            std::vector<int, std_allocator<int, allocator_type>> vec(tlsf);
+            for (auto i = 0; i != 100; ++i)
+                vec.push_back(i);
+            REQUIRE(vec.size() == 100u);
+            REQUIRE(tlsf.owns(vec.data()));
+            vec.clear();
+            vec.shrink_to_fit();
+            REQUIRE(tlsf.capacity() == capacity);
+        }
+        SECTION("move")
+        {
+            auto ptr = tlsf.allocate_node(100, 1);
+            auto tlsf2 = detail::move(tlsf);
+            REQUIRE(tlsf.capacity() == 0u);
+            REQUIRE(tlsf2.capacity() < capacity);
+            tlsf2.deallocate_node(ptr, 100, 1);
+            REQUIRE(tlsf2.capacity() == capacity);
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("tlsf_allocator buffer", "[tlsf]")
+{
+    using allocator_type = tlsf_allocator<allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    char buffer[1024];
+
+    allocator_type tlsf(buffer, sizeof(buffer), alloc);
+    REQUIRE(tlsf.capacity() > 0u);
+    REQUIRE(tlsf.next_capacity() == 0u);
+    auto capacity = tlsf.capacity();
+
+    auto a = tlsf.allocate_node(100, 1);
+    REQUIRE(tlsf.owns(a));
+    REQUIRE(!tlsf.owns(&alloc));
+    tlsf.deallocate_node(a, 100, 1);
+    REQUIRE(tlsf.capacity() == capacity);
+    REQUIRE(alloc.no_allocated() == 0u);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    auto handler = out_of_memory::set_handler([](const allocator_info &, std::size_t) {});
+    REQUIRE_THROWS_AS(tlsf.allocate_node(capacity + 1u, 1), out_of_memory);
+    out_of_memory::set_handler(handler);
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(tlsf.capacity() == capacity);
+#endif
+}